@@ -0,0 +1,181 @@
+#ifndef _SCHEMA_JSON_ALLOCATOR_H_
+#define _SCHEMA_JSON_ALLOCATOR_H_
+
+#include <arrow/memory_pool.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace converter {
+
+/**
+ * @brief Memory pool new PoolAllocator allocations are taken from on the
+ * calling thread, arrow::default_memory_pool() outside of a MemoryPoolScope
+ */
+arrow::MemoryPool* CurrentMemoryPool();
+
+/**
+ * MemoryPoolScope makes a memory pool the current one of the calling thread
+ * for its lifetime, restoring the previous one on destruction
+ *
+ * mPrevious: pool that was current before the scope
+ */
+class MemoryPoolScope {
+public:
+    explicit MemoryPoolScope(arrow::MemoryPool* pool);
+    ~MemoryPoolScope();
+
+    MemoryPoolScope(const MemoryPoolScope&) = delete;
+    MemoryPoolScope& operator=(const MemoryPoolScope&) = delete;
+
+private:
+    arrow::MemoryPool* mPrevious{};
+};
+
+/**
+ * PoolAllocator is a stateless standard allocator taking its memory from
+ * CurrentMemoryPool(). Each allocation starts with a small header recording
+ * its pool, so memory is always returned to the pool it came from, whichever
+ * thread or scope releases it.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= kHeaderSize, "over-aligned type");
+        if (n > (std::numeric_limits<int64_t>::max() - kHeaderSize) /
+                    sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+
+        auto pool = CurrentMemoryPool();
+        uint8_t* data = nullptr;
+        auto status = pool->Allocate(
+            static_cast<int64_t>(n * sizeof(T) + kHeaderSize),
+            static_cast<int64_t>(kHeaderSize),
+            &data);
+        if (!status.ok()) {
+            throw std::bad_alloc();
+        }
+        *reinterpret_cast<arrow::MemoryPool**>(data) = pool;
+        return reinterpret_cast<T*>(data + kHeaderSize);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        auto data = reinterpret_cast<uint8_t*>(ptr) - kHeaderSize;
+        auto pool = *reinterpret_cast<arrow::MemoryPool**>(data);
+        pool->Free(data,
+                   static_cast<int64_t>(n * sizeof(T) + kHeaderSize),
+                   static_cast<int64_t>(kHeaderSize));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+/**
+ * PoolJSON is a nlohmann::json whose values, arrays, objects (and their
+ * nodes) are allocated through PoolAllocator. Strings stay std::string, as
+ * nlohmann::json 3.10 requires: their characters only reach the global heap
+ * when they are too long for the small string buffer
+ */
+using PoolJSON = nlohmann::basic_json<std::map,
+                                      std::vector,
+                                      std::string,
+                                      bool,
+                                      std::int64_t,
+                                      std::uint64_t,
+                                      double,
+                                      PoolAllocator>;
+
+/**
+ * ArenaMemoryPool hands out memory from large blocks taken from a parent
+ * pool. Free() only updates the counters, the blocks go back to the parent
+ * all at once on Reset() or destruction, so a whole conversion is released
+ * without returning its nodes one by one. Thread-safe.
+ *
+ * mParent: pool the blocks are taken from
+ * mBlockSize: minimum size of a block
+ * mBlocks: blocks taken so far, with their sizes
+ * mOffset: bytes used in the last block
+ * mBytesAllocated: bytes handed out and not freed yet
+ * mMaxMemory: peak of mBytesAllocated
+ * mTotalBytesAllocated: bytes handed out since construction
+ * mNumAllocations: allocations since construction
+ */
+class ArenaMemoryPool : public arrow::MemoryPool {
+public:
+    static constexpr int64_t kDefaultBlockSize = 64 * 1024;
+
+    explicit ArenaMemoryPool(
+        arrow::MemoryPool* parent = arrow::default_memory_pool(),
+        int64_t blockSize = kDefaultBlockSize);
+    ~ArenaMemoryPool() override;
+
+    ArenaMemoryPool(const ArenaMemoryPool&) = delete;
+    ArenaMemoryPool& operator=(const ArenaMemoryPool&) = delete;
+
+    using arrow::MemoryPool::Allocate;
+    using arrow::MemoryPool::Free;
+    using arrow::MemoryPool::Reallocate;
+
+    arrow::Status Allocate(int64_t size,
+                           int64_t alignment,
+                           uint8_t** out) override;
+    arrow::Status Reallocate(int64_t oldSize,
+                             int64_t newSize,
+                             int64_t alignment,
+                             uint8_t** ptr) override;
+    void Free(uint8_t* buffer, int64_t size, int64_t alignment) override;
+
+    /**
+     * @brief Return every block to the parent pool. Memory handed out before
+     * must not be used anymore
+     */
+    void Reset();
+
+    int64_t bytes_allocated() const override;
+    int64_t max_memory() const override;
+    int64_t total_bytes_allocated() const override;
+    int64_t num_allocations() const override;
+    std::string backend_name() const override;
+
+private:
+    arrow::MemoryPool* mParent{};
+    int64_t mBlockSize{};
+    std::mutex mMutex{};
+    std::vector<std::pair<uint8_t*, int64_t>> mBlocks{};
+    int64_t mOffset{};
+    std::atomic<int64_t> mBytesAllocated{};
+    std::atomic<int64_t> mMaxMemory{};
+    std::atomic<int64_t> mTotalBytesAllocated{};
+    std::atomic<int64_t> mNumAllocations{};
+};
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_ALLOCATOR_H_
@@ -0,0 +1,156 @@
+#ifndef _SCHEMA_JSON_CACHE_H_
+#define _SCHEMA_JSON_CACHE_H_
+
+#include <arrow/type.h>
+
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+
+#include "Schema_JSON_Conversion.h"
+
+namespace converter {
+
+/**
+ * Counters of a conversion cache
+ *
+ * hits: lookups answered from the cache
+ * misses: lookups that had to convert the schema
+ * evictions: entries dropped to stay within capacity
+ * size: number of entries currently cached
+ */
+struct CacheStats {
+    uint64_t hits{};
+    uint64_t misses{};
+    uint64_t evictions{};
+    size_t size{};
+
+    /**
+     * @brief Share of the lookups answered from the cache, 0 if none was made
+     */
+    double HitRate() const {
+        auto lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+};
+
+/**
+ * SchemaJSONCache memoizes SchemaToJSON/SchemaToJSONString results, keyed by
+ * arrow::Schema::fingerprint() plus metadata_fingerprint(). Results are shared
+ * and immutable, so a hit costs one lookup and no conversion.
+ *
+ * The cache is bounded (least recently used entries are evicted) and
+ * thread-safe: entries are spread over independently locked shards. Schemas
+ * without a fingerprint (e.g. holding extension types) are converted on every
+ * call and never cached.
+ *
+ * @example
+ * converter::SchemaJSONCache cache{ 512 };
+ * auto result = cache.SchemaToJSONString(schema);
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * const std::string& jsonText = *result.ValueOrDie();
+ */
+class SchemaJSONCache {
+public:
+    /**
+     * @param[in] capacity Maximum number of cached results
+     * @param[in] numShards Number of independently locked shards
+     */
+    explicit SchemaJSONCache(size_t capacity = 1024, size_t numShards = 16);
+    ~SchemaJSONCache();
+
+    SchemaJSONCache(const SchemaJSONCache&) = delete;
+    SchemaJSONCache& operator=(const SchemaJSONCache&) = delete;
+
+    /**
+     * @brief Cached equivalent of converter::SchemaToJSON
+     */
+    arrow::Result<std::shared_ptr<const nlohmann::json>> SchemaToJSON(
+        const std::shared_ptr<arrow::Schema>& schema);
+
+    /**
+     * @brief Cached equivalent of converter::SchemaToJSONString
+     */
+    arrow::Result<std::shared_ptr<const std::string>> SchemaToJSONString(
+        const std::shared_ptr<arrow::Schema>& schema);
+
+    /**
+     * @brief Drop the cached results of a schema (both forms)
+     */
+    void Invalidate(const std::shared_ptr<arrow::Schema>& schema);
+
+    /**
+     * @brief Drop all cached results. Counters are kept
+     */
+    void Clear();
+
+    CacheStats Stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+/**
+ * SchemaDecodeCache memoizes JSONTextToSchema results, keyed by the
+ * std::hash<std::string_view> of the raw text (64 bits wide on 64-bit
+ * platforms). A lookup hashes the bytes and compares them with the text the
+ * cached schema was decoded from: a hit skips the parsing entirely and returns
+ * the shared arrow::Schema.
+ *
+ * The cache is bounded (least recently used entries are evicted) and
+ * thread-safe: entries are spread over independently locked shards, and the
+ * text comparison runs outside of the lock. Malformed documents are not
+ * cached, each lookup reports the error again.
+ *
+ * @example
+ * converter::SchemaDecodeCache cache{ 256 };
+ * for (const auto& batch : batches) {
+ *      auto result = cache.JSONTextToSchema(batch.schemaText);
+ *      if (!result.ok()) {
+ *          std::cout << "error\n";
+ *          return;
+ *      }
+ *      process(result.ValueOrDie(), batch);
+ * }
+ */
+class SchemaDecodeCache {
+public:
+    /**
+     * @param[in] capacity Maximum number of cached schemas
+     * @param[in] numShards Number of independently locked shards
+     * @param[in] options Options of the decodings made on a miss
+     */
+    explicit SchemaDecodeCache(size_t capacity = 1024,
+                               size_t numShards = 16,
+                               const JSONToSchemaOptions& options = {});
+    ~SchemaDecodeCache();
+
+    SchemaDecodeCache(const SchemaDecodeCache&) = delete;
+    SchemaDecodeCache& operator=(const SchemaDecodeCache&) = delete;
+
+    /**
+     * @brief Cached equivalent of converter::JSONTextToSchema
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> JSONTextToSchema(
+        std::string_view text);
+
+    /**
+     * @brief Drop all cached schemas. Counters are kept
+     */
+    void Clear();
+
+    CacheStats Stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_CACHE_H_
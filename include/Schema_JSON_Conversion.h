@@ -1,15 +1,91 @@
 #ifndef _SCHEMA_JSON_CONVERSION_H_
 #define _SCHEMA_JSON_CONVERSION_H_
 
+#include <arrow/io/type_fwd.h>
 #include <arrow/type.h>
+#include <arrow/util/type_fwd.h>
 
+#include <cstdint>
 #include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Schema_JSON_Allocator.h"
 
 namespace converter {
 
+class TypeInterner;
+
+/**
+ * Options of the arrow::Schema to JSON conversion
+ *
+ * useThreads: marshal wide field lists (top-level fields, or the children of a
+ * struct) in parallel. Output is identical to the serial conversion
+ * parallelThreshold: minimum number of fields in a list for it to be split
+ * across threads, narrower lists are marshalled on the calling thread
+ * executor: executor running the tasks, arrow's CPU thread pool if null
+ */
+struct SchemaToJSONOptions {
+    bool useThreads{ false };
+    int parallelThreshold{ 4096 };
+    arrow::internal::Executor* executor{ nullptr };
+};
+
+/**
+ * Options of the JSON to arrow::Schema conversion
+ *
+ * interner: interning table the decoded types are looked up in, so equal
+ * types share one instance across all schemas decoded with it. Types are not
+ * interned if null. Must outlive the call
+ * useThreads: convert the top-level fields of wide json objects in parallel
+ * (JSONToSchema only). Output and errors are identical to the serial
+ * conversion
+ * parallelThreshold: minimum number of top-level fields for them to be split
+ * across threads
+ * executor: executor running the tasks, arrow's CPU thread pool if null
+ */
+struct JSONToSchemaOptions {
+    TypeInterner* interner{ nullptr };
+    bool useThreads{ false };
+    int parallelThreshold{ 4096 };
+    arrow::internal::Executor* executor{ nullptr };
+};
+
+/**
+ * Fields to keep when converting Json to arrow::Schema
+ *
+ * paths: selected fields. A path is a top-level field name, or a dotted path
+ * into a nested field: a struct child by its name, the element of a list by
+ * its name ("item" by default), the key or item of a map by "key" or "item".
+ * A selected field is kept whole. Its ancestors are kept with only the
+ * selected children, in schema order, except that a map always keeps both
+ * its key and item. Paths matching no field select nothing.
+ *
+ * e.g. { "id", "address.city", "tags.item", "attributes.item.value" }
+ */
+struct ProjectionSpec {
+    std::vector<std::string> paths{};
+};
+
+/**
+ * Options of the batch conversions
+ *
+ * fieldsPerTask: number of fields converted by one task. Schemas wider than
+ * this are split, so that a huge schema is spread over all workers
+ * executor: executor running the workers, arrow's CPU thread pool if null
+ * interner: interning table of the decoded types, see JSONToSchemaOptions
+ */
+struct BatchOptions {
+    int fieldsPerTask{ 1024 };
+    arrow::internal::Executor* executor{ nullptr };
+    TypeInterner* interner{ nullptr };
+};
+
 /**
  * @brief Convert arrow::Schema to Json
  * @param[in] schema Input schema
+ * @param[in] options Conversion options
  * @return arrow::Result contains the converted json if successful, descriptive
  * status otherwise
  *
@@ -22,13 +98,152 @@ namespace converter {
  * auto convertedJson = result.ValueOrDie();
  */
 arrow::Result<nlohmann::json> SchemaToJSON(
-    const std::shared_ptr<arrow::Schema>& schema);
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options = {});
+
+/**
+ * @brief Convert arrow::Schema to Json allocated from a memory pool. Every
+ * node of the result is taken from the pool (so it is accounted for in
+ * pool->bytes_allocated()) and returned to it when released. Passing an
+ * ArenaMemoryPool lets the whole result be dropped with one Reset()
+ * @param[in] schema Input schema
+ * @param[in] pool Memory pool, arrow::default_memory_pool() if null
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the converted json if successful, descriptive
+ * status otherwise
+ *
+ * @example
+ * converter::ArenaMemoryPool arena{};
+ * {
+ *      auto result = SchemaToPoolJSON(schema, &arena);
+ *      ...
+ * }
+ * arena.Reset();
+ */
+arrow::Result<PoolJSON> SchemaToPoolJSON(
+    const std::shared_ptr<arrow::Schema>& schema,
+    arrow::MemoryPool* pool,
+    const SchemaToJSONOptions& options = {});
+
+/**
+ * @brief Convert arrow::Schema to JSON text without building a nlohmann::json
+ * object first. The output is byte-identical to SchemaToJSON(schema)->dump()
+ * @param[in] schema Input schema
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the JSON text if successful, descriptive
+ * status otherwise
+ *
+ * @example
+ * auto result = SchemaToJSONString(schema);
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * auto jsonText = result.ValueOrDie();
+ */
+arrow::Result<std::string> SchemaToJSONString(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options = {});
+
+/**
+ * @brief Write arrow::Schema as JSON text into an output stream. Same output
+ * as SchemaToJSONString, but written in chunks so the whole text is never held
+ * in memory. On error, the bytes already flushed are left in the sink
+ * @param[in] schema Input schema
+ * @param[in] sink Output stream, must outlive the call
+ * @param[in] options Conversion options
+ * @return arrow::Status OK if successful, descriptive status otherwise
+ *
+ * @example
+ * auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+ * auto status = SchemaToJSONStream(schema, sink.get());
+ */
+arrow::Status SchemaToJSONStream(const std::shared_ptr<arrow::Schema>& schema,
+                                 arrow::io::OutputStream* sink,
+                                 const SchemaToJSONOptions& options = {});
+
+/**
+ * @brief Write arrow::Schema as JSON text into a file, created or truncated.
+ * Same output as SchemaToJSONString, streamed like SchemaToJSONStream. On
+ * error, the file is left with the bytes already flushed
+ * @param[in] schema Input schema
+ * @param[in] path Path of the output file
+ * @param[in] options Conversion options
+ * @return arrow::Status OK if successful, descriptive status otherwise
+ * (IOError if the file cannot be written)
+ *
+ * @example
+ * auto status = SchemaToJSONFile(schema, "schema.json");
+ */
+arrow::Status SchemaToJSONFile(const std::shared_ptr<arrow::Schema>& schema,
+                               const std::string& path,
+                               const SchemaToJSONOptions& options = {});
+
+/**
+ * @brief Convert arrow::Schema to CBOR (RFC 8949), with the same layout as
+ * SchemaToJSON. The bytes are encoded directly, without building a
+ * nlohmann::json object, and are identical to
+ * nlohmann::json::to_cbor(SchemaToJSON(schema))
+ * @param[in] schema Input schema
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the encoded bytes if successful, descriptive
+ * status otherwise
+ *
+ * @example
+ * auto result = SchemaToCBOR(schema);
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * auto bytes = result.ValueOrDie();
+ */
+arrow::Result<std::vector<uint8_t>> SchemaToCBOR(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options = {});
+
+/**
+ * @brief Convert arrow::Schema to MessagePack, with the same layout as
+ * SchemaToJSON. The bytes are encoded directly, without building a
+ * nlohmann::json object, and are identical to
+ * nlohmann::json::to_msgpack(SchemaToJSON(schema))
+ * @param[in] schema Input schema
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the encoded bytes if successful, descriptive
+ * status otherwise
+ */
+arrow::Result<std::vector<uint8_t>> SchemaToMsgPack(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options = {});
+
+/**
+ * @brief Convert many arrow::Schema to Json at once. The schemas are cut into
+ * field ranges which idle workers pick up as they go, so small and huge
+ * schemas keep every core busy. Each result is the same as SchemaToJSON's
+ * @param[in] schemas Input schemas
+ * @param[in] options Batch options
+ * @return One result per input schema, in input order
+ *
+ * @example
+ * auto results = SchemaToJSONBatch(schemas);
+ * for (size_t i = 0; i < results.size(); i++) {
+ *      if (!results[i].ok()) {
+ *          std::cout << "schema " << i << ": " << results[i].status() << "\n";
+ *      }
+ * }
+ */
+std::vector<arrow::Result<nlohmann::json>> SchemaToJSONBatch(
+    const std::vector<std::shared_ptr<arrow::Schema>>& schemas,
+    const BatchOptions& options = {});
 
 /**
  * @brief Convert Json to arrow::Schema
  * @param[in] jsonObj Input json object
+ * @param[in] options Conversion options
  * @return arrow::Result contains the converted arrow::Schema if successful,
- * descriptive status otherwise
+ * descriptive status otherwise. A malformed document fails with Invalid
+ * naming the JSON pointer of the offending value, e.g.
+ * "/schema/fields/3/type/bitWidth: expected an integer"; nothing is thrown.
+ * Integer type parameters must be json integers which fit in an int
  *
  * @example
  * auto result = JSONToSchema(jsonObj);
@@ -39,7 +254,184 @@ arrow::Result<nlohmann::json> SchemaToJSON(
  * auto convertedSchema = result.ValueOrDie();
  */
 arrow::Result<std::shared_ptr<arrow::Schema>> JSONToSchema(
-    const nlohmann::json& jsonObj);
+    const nlohmann::json& jsonObj,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Convert the projected fields of a Json document to arrow::Schema.
+ * Subtrees which are not selected are skipped without being converted
+ * @param[in] jsonObj Input json object
+ * @param[in] projection Fields to keep
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the pruned arrow::Schema if successful,
+ * descriptive status otherwise (Invalid if a path has an empty name)
+ *
+ * @example
+ * auto result = JSONToSchema(jsonObj, ProjectionSpec{ { "id", "a.b" } });
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * auto prunedSchema = result.ValueOrDie();
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> JSONToSchema(
+    const nlohmann::json& jsonObj,
+    const ProjectionSpec& projection,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Convert pool-allocated Json to arrow::Schema
+ * @param[in] jsonObj Input json object
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> JSONToSchema(
+    const PoolJSON& jsonObj,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Convert Json text to arrow::Schema without building a json DOM: the
+ * fields are built while the text is parsed, so only the fields still open
+ * are held in memory. Accepts the same documents as JSONToSchema
+ * @param[in] text Input json text
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise (Invalid if the text is malformed)
+ *
+ * @example
+ * auto result = JSONTextToSchema(jsonText);
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * auto convertedSchema = result.ValueOrDie();
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> JSONTextToSchema(
+    std::string_view text,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Convert a Json file to arrow::Schema, decoded like JSONTextToSchema.
+ * Files of 64 KiB and more are memory-mapped for sequential access and
+ * decoded in place. Smaller ones are read into a buffer reused by the calling
+ * thread, which is cheaper than mapping them
+ * @param[in] path Path of the input file
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise (IOError if the file cannot be mapped,
+ * Invalid if the text is malformed)
+ *
+ * @example
+ * auto result = JSONFileToSchema("schema.json");
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * auto convertedSchema = result.ValueOrDie();
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> JSONFileToSchema(
+    const std::string& path,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Check a Json document the way JSONToSchema decodes it (known type
+ * names, supported bit width, precision and unit combinations, children of
+ * lists, maps and structs, shape of the metadata) without building any arrow
+ * object. A document is valid exactly when JSONToSchema accepts it
+ * @param[in] jsonObj Input json object
+ * @param[out] errors Every error found, each naming the JSON pointer of the
+ * offending value. nullptr to stop at the first one
+ * @return OK if the document is valid, the first error otherwise (the one
+ * JSONToSchema returns)
+ *
+ * @example
+ * std::vector<arrow::Status> errors{};
+ * if (!ValidateSchemaJSON(jsonObj, &errors).ok()) {
+ *      for (const auto& error : errors) {
+ *          std::cout << error.message() << "\n";
+ *      }
+ * }
+ */
+arrow::Status ValidateSchemaJSON(const nlohmann::json& jsonObj,
+                                 std::vector<arrow::Status>* errors = nullptr);
+
+/**
+ * @brief Check Json text the way JSONTextToSchema decodes it, while parsing
+ * and without a DOM. Only a failing text is parsed to a DOM, which
+ * ValidateSchemaJSON then checks: its verdict stands and its errors name
+ * their paths. Named apart from
+ * ValidateSchemaJSON as strings convert to both json and string_view
+ * @param[in] text Input json text
+ * @param[out] errors See ValidateSchemaJSON. Malformed text gives a single
+ * parse error
+ * @return OK if the document is valid, the first error otherwise
+ */
+arrow::Status ValidateSchemaJSONText(
+    std::string_view text,
+    std::vector<arrow::Status>* errors = nullptr);
+
+/**
+ * @brief Convert Json text to arrow::Schema with the simdjson On-Demand
+ * parser. Accepts the same documents and gives the same schemas as
+ * JSONTextToSchema, several times faster on large documents. Fields nested
+ * more than 64 levels deep are handed over to JSONTextToSchema. Only
+ * available if the library is built with SCHEMA_JSON_WITH_SIMDJSON=ON
+ * @param[in] text Input json text
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise (Invalid if the text is malformed,
+ * NotImplemented if the library is built without simdjson)
+ *
+ * @note Members the schema does not use are skipped without checking their
+ * values, malformed numbers or literals in them are not reported
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> SimdJSONTextToSchema(
+    std::string_view text,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Convert CBOR produced by SchemaToCBOR to arrow::Schema
+ * @param[in] data Encoded bytes
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise (Invalid if the bytes are not valid CBOR)
+ *
+ * @example
+ * auto result = CBORToSchema(bytes);
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * auto convertedSchema = result.ValueOrDie();
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> CBORToSchema(
+    const std::vector<uint8_t>& data,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Convert MessagePack produced by SchemaToMsgPack to arrow::Schema
+ * @param[in] data Encoded bytes
+ * @param[in] options Conversion options
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise (Invalid if the bytes are not valid
+ * MessagePack)
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> MsgPackToSchema(
+    const std::vector<uint8_t>& data,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Convert many Json documents to arrow::Schema at once, scheduled like
+ * SchemaToJSONBatch. Malformed documents fail with Invalid instead of
+ * throwing, without affecting the other items
+ * @param[in] jsonObjs Input json objects, must outlive the call
+ * @param[in] options Batch options
+ * @return One result per input document, in input order
+ */
+std::vector<arrow::Result<std::shared_ptr<arrow::Schema>>> JSONToSchemaBatch(
+    const std::vector<const nlohmann::json*>& jsonObjs,
+    const BatchOptions& options = {});
 
 } // namespace converter
 
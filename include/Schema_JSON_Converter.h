@@ -0,0 +1,111 @@
+#ifndef _SCHEMA_JSON_CONVERTER_H_
+#define _SCHEMA_JSON_CONVERTER_H_
+
+#include <arrow/io/type_fwd.h>
+#include <arrow/type.h>
+
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string_view>
+
+#include "Schema_JSON_Conversion.h"
+
+namespace converter {
+
+/**
+ * Converter is a conversion session: it keeps its options together with the
+ * work stacks, scratch vectors and output buffer of the free functions in
+ * Schema_JSON_Conversion.h alive from one call to the next. Once it has seen
+ * a schema of a given shape, converting it again only allocates the result
+ * itself (and nothing at all for SchemaToJSONString).
+ *
+ * A Converter is not thread-safe, use one per thread.
+ *
+ * @example
+ * converter::Converter session{};
+ * for (const auto& schema : schemas) {
+ *      auto result = session.SchemaToJSONString(schema);
+ *      if (!result.ok()) {
+ *          std::cout << "error\n";
+ *          return;
+ *      }
+ *      send(result.ValueOrDie()); // valid until the next call
+ * }
+ */
+class Converter {
+public:
+    explicit Converter(const SchemaToJSONOptions& options = {},
+                       const JSONToSchemaOptions& decodeOptions = {});
+    ~Converter();
+
+    Converter(Converter&&) noexcept = default;
+    Converter& operator=(Converter&&) noexcept = default;
+
+    Converter(const Converter&) = delete;
+    Converter& operator=(const Converter&) = delete;
+
+    const SchemaToJSONOptions& options() const { return mOptions; }
+    const JSONToSchemaOptions& decodeOptions() const {
+        return mDecodeOptions;
+    }
+
+    /**
+     * @brief Session equivalent of converter::SchemaToJSON
+     */
+    arrow::Result<nlohmann::json> SchemaToJSON(
+        const std::shared_ptr<arrow::Schema>& schema);
+
+    /**
+     * @brief Session equivalent of converter::SchemaToJSONString. The text is
+     * written into the session's buffer
+     * @return arrow::Result contains a view of the text, valid until the next
+     * call on this Converter, descriptive status otherwise
+     */
+    arrow::Result<std::string_view> SchemaToJSONString(
+        const std::shared_ptr<arrow::Schema>& schema);
+
+    /**
+     * @brief Session equivalent of converter::SchemaToJSONStream, reusing the
+     * session's buffer between flushes
+     */
+    arrow::Status SchemaToJSONStream(
+        const std::shared_ptr<arrow::Schema>& schema,
+        arrow::io::OutputStream* sink);
+
+    /**
+     * @brief Session equivalent of converter::JSONToSchema
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> JSONToSchema(
+        const nlohmann::json& jsonObj);
+
+    /**
+     * @brief Session equivalent of converter::JSONTextToSchema
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> JSONTextToSchema(
+        std::string_view text);
+
+private:
+    // Scratch storage of each direction, defined next to the traversal using
+    // it and created on first use
+    struct EncodeState;
+    struct DecodeState;
+
+    struct EncodeStateDeleter {
+        void operator()(EncodeState* state) const;
+    };
+    struct DecodeStateDeleter {
+        void operator()(DecodeState* state) const;
+    };
+
+    EncodeState& encodeState();
+    DecodeState& decodeState();
+
+    SchemaToJSONOptions mOptions{};
+    JSONToSchemaOptions mDecodeOptions{};
+    std::unique_ptr<EncodeState, EncodeStateDeleter> mEncode{};
+    std::unique_ptr<DecodeState, DecodeStateDeleter> mDecode{};
+};
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_CONVERTER_H_
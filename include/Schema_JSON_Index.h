@@ -0,0 +1,187 @@
+#ifndef _SCHEMA_JSON_INDEX_H_
+#define _SCHEMA_JSON_INDEX_H_
+
+#include <arrow/result.h>
+#include <arrow/type.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Schema_JSON_Conversion.h"
+
+namespace converter {
+
+/**
+ * Options of BuildSchemaIndex
+ *
+ * nestedDepth: levels of nested fields indexed below the top-level ones, 0 to
+ * index the top-level fields only, negative to index every level
+ */
+struct SchemaIndexOptions {
+    int nestedDepth{ 0 };
+};
+
+/**
+ * SchemaIndexEntry locates the json object of a field in a schema text
+ *
+ * path: path of the field as in ProjectionSpec, i.e. the names from the
+ * top-level field down, "key" and "item" standing for the members of a map
+ * parent: entry of the enclosing field, -1 for a top-level field
+ * position: index of the field in the "fields" array for a top-level field,
+ * in the "children" array of its parent otherwise
+ * offset: byte offset of the object in the text
+ * length: byte length of the object
+ */
+struct SchemaIndexEntry {
+    std::string path{};
+    int64_t parent{ -1 };
+    uint64_t position{};
+    uint64_t offset{};
+    uint64_t length{};
+};
+
+class SchemaIndex;
+
+/**
+ * @brief Locate the fields of a schema document in one pass over its text,
+ * without decoding them. The scan only follows the json structure: the
+ * fields are checked when decoded through the index
+ * @param[in] text Input schema json text
+ * @param[in] options Indexing options
+ * @return arrow::Result contains the index if the text is a json object with
+ * a "schema" object and a "fields" array, descriptive status otherwise
+ *
+ * @example
+ * auto index = BuildSchemaIndex(text).ValueOrDie();
+ * WriteSchemaIndex(index, "schema.json.idx");
+ * ...
+ * auto index = ReadSchemaIndex("schema.json.idx").ValueOrDie();
+ * auto price = JSONTextToField(text, index, "price").ValueOrDie();
+ */
+arrow::Result<SchemaIndex> BuildSchemaIndex(
+    std::string_view text,
+    const SchemaIndexOptions& options = {});
+
+/**
+ * SchemaIndex maps the fields of a schema json text to the byte ranges of
+ * their objects, so that a few of them can be decoded without parsing the
+ * rest of the text. It is built once with BuildSchemaIndex() and can be
+ * persisted next to the text with Serialize() or WriteSchemaIndex().
+ *
+ * The index remembers the size of the text it was built from and the
+ * decoders reject a text of another size. A text edited in place keeping its
+ * size is not detected: rebuild the index whenever the text changes.
+ */
+class SchemaIndex {
+public:
+    SchemaIndex() = default;
+
+    /**
+     * @brief Size of the indexed text in bytes
+     */
+    uint64_t TextSize() const { return mTextSize; }
+
+    /**
+     * @brief Byte range of the "metadata" array of the schema, of length 0 if
+     * the schema has none
+     */
+    uint64_t MetadataOffset() const { return mMetadataOffset; }
+    uint64_t MetadataLength() const { return mMetadataLength; }
+
+    /**
+     * @brief Indexed fields in document order, a field before its children
+     */
+    const std::vector<SchemaIndexEntry>& Entries() const { return mEntries; }
+
+    /**
+     * @brief Look up a field by path
+     * @return Index of the first entry with this path, -1 if none
+     */
+    int Find(std::string_view path) const;
+
+    /**
+     * @brief Look up the fields sharing a path, e.g. top-level fields with the
+     * same name
+     * @return Indexes of the entries with this path, in document order
+     */
+    std::vector<int> FindAll(std::string_view path) const;
+
+    /**
+     * @brief Encode the index in its compact binary form
+     */
+    std::string Serialize() const;
+
+    /**
+     * @brief Decode an index encoded by Serialize()
+     * @return arrow::Result contains the index if the data is well formed,
+     * descriptive status otherwise
+     */
+    static arrow::Result<SchemaIndex> Deserialize(std::string_view data);
+
+private:
+    friend arrow::Result<SchemaIndex> BuildSchemaIndex(
+        std::string_view text,
+        const SchemaIndexOptions& options);
+
+    void sortPaths();
+
+    uint64_t mTextSize{};
+    uint64_t mMetadataOffset{};
+    uint64_t mMetadataLength{};
+    std::vector<SchemaIndexEntry> mEntries{};
+    // entries by path, then by position in mEntries
+    std::vector<int> mByPath{};
+};
+
+/**
+ * @brief Write an index to a file, e.g. next to the text it indexes
+ * @return OK if the index is written, descriptive status otherwise
+ */
+arrow::Status WriteSchemaIndex(const SchemaIndex& index,
+                               const std::string& path);
+
+/**
+ * @brief Read an index written by WriteSchemaIndex()
+ * @return arrow::Result contains the index if the file is readable and well
+ * formed, descriptive status otherwise
+ */
+arrow::Result<SchemaIndex> ReadSchemaIndex(const std::string& path);
+
+/**
+ * @brief Decode a single field of a schema text, parsing only its object
+ * @param[in] text Input schema json text, the one the index was built from
+ * @param[in] index Index of the text
+ * @param[in] path Path of the field, it must be indexed
+ * @param[in] options Decoding options, only the interner is used
+ * @return arrow::Result contains the converted arrow::Field if successful,
+ * descriptive status otherwise
+ */
+arrow::Result<std::shared_ptr<arrow::Field>> JSONTextToField(
+    std::string_view text,
+    const SchemaIndex& index,
+    std::string_view path,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * @brief Decode the fields of a schema text selected by a projection, parsing
+ * only the objects of the selected top-level fields and the schema metadata.
+ * The result is the one of JSONToSchema with the same projection
+ * @param[in] text Input schema json text, the one the index was built from
+ * @param[in] index Index of the text
+ * @param[in] projection Paths of the fields to keep
+ * @param[in] options Decoding options, only the interner is used
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> JSONTextToSchema(
+    std::string_view text,
+    const SchemaIndex& index,
+    const ProjectionSpec& projection,
+    const JSONToSchemaOptions& options = {});
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_INDEX_H_
@@ -0,0 +1,109 @@
+#ifndef _SCHEMA_JSON_LAZY_SCHEMA_H_
+#define _SCHEMA_JSON_LAZY_SCHEMA_H_
+
+#include <arrow/type.h>
+
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string_view>
+
+#include "Schema_JSON_Conversion.h"
+
+namespace converter {
+
+class LazySchema;
+
+/**
+ * @brief Index the fields of a json document without converting them. Each
+ * arrow::Field is built on first access, so the cost of a decoding follows
+ * the columns actually used instead of the width of the schema
+ * @param[in] jsonObj Input json object, shared with the result
+ * @param[in] options Options of the field conversions
+ * @return arrow::Result contains the LazySchema if the document has a fields
+ * array of named fields, descriptive status otherwise
+ *
+ * @example
+ * auto jsonObj = std::make_shared<const nlohmann::json>(json::parse(text));
+ * auto result = JSONToLazySchema(jsonObj);
+ * if (!result.ok()) {
+ *      std::cout << "error\n";
+ *      return;
+ * }
+ * auto lazySchema = result.ValueOrDie();
+ * auto price = lazySchema->GetFieldByName("price");
+ */
+arrow::Result<std::shared_ptr<LazySchema>> JSONToLazySchema(
+    std::shared_ptr<const nlohmann::json> jsonObj,
+    const JSONToSchemaOptions& options = {});
+
+/**
+ * LazySchema is an arrow::Schema whose fields are converted from json on
+ * first access, by index or by name, and cached from then on. Names are
+ * indexed up front, so looking one up converts nothing.
+ *
+ * Accessors are thread-safe: concurrent first accesses to a field convert it
+ * once and all callers get the same instance. A field that fails to convert
+ * reports the same status on every access.
+ */
+class LazySchema {
+public:
+    ~LazySchema();
+
+    LazySchema(const LazySchema&) = delete;
+    LazySchema& operator=(const LazySchema&) = delete;
+
+    int NumFields() const;
+
+    /**
+     * @brief Name of a field, without converting it
+     * @param[in] index Field index, must be in [0, NumFields())
+     */
+    std::string_view FieldName(int index) const;
+
+    /**
+     * @brief Index of the field with this name, without converting it
+     * @return The index, -1 if there is no such field or several of them
+     */
+    int GetFieldIndex(std::string_view name) const;
+
+    /**
+     * @brief Field at an index, converted on first access
+     * @return arrow::Result contains the arrow::Field if successful,
+     * descriptive status otherwise (also if index is out of range)
+     */
+    arrow::Result<std::shared_ptr<arrow::Field>> Field(int index);
+
+    /**
+     * @brief Field with this name, converted on first access
+     * @return arrow::Result contains the arrow::Field if successful,
+     * descriptive status otherwise (also if the name is unknown or ambiguous)
+     */
+    arrow::Result<std::shared_ptr<arrow::Field>> GetFieldByName(
+        std::string_view name);
+
+    /**
+     * @brief Convert the remaining fields and build the whole schema, the
+     * same as JSONToSchema would. The result is cached
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> ToSchema();
+
+    /**
+     * @brief Number of fields converted so far
+     */
+    int NumMaterialized() const;
+
+private:
+    class Impl;
+
+    explicit LazySchema(std::unique_ptr<Impl> impl);
+
+    friend arrow::Result<std::shared_ptr<LazySchema>> JSONToLazySchema(
+        std::shared_ptr<const nlohmann::json> jsonObj,
+        const JSONToSchemaOptions& options);
+
+    std::unique_ptr<Impl> mImpl;
+};
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_LAZY_SCHEMA_H_
@@ -0,0 +1,80 @@
+#ifndef _SCHEMA_JSON_PUSH_DECODER_H_
+#define _SCHEMA_JSON_PUSH_DECODER_H_
+
+#include <arrow/result.h>
+#include <arrow/type.h>
+
+#include <memory>
+#include <string_view>
+
+#include "Schema_JSON_Conversion.h"
+
+namespace converter {
+
+/**
+ * SchemaPushDecoder decodes a schema document handed over in chunks, e.g. as
+ * it comes off a socket, without buffering the whole text. Chunks may be split
+ * anywhere. Parsing resumes where the previous chunk stopped, and every field
+ * is converted to an arrow::Field as soon as its object is complete, so the
+ * decoding overlaps with the receiving and only the fields still open are
+ * held in memory.
+ *
+ * It accepts the same documents as JSONTextToSchema. Once a chunk fails, the
+ * decoder reports the same status until Finish() or Reset().
+ *
+ * A decoder is not thread-safe, but is reusable: Finish() readies it for the
+ * next document and keeps its scratch storage.
+ *
+ * @example
+ * SchemaPushDecoder decoder;
+ * while (socket.Receive(chunk)) {
+ *      auto status = decoder.Feed(chunk);
+ *      if (!status.ok()) {
+ *          ...
+ *      }
+ * }
+ * auto schema = decoder.Finish().ValueOrDie();
+ */
+class SchemaPushDecoder {
+public:
+    /**
+     * @param[in] options Decoding options, see JSONToSchemaOptions. Fields are
+     * converted as they arrive, so only the interner is used
+     */
+    explicit SchemaPushDecoder(const JSONToSchemaOptions& options = {});
+    ~SchemaPushDecoder();
+
+    SchemaPushDecoder(const SchemaPushDecoder&) = delete;
+    SchemaPushDecoder& operator=(const SchemaPushDecoder&) = delete;
+
+    /**
+     * @brief Decode the next chunk of the document
+     * @return OK if the document is valid so far, descriptive status otherwise
+     */
+    arrow::Status Feed(std::string_view chunk);
+
+    /**
+     * @brief End the document and reset the decoder for the next one
+     * @return arrow::Result contains the converted arrow::Schema if the
+     * document is complete and valid, descriptive status otherwise
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> Finish();
+
+    /**
+     * @brief Drop the current document
+     */
+    void Reset();
+
+    /**
+     * @brief Number of top-level fields converted so far
+     */
+    int NumFields() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_PUSH_DECODER_H_
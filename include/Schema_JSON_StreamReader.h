@@ -0,0 +1,112 @@
+#ifndef _SCHEMA_JSON_STREAM_READER_H_
+#define _SCHEMA_JSON_STREAM_READER_H_
+
+#include <arrow/io/type_fwd.h>
+#include <arrow/result.h>
+#include <arrow/type.h>
+#include <arrow/util/type_fwd.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace converter {
+
+class TypeInterner;
+
+/**
+ * Options of a SchemaStreamReader
+ *
+ * blockSize: number of bytes read from the input at once
+ * useThreads: decode batches of lines in parallel. Schemas are still returned
+ * in stream order
+ * batchSize: number of lines decoded together when useThreads is set
+ * executor: executor running the decodings, arrow's CPU thread pool if null
+ * interner: interning table of the decoded types, see JSONToSchemaOptions
+ */
+struct StreamReaderOptions {
+    int64_t blockSize{ 1 << 20 };
+    bool useThreads{ false };
+    int batchSize{ 1024 };
+    arrow::internal::Executor* executor{ nullptr };
+    TypeInterner* interner{ nullptr };
+};
+
+/**
+ * SchemaStreamReader reads newline-delimited json (one schema document per
+ * line, as written by SchemaToJSONString) and returns the schemas one by one,
+ * in stream order. Blank lines are skipped.
+ *
+ * The input is read in large blocks, and the decoding state (parser handler,
+ * scratch buffers) is kept for the whole stream instead of being built for
+ * every line. A malformed line fails with Invalid naming its line number, and
+ * the following call goes on with the next line. Errors of the input stream
+ * fail with IOError and are returned by every later call, so a caller
+ * skipping malformed lines must stop on any other status.
+ *
+ * A reader is not thread-safe, with useThreads it uses the executor itself.
+ *
+ * @example
+ * auto reader = SchemaStreamReader::Open("changelog.ndjson").ValueOrDie();
+ * while (true) {
+ *      auto result = reader->Next();
+ *      if (result.status().IsInvalid()) {
+ *          // a malformed line, the next call reads the following one
+ *          std::cout << result.status().ToString() << "\n";
+ *          continue;
+ *      }
+ *      if (!result.ok()) {
+ *          // the input failed, every later call fails the same way
+ *          return result.status();
+ *      }
+ *      auto schema = result.ValueOrDie();
+ *      if (schema == nullptr) {
+ *          break;
+ *      }
+ *      process(schema);
+ * }
+ */
+class SchemaStreamReader {
+public:
+    /**
+     * @param[in] input Stream of newline-delimited json, read from its current
+     * position
+     * @param[in] options Reading options
+     */
+    explicit SchemaStreamReader(std::shared_ptr<arrow::io::InputStream> input,
+                                const StreamReaderOptions& options = {});
+    ~SchemaStreamReader();
+
+    SchemaStreamReader(const SchemaStreamReader&) = delete;
+    SchemaStreamReader& operator=(const SchemaStreamReader&) = delete;
+
+    /**
+     * @brief Open a reader on a file
+     * @return arrow::Result contains the reader if the file can be opened,
+     * descriptive status otherwise
+     */
+    static arrow::Result<std::unique_ptr<SchemaStreamReader>> Open(
+        const std::string& path,
+        const StreamReaderOptions& options = {});
+
+    /**
+     * @brief Decode the next schema of the stream
+     * @return arrow::Result contains the next arrow::Schema, nullptr at the
+     * end of the stream, descriptive status otherwise
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> Next();
+
+    /**
+     * @brief Line number (starting at 1) of the last schema or error returned
+     * by Next(), 0 before the first call
+     */
+    int64_t LineNumber() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_STREAM_READER_H_
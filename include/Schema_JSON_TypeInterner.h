@@ -0,0 +1,80 @@
+#ifndef _SCHEMA_JSON_TYPE_INTERNER_H_
+#define _SCHEMA_JSON_TYPE_INTERNER_H_
+
+#include <arrow/type.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace converter {
+
+/**
+ * Counters of a type interner
+ *
+ * hits: types replaced by an already interned equal instance
+ * misses: types that became the canonical instance
+ * size: number of entries currently tracked, expired ones included until they
+ * are purged
+ */
+struct InternerStats {
+    uint64_t hits{};
+    uint64_t misses{};
+    size_t size{};
+};
+
+/**
+ * TypeInterner hash-conses arrow::DataType: structurally equal types (field
+ * names, nullability and metadata of the children included) are mapped to
+ * one canonical shared instance. Decoders given an interner (see
+ * JSONToSchemaOptions) build nested types bottom-up, so once interned, equal
+ * type graphs share every node and comparing them is a pointer compare.
+ *
+ * The table only holds weak references: a canonical type is reclaimed as soon
+ * as no schema uses it anymore, its entry being dropped on a later lookup or
+ * by Purge(). The interner is thread-safe, entries are spread over
+ * independently locked shards.
+ *
+ * @example
+ * converter::TypeInterner interner{};
+ * converter::JSONToSchemaOptions options{};
+ * options.interner = &interner;
+ * for (const auto& jsonObj : documents) {
+ *      auto result = converter::JSONToSchema(jsonObj, options);
+ *      ...
+ * }
+ */
+class TypeInterner {
+public:
+    /**
+     * @param[in] numShards Number of independently locked shards
+     */
+    explicit TypeInterner(size_t numShards = 16);
+    ~TypeInterner();
+
+    TypeInterner(const TypeInterner&) = delete;
+    TypeInterner& operator=(const TypeInterner&) = delete;
+
+    /**
+     * @brief Look up the canonical instance of a type, making the type itself
+     * canonical if no equal one is interned
+     * @return The canonical instance, equal to type
+     */
+    std::shared_ptr<arrow::DataType> Intern(
+        const std::shared_ptr<arrow::DataType>& type);
+
+    /**
+     * @brief Drop the entries of reclaimed types
+     * @return Number of entries dropped
+     */
+    size_t Purge();
+
+    InternerStats Stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+} // namespace converter
+
+#endif // _SCHEMA_JSON_TYPE_INTERNER_H_
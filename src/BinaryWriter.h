@@ -0,0 +1,250 @@
+#ifndef _BINARY_WRITER_H_
+#define _BINARY_WRITER_H_
+
+#include <arrow/io/interfaces.h>
+#include <arrow/status.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * CBOREncoding writes the CBOR items of a JSON document, picking the same
+ * (shortest) encodings as nlohmann::json::to_cbor()
+ */
+struct CBOREncoding {
+    static void Null(std::vector<uint8_t>& out) { out.push_back(0xF6); }
+
+    static void Bool(std::vector<uint8_t>& out, bool value) {
+        out.push_back(value ? 0xF5 : 0xF4);
+    }
+
+    static void Int(std::vector<uint8_t>& out, int64_t value) {
+        if (value >= 0) {
+            head(out, 0x00, static_cast<uint64_t>(value));
+        } else {
+            head(out, 0x20, static_cast<uint64_t>(-1 - value));
+        }
+    }
+
+    static void String(std::vector<uint8_t>& out, std::string_view value) {
+        head(out, 0x60, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    static void ArrayHeader(std::vector<uint8_t>& out, size_t size) {
+        head(out, 0x80, size);
+    }
+
+    static void MapHeader(std::vector<uint8_t>& out, size_t size) {
+        head(out, 0xA0, size);
+    }
+
+private:
+    /**
+     * @brief Write the initial byte of a major type with its argument
+     */
+    static void head(std::vector<uint8_t>& out, uint8_t major, uint64_t arg) {
+        if (arg <= 0x17) {
+            out.push_back(static_cast<uint8_t>(major | arg));
+        } else if (arg <= UINT8_MAX) {
+            out.push_back(major | 0x18);
+            bigEndian(out, arg, 1);
+        } else if (arg <= UINT16_MAX) {
+            out.push_back(major | 0x19);
+            bigEndian(out, arg, 2);
+        } else if (arg <= UINT32_MAX) {
+            out.push_back(major | 0x1A);
+            bigEndian(out, arg, 4);
+        } else {
+            out.push_back(major | 0x1B);
+            bigEndian(out, arg, 8);
+        }
+    }
+
+    static void bigEndian(std::vector<uint8_t>& out, uint64_t value, int n) {
+        for (int i = n - 1; i >= 0; i--) {
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    friend struct MsgPackEncoding;
+};
+
+/**
+ * MsgPackEncoding writes the MessagePack items of a JSON document, picking
+ * the same (shortest) encodings as nlohmann::json::to_msgpack()
+ */
+struct MsgPackEncoding {
+    static void Null(std::vector<uint8_t>& out) { out.push_back(0xC0); }
+
+    static void Bool(std::vector<uint8_t>& out, bool value) {
+        out.push_back(value ? 0xC3 : 0xC2);
+    }
+
+    static void Int(std::vector<uint8_t>& out, int64_t value) {
+        if (value >= 0) {
+            if (value < 0x80) {
+                out.push_back(static_cast<uint8_t>(value));
+            } else if (value <= UINT8_MAX) {
+                typed(out, 0xCC, static_cast<uint64_t>(value), 1);
+            } else if (value <= UINT16_MAX) {
+                typed(out, 0xCD, static_cast<uint64_t>(value), 2);
+            } else if (value <= UINT32_MAX) {
+                typed(out, 0xCE, static_cast<uint64_t>(value), 4);
+            } else {
+                typed(out, 0xCF, static_cast<uint64_t>(value), 8);
+            }
+            return;
+        }
+
+        if (value >= -32) {
+            out.push_back(static_cast<uint8_t>(value));
+        } else if (value >= INT8_MIN) {
+            typed(out, 0xD0, static_cast<uint64_t>(value), 1);
+        } else if (value >= INT16_MIN) {
+            typed(out, 0xD1, static_cast<uint64_t>(value), 2);
+        } else if (value >= INT32_MIN) {
+            typed(out, 0xD2, static_cast<uint64_t>(value), 4);
+        } else {
+            typed(out, 0xD3, static_cast<uint64_t>(value), 8);
+        }
+    }
+
+    static void String(std::vector<uint8_t>& out, std::string_view value) {
+        auto size = value.size();
+        if (size <= 31) {
+            out.push_back(static_cast<uint8_t>(0xA0 | size));
+        } else if (size <= UINT8_MAX) {
+            typed(out, 0xD9, size, 1);
+        } else if (size <= UINT16_MAX) {
+            typed(out, 0xDA, size, 2);
+        } else {
+            typed(out, 0xDB, size, 4);
+        }
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    static void ArrayHeader(std::vector<uint8_t>& out, size_t size) {
+        if (size <= 15) {
+            out.push_back(static_cast<uint8_t>(0x90 | size));
+        } else if (size <= UINT16_MAX) {
+            typed(out, 0xDC, size, 2);
+        } else {
+            typed(out, 0xDD, size, 4);
+        }
+    }
+
+    static void MapHeader(std::vector<uint8_t>& out, size_t size) {
+        if (size <= 15) {
+            out.push_back(static_cast<uint8_t>(0x80 | size));
+        } else if (size <= UINT16_MAX) {
+            typed(out, 0xDE, size, 2);
+        } else {
+            typed(out, 0xDF, size, 4);
+        }
+    }
+
+private:
+    static void typed(std::vector<uint8_t>& out,
+                      uint8_t type,
+                      uint64_t value,
+                      int n) {
+        out.push_back(type);
+        CBOREncoding::bigEndian(out, value, n);
+    }
+};
+
+/**
+ * BinaryWriter emits a JSON document token by token in a binary encoding
+ * (CBOREncoding or MsgPackEncoding). It takes the same calls as JSONWriter,
+ * except that containers are length-prefixed: StartObject/StartArray must be
+ * given the exact number of members that follow. The output is byte-identical
+ * to nlohmann::json::to_cbor()/to_msgpack() as long as the caller emits object
+ * keys in lexicographical order.
+ *
+ * If a sink is given, the buffer is flushed into it whenever it grows past
+ * kFlushThreshold, so the whole document is never staged in memory.
+ *
+ * mBuffer: output buffer, owned by the caller
+ * mSink: optional output stream the buffer is flushed into
+ * mStatus: first error encountered (sink failure)
+ */
+template <typename Encoding>
+class BinaryWriter {
+public:
+    using Buffer = std::vector<uint8_t>;
+
+    static constexpr size_t kFlushThreshold = 64 * 1024;
+
+    explicit BinaryWriter(Buffer* buffer,
+                          arrow::io::OutputStream* sink = nullptr)
+        : mBuffer{ buffer }
+        , mSink{ sink } {};
+
+    ~BinaryWriter() = default;
+
+    void StartObject(size_t size) { Encoding::MapHeader(*mBuffer, size); }
+
+    void EndObject() { maybeFlush(); }
+
+    void StartArray(size_t size) { Encoding::ArrayHeader(*mBuffer, size); }
+
+    void EndArray() { maybeFlush(); }
+
+    void Key(std::string_view key) { Encoding::String(*mBuffer, key); }
+
+    void String(std::string_view value) { Encoding::String(*mBuffer, value); }
+
+    void Int(int64_t value) { Encoding::Int(*mBuffer, value); }
+
+    void Bool(bool value) { Encoding::Bool(*mBuffer, value); }
+
+    void Null() { Encoding::Null(*mBuffer); }
+
+    /**
+     * @brief Append already encoded items as is
+     */
+    void RawValue(std::string_view value) {
+        mBuffer->insert(mBuffer->end(), value.begin(), value.end());
+        maybeFlush();
+    }
+
+    void RawValue(const Buffer& value) {
+        mBuffer->insert(mBuffer->end(), value.begin(), value.end());
+        maybeFlush();
+    }
+
+    /**
+     * @brief Flush the remaining bytes into the sink (if any)
+     * @return First error encountered while writing, OK otherwise
+     */
+    arrow::Status Finish() {
+        if (mStatus.ok() && mSink != nullptr && !mBuffer->empty()) {
+            mStatus = mSink->Write(mBuffer->data(), mBuffer->size());
+            mBuffer->clear();
+        }
+        return mStatus;
+    }
+
+    const arrow::Status& status() const { return mStatus; }
+
+private:
+    void maybeFlush() {
+        if (mSink == nullptr || mBuffer->size() < kFlushThreshold ||
+            !mStatus.ok()) {
+            return;
+        }
+        mStatus = mSink->Write(mBuffer->data(), mBuffer->size());
+        mBuffer->clear();
+    }
+
+    Buffer* mBuffer{};
+    arrow::io::OutputStream* mSink{};
+    arrow::Status mStatus{};
+};
+
+using CBORWriter = BinaryWriter<CBOREncoding>;
+using MsgPackWriter = BinaryWriter<MsgPackEncoding>;
+
+#endif // _BINARY_WRITER_H_
@@ -3,7 +3,22 @@
 
 #include <arrow/type.h>
 
-#include "IDataType.h"
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <variant>
+
+#include "JSONWriter.h"
+
+using json = nlohmann::json;
+
+/**
+ * Type descriptors below are plain value types: they are built on the stack
+ * for each field and dispatched through the TypeJSON variant, so converting a
+ * field allocates nothing for its type. Strings are views and must outlive the
+ * descriptor (they point at the constants of namespace datatype or into the
+ * arrow::DataType being converted). MarshalJSON() sets the members one by
+ * one: a json initializer list builds every pair as a temporary array first.
+ */
 
 /**
  *
@@ -12,21 +27,28 @@
  *
  * mName: field name
  */
-class NameJSON : public IDataType {
+class NameJSON {
 public:
-    NameJSON(const std::string& name)
+    NameJSON(std::string_view name)
         : mName{ name } {};
 
-    ~NameJSON() = default;
+    template <typename JSON = json>
+    JSON MarshalJSON() const {
+        JSON result{};
+        result["name"] = mName;
+        return result;
+    }
 
-    const json MarshalJSON() override {
-        return {
-            { "name", mName },
-        };
+    template <typename Writer>
+    void WriteJSON(Writer& writer) const {
+        writer.StartObject(1);
+        writer.Key("name");
+        writer.String(mName);
+        writer.EndObject();
     }
 
 private:
-    std::string mName{};
+    std::string_view mName{};
 };
 
 /**
@@ -37,33 +59,46 @@ private:
  * mSigned: signed or unsigned integer
  * mBitWidth: bit width, only supports 8, 16, 32 and 64 bits
  */
-class BitWidthJSON : public IDataType {
+class BitWidthJSON {
 public:
-    BitWidthJSON(const std::string& name,
+    BitWidthJSON(std::string_view name,
                  bool isSigned,
                  int bitWidth,
-                 const std::string& unit = "")
+                 std::string_view unit = "")
         : mName{ name }
         , mSigned{ isSigned }
         , mBitWidth{ bitWidth }
         , mUnit{ unit } {};
 
-    ~BitWidthJSON() = default;
+    template <typename JSON = json>
+    JSON MarshalJSON() const {
+        JSON result{};
+        result["name"] = mName;
+        result["isSigned"] = mSigned;
+        result["bitWidth"] = mBitWidth;
+        result["unit"] = mUnit;
+        return result;
+    }
 
-    const json MarshalJSON() override {
-        return {
-            { "name", mName },
-            { "isSigned", mSigned },
-            { "bitWidth", mBitWidth },
-            { "unit", mUnit },
-        };
+    template <typename Writer>
+    void WriteJSON(Writer& writer) const {
+        writer.StartObject(4);
+        writer.Key("bitWidth");
+        writer.Int(mBitWidth);
+        writer.Key("isSigned");
+        writer.Bool(mSigned);
+        writer.Key("name");
+        writer.String(mName);
+        writer.Key("unit");
+        writer.String(mUnit);
+        writer.EndObject();
     }
 
 private:
-    std::string mName{};
+    std::string_view mName{};
     bool mSigned{};
     int mBitWidth{};
-    std::string mUnit{};
+    std::string_view mUnit{};
 };
 
 /**
@@ -75,24 +110,33 @@ private:
  *      SINGLE precision for FLOAT32
  *      DOUBLE precision for FLOAT64
  */
-class FloatJSON : public IDataType {
+class FloatJSON {
 public:
-    FloatJSON(const std::string& name, const std::string& precision)
+    FloatJSON(std::string_view name, std::string_view precision)
         : mName{ name }
         , mPrecision{ precision } {};
 
-    ~FloatJSON() = default;
+    template <typename JSON = json>
+    JSON MarshalJSON() const {
+        JSON result{};
+        result["name"] = mName;
+        result["precision"] = mPrecision;
+        return result;
+    }
 
-    const json MarshalJSON() override {
-        return {
-            { "name", mName },
-            { "precision", mPrecision },
-        };
+    template <typename Writer>
+    void WriteJSON(Writer& writer) const {
+        writer.StartObject(2);
+        writer.Key("name");
+        writer.String(mName);
+        writer.Key("precision");
+        writer.String(mPrecision);
+        writer.EndObject();
     }
 
 private:
-    std::string mName{};
-    std::string mPrecision{};
+    std::string_view mName{};
+    std::string_view mPrecision{};
 };
 
 /**
@@ -103,29 +147,40 @@ private:
  * mUnit: time unit (such as second, millisecond, microsecond, nanosecond)
  * mTimeZone: timezone
  */
-class UnitZoneJSON : public IDataType {
+class UnitZoneJSON {
 public:
-    UnitZoneJSON(const std::string& name,
-                 const std::string& unit = "",
-                 const std::string& timezone = "")
+    UnitZoneJSON(std::string_view name,
+                 std::string_view unit = "",
+                 std::string_view timezone = "")
         : mName{ name }
         , mUnit{ unit }
         , mTimeZone{ timezone } {};
 
-    ~UnitZoneJSON() = default;
+    template <typename JSON = json>
+    JSON MarshalJSON() const {
+        JSON result{};
+        result["name"] = mName;
+        result["unit"] = mUnit;
+        result["timezone"] = mTimeZone;
+        return result;
+    }
 
-    const json MarshalJSON() {
-        return {
-            { "name", mName },
-            { "unit", mUnit },
-            { "timezone", mTimeZone },
-        };
+    template <typename Writer>
+    void WriteJSON(Writer& writer) const {
+        writer.StartObject(3);
+        writer.Key("name");
+        writer.String(mName);
+        writer.Key("timezone");
+        writer.String(mTimeZone);
+        writer.Key("unit");
+        writer.String(mUnit);
+        writer.EndObject();
     }
 
 private:
-    std::string mName{};
-    std::string mUnit{};
-    std::string mTimeZone{};
+    std::string_view mName{};
+    std::string_view mUnit{};
+    std::string_view mTimeZone{};
 };
 
 /**
@@ -135,25 +190,36 @@ private:
  * mScale: scale number
  * mPrecision: number of precision
  */
-class DecimalJSON : public IDataType {
+class DecimalJSON {
 public:
-    DecimalJSON(const std::string& name, int scale, int precision)
+    DecimalJSON(std::string_view name, int scale, int precision)
         : mName{ name }
         , mScale{ scale }
         , mPrecision{ precision } {};
 
-    ~DecimalJSON() = default;
+    template <typename JSON = json>
+    JSON MarshalJSON() const {
+        JSON result{};
+        result["name"] = mName;
+        result["scale"] = mScale;
+        result["precision"] = mPrecision;
+        return result;
+    }
 
-    const json MarshalJSON() {
-        return {
-            { "name", mName },
-            { "scale", mScale },
-            { "precision", mPrecision },
-        };
+    template <typename Writer>
+    void WriteJSON(Writer& writer) const {
+        writer.StartObject(3);
+        writer.Key("name");
+        writer.String(mName);
+        writer.Key("precision");
+        writer.Int(mPrecision);
+        writer.Key("scale");
+        writer.Int(mScale);
+        writer.EndObject();
     }
 
 private:
-    std::string mName{};
+    std::string_view mName{};
     int mScale{};
     int mPrecision{};
 };
@@ -164,23 +230,32 @@ private:
  * mName: field name
  * mByteWidth: byte width
  */
-class ByteWidthJSON : public IDataType {
+class ByteWidthJSON {
 public:
-    ByteWidthJSON(const std::string& name, int byteWidth)
+    ByteWidthJSON(std::string_view name, int byteWidth)
         : mName{ name }
         , mByteWidth{ byteWidth } {};
 
-    ~ByteWidthJSON() = default;
+    template <typename JSON = json>
+    JSON MarshalJSON() const {
+        JSON result{};
+        result["name"] = mName;
+        result["byteWidth"] = mByteWidth;
+        return result;
+    }
 
-    const json MarshalJSON() {
-        return {
-            { "name", mName },
-            { "byteWidth", mByteWidth },
-        };
+    template <typename Writer>
+    void WriteJSON(Writer& writer) const {
+        writer.StartObject(2);
+        writer.Key("byteWidth");
+        writer.Int(mByteWidth);
+        writer.Key("name");
+        writer.String(mName);
+        writer.EndObject();
     }
 
 private:
-    std::string mName{};
+    std::string_view mName{};
     int mByteWidth{};
 };
 
@@ -190,43 +265,89 @@ private:
  * mName: field name
  * mKeySorted: key is sorted or not
  */
-class MapJSON : public IDataType {
+class MapJSON {
 public:
-    MapJSON(const std::string& name, bool keySorted = false)
+    MapJSON(std::string_view name, bool keySorted = false)
         : mName{ name }
         , mKeySorted{ keySorted } {};
 
-    ~MapJSON() = default;
+    template <typename JSON = json>
+    JSON MarshalJSON() const {
+        JSON result{};
+        result["name"] = mName;
+        result["keySorted"] = mKeySorted;
+        return result;
+    }
 
-    const json MarshalJSON() {
-        return {
-            { "name", mName },
-            { "keySorted", mKeySorted },
-        };
+    template <typename Writer>
+    void WriteJSON(Writer& writer) const {
+        writer.StartObject(2);
+        writer.Key("keySorted");
+        writer.Bool(mKeySorted);
+        writer.Key("name");
+        writer.String(mName);
+        writer.EndObject();
     }
 
 private:
-    std::string mName{};
+    std::string_view mName{};
     bool mKeySorted{};
 };
 
+/**
+ * TypeJSON holds any of the type descriptors above
+ */
+using TypeJSON = std::variant<NameJSON,
+                              BitWidthJSON,
+                              FloatJSON,
+                              UnitZoneJSON,
+                              DecimalJSON,
+                              ByteWidthJSON,
+                              MapJSON>;
+
+/**
+ * @brief Convert the held type descriptor into Json format
+ */
+template <typename JSON = json>
+inline JSON MarshalJSON(const TypeJSON& type) {
+    return std::visit(
+        [](const auto& item) { return item.template MarshalJSON<JSON>(); },
+        type);
+}
+
+/**
+ * @brief Write the held type descriptor into a JSONWriter or a BinaryWriter
+ */
+template <typename Writer>
+inline void WriteJSON(const TypeJSON& type, Writer& writer) {
+    std::visit([&writer](const auto& item) { item.WriteJSON(writer); }, type);
+}
+
 namespace datatype {
-const std::string kNullType = "null";
-const std::string kBoolType = "bool";
-const std::string kIntType = "int";
-const std::string kFloatingPointType = "floatingpoint";
-const std::string kUtf8Type = "utf8";
-const std::string kBinaryType = "binary";
-const std::string kFixedSizeBinaryType = "fixedsizebinary";
-const std::string kDateType = "date";
-const std::string kTimestampType = "timestamp";
-const std::string kTimeType = "time";
-const std::string kIntervalType = "interval";
-const std::string kDecimalType = "decimal";
-const std::string kListType = "list";
-const std::string kStructType = "struct";
-const std::string kMapType = "map";
-const std::string kDurationType = "duration";
+
+/**
+ * Names below are constexpr views: they need no static initialization, and
+ * the Get*FromString() lookups are constexpr functions which pick the only
+ * candidate matching the length of the text (and one of its characters when
+ * several names share a length), then compare it once. A lookup allocates
+ * nothing and touches no hash table.
+ */
+inline constexpr std::string_view kNullType = "null";
+inline constexpr std::string_view kBoolType = "bool";
+inline constexpr std::string_view kIntType = "int";
+inline constexpr std::string_view kFloatingPointType = "floatingpoint";
+inline constexpr std::string_view kUtf8Type = "utf8";
+inline constexpr std::string_view kBinaryType = "binary";
+inline constexpr std::string_view kFixedSizeBinaryType = "fixedsizebinary";
+inline constexpr std::string_view kDateType = "date";
+inline constexpr std::string_view kTimestampType = "timestamp";
+inline constexpr std::string_view kTimeType = "time";
+inline constexpr std::string_view kIntervalType = "interval";
+inline constexpr std::string_view kDecimalType = "decimal";
+inline constexpr std::string_view kListType = "list";
+inline constexpr std::string_view kStructType = "struct";
+inline constexpr std::string_view kMapType = "map";
+inline constexpr std::string_view kDurationType = "duration";
 
 enum TypeName {
     TYPE_NAME_NOT_SET,
@@ -248,35 +369,85 @@ enum TypeName {
     TYPE_NAME_DURATION,
 };
 
-inline TypeName GetTypeFromString(const std::string& type) {
-    static const std::unordered_map<std::string, TypeName> hashMap{
-        { kNullType, TYPE_NAME_NULL },
-        { kBoolType, TYPE_NAME_BOOL },
-        { kIntType, TYPE_NAME_INT },
-        { kFloatingPointType, TYPE_NAME_FLOATING_POINT },
-        { kUtf8Type, TYPE_NAME_UTF8 },
-        { kBinaryType, TYPE_NAME_BINARY },
-        { kFixedSizeBinaryType, TYPE_NAME_FIXED_SIZE_BINARY },
-        { kDateType, TYPE_NAME_DATE },
-        { kTimestampType, TYPE_NAME_TIMESTAMP },
-        { kTimeType, TYPE_NAME_TIME },
-        { kIntervalType, TYPE_NAME_INTERVAL },
-        { kDecimalType, TYPE_NAME_DECIMAL },
-        { kListType, TYPE_NAME_LIST },
-        { kStructType, TYPE_NAME_STRUCT },
-        { kMapType, TYPE_NAME_MAP },
-        { kDurationType, TYPE_NAME_DURATION },
-    };
-    auto item = hashMap.find(type);
-    if (item != hashMap.end()) {
-        return item->second;
+/**
+ * Type names indexed by TypeName
+ */
+inline constexpr std::string_view kTypeNames[] = {
+    {},
+    kNullType,
+    kBoolType,
+    kIntType,
+    kFloatingPointType,
+    kUtf8Type,
+    kBinaryType,
+    kFixedSizeBinaryType,
+    kDateType,
+    kTimestampType,
+    kTimeType,
+    kIntervalType,
+    kDecimalType,
+    kListType,
+    kStructType,
+    kMapType,
+    kDurationType,
+};
+
+constexpr TypeName GetTypeFromString(std::string_view type) {
+    auto candidate = TYPE_NAME_NOT_SET;
+    switch (type.size()) {
+        case 3:
+            candidate = type[0] == 'i' ? TYPE_NAME_INT : TYPE_NAME_MAP;
+            break;
+        case 4:
+            switch (type[0]) {
+                case 'n':
+                    candidate = TYPE_NAME_NULL;
+                    break;
+                case 'b':
+                    candidate = TYPE_NAME_BOOL;
+                    break;
+                case 'u':
+                    candidate = TYPE_NAME_UTF8;
+                    break;
+                case 'd':
+                    candidate = TYPE_NAME_DATE;
+                    break;
+                case 't':
+                    candidate = TYPE_NAME_TIME;
+                    break;
+                default:
+                    candidate = TYPE_NAME_LIST;
+                    break;
+            }
+            break;
+        case 6:
+            candidate = type[0] == 'b' ? TYPE_NAME_BINARY : TYPE_NAME_STRUCT;
+            break;
+        case 7:
+            candidate = TYPE_NAME_DECIMAL;
+            break;
+        case 8:
+            candidate =
+                type[0] == 'i' ? TYPE_NAME_INTERVAL : TYPE_NAME_DURATION;
+            break;
+        case 9:
+            candidate = TYPE_NAME_TIMESTAMP;
+            break;
+        case 13:
+            candidate = TYPE_NAME_FLOATING_POINT;
+            break;
+        case 15:
+            candidate = TYPE_NAME_FIXED_SIZE_BINARY;
+            break;
+        default:
+            return TYPE_NAME_NOT_SET;
     }
-    return TYPE_NAME_NOT_SET;
+    return type == kTypeNames[candidate] ? candidate : TYPE_NAME_NOT_SET;
 }
 
-const std::string kPrecisionHalf = "HALF";
-const std::string kPrecisionSingle = "SINGLE";
-const std::string kPrecisionDouble = "DOUBLE";
+inline constexpr std::string_view kPrecisionHalf = "HALF";
+inline constexpr std::string_view kPrecisionSingle = "SINGLE";
+inline constexpr std::string_view kPrecisionDouble = "DOUBLE";
 
 enum Precision {
     PRECISION_NOT_SET,
@@ -285,24 +456,38 @@ enum Precision {
     PRECISION_DOUBLE,
 };
 
-inline Precision GetPrecisionFromString(const std::string& precision) {
-    static const std::unordered_map<std::string, Precision> hashMap{
-        { kPrecisionHalf, PRECISION_HALF },
-        { kPrecisionSingle, PRECISION_SINGLE },
-        { kPrecisionDouble, PRECISION_DOUBLE },
-    };
-    auto item = hashMap.find(precision);
-    if (item != hashMap.end()) {
-        return item->second;
+/**
+ * Precision names indexed by Precision
+ */
+inline constexpr std::string_view kPrecisionNames[] = {
+    {},
+    kPrecisionHalf,
+    kPrecisionSingle,
+    kPrecisionDouble,
+};
+
+constexpr Precision GetPrecisionFromString(std::string_view precision) {
+    auto candidate = PRECISION_NOT_SET;
+    switch (precision.size()) {
+        case 4:
+            candidate = PRECISION_HALF;
+            break;
+        case 6:
+            candidate =
+                precision[0] == 'S' ? PRECISION_SINGLE : PRECISION_DOUBLE;
+            break;
+        default:
+            return PRECISION_NOT_SET;
     }
-    return PRECISION_NOT_SET;
+    return precision == kPrecisionNames[candidate] ? candidate
+                                                   : PRECISION_NOT_SET;
 }
 
-const std::string kDayUnit = "DAY";
-const std::string kSecondUnit = "SECOND";
-const std::string kMillisecondUnit = "MILLISECOND";
-const std::string kMicrosecondUnit = "MICROSECOND";
-const std::string kNanosecondUnit = "NANOSECOND";
+inline constexpr std::string_view kDayUnit = "DAY";
+inline constexpr std::string_view kSecondUnit = "SECOND";
+inline constexpr std::string_view kMillisecondUnit = "MILLISECOND";
+inline constexpr std::string_view kMicrosecondUnit = "MICROSECOND";
+inline constexpr std::string_view kNanosecondUnit = "NANOSECOND";
 
 enum DateTimeUnit {
     DATE_TIME_UNIT_NOT_SET,
@@ -313,24 +498,43 @@ enum DateTimeUnit {
     DATE_TIME_UNIT_NANOSECOND,
 };
 
-inline DateTimeUnit GetUnitFromString(const std::string& unit) {
-    static const std::unordered_map<std::string, DateTimeUnit> hashMap{
-        { kDayUnit, DATE_TIME_UNIT_DAY },
-        { kSecondUnit, DATE_TIME_UNIT_SECOND },
-        { kMillisecondUnit, DATE_TIME_UNIT_MILLISECOND },
-        { kMicrosecondUnit, DATE_TIME_UNIT_MICROSECOND },
-        { kNanosecondUnit, DATE_TIME_UNIT_NANOSECOND },
-    };
-    auto item = hashMap.find(unit);
-    if (item != hashMap.end()) {
-        return item->second;
+/**
+ * Unit names indexed by DateTimeUnit
+ */
+inline constexpr std::string_view kUnitNames[] = {
+    {},
+    kDayUnit,
+    kSecondUnit,
+    kMillisecondUnit,
+    kMicrosecondUnit,
+    kNanosecondUnit,
+};
+
+constexpr DateTimeUnit GetUnitFromString(std::string_view unit) {
+    auto candidate = DATE_TIME_UNIT_NOT_SET;
+    switch (unit.size()) {
+        case 3:
+            candidate = DATE_TIME_UNIT_DAY;
+            break;
+        case 6:
+            candidate = DATE_TIME_UNIT_SECOND;
+            break;
+        case 10:
+            candidate = DATE_TIME_UNIT_NANOSECOND;
+            break;
+        case 11: // MILLISECOND and MICROSECOND differ from the third letter
+            candidate = unit[2] == 'L' ? DATE_TIME_UNIT_MILLISECOND
+                                       : DATE_TIME_UNIT_MICROSECOND;
+            break;
+        default:
+            return DATE_TIME_UNIT_NOT_SET;
     }
-    return DATE_TIME_UNIT_NOT_SET;
+    return unit == kUnitNames[candidate] ? candidate : DATE_TIME_UNIT_NOT_SET;
 }
 
-const std::string kYearMonthIntervalUnit = "YEAR_MONTH";
-const std::string kDayTimeIntervalUnit = "DAY_TIME";
-const std::string kMonthDayNanoIntervalUnit = "MONTH_DAY_NANO";
+inline constexpr std::string_view kYearMonthIntervalUnit = "YEAR_MONTH";
+inline constexpr std::string_view kDayTimeIntervalUnit = "DAY_TIME";
+inline constexpr std::string_view kMonthDayNanoIntervalUnit = "MONTH_DAY_NANO";
 
 enum IntervalUnit {
     INTERVAL_UNIT_NOT_SET,
@@ -339,19 +543,41 @@ enum IntervalUnit {
     INTERVAL_UNIT_MONTH_DAY_NANO,
 };
 
-inline IntervalUnit GetIntervalUnitFromString(const std::string& unit) {
-    static const std::unordered_map<std::string, IntervalUnit> hashMap{
-        { kYearMonthIntervalUnit, INTERVAL_UNIT_YEAR_MONTH },
-        { kDayTimeIntervalUnit, INTERVAL_UNIT_DAY_TIME },
-        { kMonthDayNanoIntervalUnit, INTERVAL_UNIT_MONTH_DAY_NANO },
-    };
-    auto item = hashMap.find(unit);
-    if (item != hashMap.end()) {
-        return item->second;
+/**
+ * Interval unit names indexed by IntervalUnit
+ */
+inline constexpr std::string_view kIntervalUnitNames[] = {
+    {},
+    kYearMonthIntervalUnit,
+    kDayTimeIntervalUnit,
+    kMonthDayNanoIntervalUnit,
+};
+
+constexpr IntervalUnit GetIntervalUnitFromString(std::string_view unit) {
+    auto candidate = INTERVAL_UNIT_NOT_SET;
+    switch (unit.size()) {
+        case 8:
+            candidate = INTERVAL_UNIT_DAY_TIME;
+            break;
+        case 10:
+            candidate = INTERVAL_UNIT_YEAR_MONTH;
+            break;
+        case 14:
+            candidate = INTERVAL_UNIT_MONTH_DAY_NANO;
+            break;
+        default:
+            return INTERVAL_UNIT_NOT_SET;
     }
-    return INTERVAL_UNIT_NOT_SET;
+    return unit == kIntervalUnitNames[candidate] ? candidate
+                                                 : INTERVAL_UNIT_NOT_SET;
 }
 
+static_assert(GetTypeFromString("fixedsizebinary") ==
+              TYPE_NAME_FIXED_SIZE_BINARY);
+static_assert(GetTypeFromString("lost") == TYPE_NAME_NOT_SET);
+static_assert(GetUnitFromString("MICROSECOND") == DATE_TIME_UNIT_MICROSECOND);
+static_assert(GetIntervalUnitFromString("DAY") == INTERVAL_UNIT_NOT_SET);
+
 // These macros are for extension types. Refer
 // https://github.com/apache/arrow/blob/8e43f23dcc6a9e630516228f110c48b64d13cec6/cpp/src/arrow/extension_type.cc#L166-L167
 #define EXTENSION_TYPE_KEY_NAME "ARROW:extension:name"
@@ -0,0 +1,449 @@
+#include "FieldBuilder.h"
+
+#include <arrow/extension_type.h>
+#include <arrow/util/key_value_metadata.h>
+
+int RequiredTypeParams(datatype::TypeName typeName) {
+    switch (typeName) {
+        case datatype::TYPE_NAME_INT:
+            return TYPE_PARAM_IS_SIGNED | TYPE_PARAM_BIT_WIDTH;
+        case datatype::TYPE_NAME_FLOATING_POINT:
+            return TYPE_PARAM_PRECISION_NAME;
+        case datatype::TYPE_NAME_DATE:
+        case datatype::TYPE_NAME_INTERVAL:
+        case datatype::TYPE_NAME_DURATION:
+            return TYPE_PARAM_UNIT;
+        case datatype::TYPE_NAME_TIME:
+            return TYPE_PARAM_BIT_WIDTH | TYPE_PARAM_UNIT;
+        case datatype::TYPE_NAME_TIMESTAMP:
+            return TYPE_PARAM_UNIT | TYPE_PARAM_TIMEZONE;
+        case datatype::TYPE_NAME_MAP:
+            return TYPE_PARAM_KEY_SORTED;
+        case datatype::TYPE_NAME_FIXED_SIZE_BINARY:
+            return TYPE_PARAM_BYTE_WIDTH;
+        case datatype::TYPE_NAME_DECIMAL:
+            return TYPE_PARAM_PRECISION | TYPE_PARAM_SCALE;
+        default:
+            return 0;
+    }
+}
+
+const char* TypeParamKey(int param) {
+    switch (param) {
+        case TYPE_PARAM_IS_SIGNED:
+            return "isSigned";
+        case TYPE_PARAM_BIT_WIDTH:
+            return "bitWidth";
+        case TYPE_PARAM_PRECISION_NAME:
+        case TYPE_PARAM_PRECISION:
+            return "precision";
+        case TYPE_PARAM_SCALE:
+            return "scale";
+        case TYPE_PARAM_UNIT:
+            return "unit";
+        case TYPE_PARAM_TIMEZONE:
+            return "timezone";
+        case TYPE_PARAM_BYTE_WIDTH:
+            return "byteWidth";
+        default:
+            return "keySorted";
+    }
+}
+
+bool HasChildren(datatype::TypeName typeName) {
+    return typeName == datatype::TYPE_NAME_LIST ||
+           typeName == datatype::TYPE_NAME_MAP ||
+           typeName == datatype::TYPE_NAME_STRUCT;
+}
+
+bool ReadsChild(datatype::TypeName typeName, size_t index) {
+    switch (typeName) {
+        case datatype::TYPE_NAME_LIST:
+        case datatype::TYPE_NAME_MAP:
+            return index == 0;
+        case datatype::TYPE_NAME_STRUCT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Whether arrow builds a new type instance on every call for this type
+ * name. The factories of the other types return shared singletons, there is
+ * nothing to intern
+ */
+static bool isParametric(datatype::TypeName typeName) {
+    switch (typeName) {
+        case datatype::TYPE_NAME_TIME:
+        case datatype::TYPE_NAME_TIMESTAMP:
+        case datatype::TYPE_NAME_LIST:
+        case datatype::TYPE_NAME_MAP:
+        case datatype::TYPE_NAME_STRUCT:
+        case datatype::TYPE_NAME_FIXED_SIZE_BINARY:
+        case datatype::TYPE_NAME_DURATION:
+        case datatype::TYPE_NAME_DECIMAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Range of the precision of a decimal, arrow aborts outside of it
+ */
+static constexpr int kMinDecimalPrecision = 1;
+static constexpr int kMaxDecimalPrecision = 76;
+
+arrow::Status ValidateFieldSpec(const FieldSpec& spec) {
+    switch (spec.mTypeName) {
+        case datatype::TYPE_NAME_NULL:
+        case datatype::TYPE_NAME_BOOL:
+        case datatype::TYPE_NAME_BINARY:
+        case datatype::TYPE_NAME_UTF8:
+        case datatype::TYPE_NAME_LIST:
+        case datatype::TYPE_NAME_MAP:
+        case datatype::TYPE_NAME_STRUCT:
+            return arrow::Status::OK();
+        case datatype::TYPE_NAME_INT:
+            switch (spec.mBitWidth) {
+                case 8:
+                case 16:
+                case 32:
+                case 64:
+                    return arrow::Status::OK();
+                default:
+                    return arrow::Status::Invalid("unsupported bit width");
+            }
+        case datatype::TYPE_NAME_FLOATING_POINT:
+            if (datatype::GetPrecisionFromString(spec.mPrecisionName) ==
+                datatype::PRECISION_NOT_SET) {
+                return arrow::Status::Invalid("unsupported precision");
+            }
+            return arrow::Status::OK();
+        case datatype::TYPE_NAME_DATE: {
+            auto unitEnum = datatype::GetUnitFromString(spec.mUnit);
+            if (unitEnum != datatype::DATE_TIME_UNIT_DAY &&
+                unitEnum != datatype::DATE_TIME_UNIT_MILLISECOND) {
+                return arrow::Status::Invalid("unsupported unit");
+            }
+            return arrow::Status::OK();
+        }
+        case datatype::TYPE_NAME_TIME: {
+            auto unitEnum = datatype::GetUnitFromString(spec.mUnit);
+            bool isTime32 = unitEnum == datatype::DATE_TIME_UNIT_SECOND ||
+                            unitEnum == datatype::DATE_TIME_UNIT_MILLISECOND;
+            bool isTime64 = unitEnum == datatype::DATE_TIME_UNIT_MICROSECOND ||
+                            unitEnum == datatype::DATE_TIME_UNIT_NANOSECOND;
+            if (spec.mBitWidth != 32 && spec.mBitWidth != 64) {
+                return arrow::Status::Invalid("unsupported bit width");
+            }
+            if (spec.mBitWidth == 32 ? !isTime32 : !isTime64) {
+                return arrow::Status::Invalid("unsupported unit");
+            }
+            return arrow::Status::OK();
+        }
+        case datatype::TYPE_NAME_TIMESTAMP:
+        case datatype::TYPE_NAME_DURATION: {
+            auto unitEnum = datatype::GetUnitFromString(spec.mUnit);
+            if (unitEnum == datatype::DATE_TIME_UNIT_NOT_SET ||
+                unitEnum == datatype::DATE_TIME_UNIT_DAY) {
+                return arrow::Status::Invalid("unsupported unit");
+            }
+            return arrow::Status::OK();
+        }
+        case datatype::TYPE_NAME_INTERVAL:
+            if (datatype::GetIntervalUnitFromString(spec.mUnit) ==
+                datatype::INTERVAL_UNIT_NOT_SET) {
+                return arrow::Status::Invalid("unsupported unit");
+            }
+            return arrow::Status::OK();
+        case datatype::TYPE_NAME_FIXED_SIZE_BINARY:
+            if (spec.mByteWidth < 0) {
+                return arrow::Status::Invalid("unsupported byte width");
+            }
+            return arrow::Status::OK();
+        case datatype::TYPE_NAME_DECIMAL:
+            if (spec.mPrecision < kMinDecimalPrecision ||
+                spec.mPrecision > kMaxDecimalPrecision) {
+                return arrow::Status::Invalid("unsupported precision");
+            }
+            return arrow::Status::OK();
+        default:
+            return arrow::Status::Invalid("unsupported type");
+    }
+}
+
+arrow::Result<std::shared_ptr<arrow::Field>> BuildField(
+    const FieldSpec& spec,
+    std::vector<std::shared_ptr<arrow::Field>>& children,
+    bool hasMetadata,
+    const std::vector<std::string>& keys,
+    const std::vector<std::string>& values,
+    converter::TypeInterner* interner) {
+    auto status = ValidateFieldSpec(spec);
+    if (!status.ok()) {
+        return status;
+    }
+
+    std::shared_ptr<arrow::DataType> resultType{};
+
+    switch (spec.mTypeName) {
+        case datatype::TYPE_NAME_NULL:
+            resultType = arrow::null();
+            break;
+        case datatype::TYPE_NAME_BOOL:
+            resultType = arrow::boolean();
+            break;
+        case datatype::TYPE_NAME_INT: {
+            if (spec.mIsSigned) {
+                switch (spec.mBitWidth) {
+                    case 8:
+                        resultType = arrow::int8();
+                        break;
+                    case 16:
+                        resultType = arrow::int16();
+                        break;
+                    case 32:
+                        resultType = arrow::int32();
+                        break;
+                    case 64:
+                        resultType = arrow::int64();
+                        break;
+                    default:
+                        return arrow::Status::Invalid("unsupported bit width");
+                }
+            } else {
+                switch (spec.mBitWidth) {
+                    case 8:
+                        resultType = arrow::uint8();
+                        break;
+                    case 16:
+                        resultType = arrow::uint16();
+                        break;
+                    case 32:
+                        resultType = arrow::uint32();
+                        break;
+                    case 64:
+                        resultType = arrow::uint64();
+                        break;
+                    default:
+                        return arrow::Status::Invalid("unsupported bit width");
+                }
+            }
+
+            break;
+        }
+        case datatype::TYPE_NAME_FLOATING_POINT: {
+            auto precisionEnum =
+                datatype::GetPrecisionFromString(spec.mPrecisionName);
+            switch (precisionEnum) {
+                case datatype::PRECISION_HALF:
+                    resultType = arrow::float16();
+                    break;
+                case datatype::PRECISION_SINGLE:
+                    resultType = arrow::float32();
+                    break;
+                case datatype::PRECISION_DOUBLE:
+                    resultType = arrow::float64();
+                    break;
+                default:
+                    return arrow::Status::Invalid("unsupported precision");
+            }
+            break;
+        }
+        case datatype::TYPE_NAME_BINARY:
+            resultType = arrow::binary();
+            break;
+        case datatype::TYPE_NAME_UTF8:
+            resultType = arrow::utf8();
+            break;
+        case datatype::TYPE_NAME_DATE: {
+            auto unitEnum = datatype::GetUnitFromString(spec.mUnit);
+            switch (unitEnum) {
+                case datatype::DATE_TIME_UNIT_DAY:
+                    resultType = arrow::date32();
+                    break;
+                case datatype::DATE_TIME_UNIT_MILLISECOND:
+                    resultType = arrow::date64();
+                    break;
+                default:
+                    return arrow::Status::Invalid("unsupported unit");
+            }
+            break;
+        }
+        case datatype::TYPE_NAME_TIME: {
+            auto unitEnum = datatype::GetUnitFromString(spec.mUnit);
+
+            switch (spec.mBitWidth) {
+                case 32:
+                    switch (unitEnum) {
+                        case datatype::DATE_TIME_UNIT_SECOND:
+                            resultType = arrow::time32(arrow::TimeUnit::SECOND);
+                            break;
+                        case datatype::DATE_TIME_UNIT_MILLISECOND:
+                            resultType = arrow::time32(arrow::TimeUnit::MILLI);
+                            break;
+                        default:
+                            return arrow::Status::Invalid("unsupported unit");
+                    }
+                    break;
+                case 64:
+                    switch (unitEnum) {
+                        case datatype::DATE_TIME_UNIT_MICROSECOND:
+                            resultType = arrow::time64(arrow::TimeUnit::MICRO);
+                            break;
+                        case datatype::DATE_TIME_UNIT_NANOSECOND:
+                            resultType = arrow::time64(arrow::TimeUnit::NANO);
+                            break;
+                        default:
+                            return arrow::Status::Invalid("unsupported unit");
+                    }
+                    break;
+                default:
+                    return arrow::Status::Invalid("unsupported bit width");
+            }
+            break;
+        }
+        case datatype::TYPE_NAME_TIMESTAMP: {
+            auto unitEnum = datatype::GetUnitFromString(spec.mUnit);
+            std::string timezone{ spec.mTimezone };
+            switch (unitEnum) {
+                case datatype::DATE_TIME_UNIT_SECOND:
+                    resultType =
+                        arrow::timestamp(arrow::TimeUnit::SECOND, timezone);
+                    break;
+                case datatype::DATE_TIME_UNIT_MILLISECOND:
+                    resultType =
+                        arrow::timestamp(arrow::TimeUnit::MILLI, timezone);
+                    break;
+                case datatype::DATE_TIME_UNIT_MICROSECOND:
+                    resultType =
+                        arrow::timestamp(arrow::TimeUnit::MICRO, timezone);
+                    break;
+                case datatype::DATE_TIME_UNIT_NANOSECOND:
+                    resultType =
+                        arrow::timestamp(arrow::TimeUnit::NANO, timezone);
+                    break;
+                default:
+                    return arrow::Status::Invalid("unsupported unit");
+            }
+            break;
+        }
+        case datatype::TYPE_NAME_LIST:
+            resultType = arrow::list(std::move(children[0]));
+            break;
+        case datatype::TYPE_NAME_MAP:
+            resultType = arrow::map(
+                children[0]->type(), std::move(children[1]), spec.mKeySorted);
+            break;
+        case datatype::TYPE_NAME_STRUCT:
+            resultType = arrow::struct_(std::move(children));
+            break;
+        case datatype::TYPE_NAME_FIXED_SIZE_BINARY:
+            resultType = arrow::fixed_size_binary(spec.mByteWidth);
+            break;
+        case datatype::TYPE_NAME_INTERVAL: {
+            auto unitEnum = datatype::GetIntervalUnitFromString(spec.mUnit);
+            switch (unitEnum) {
+                case datatype::INTERVAL_UNIT_YEAR_MONTH:
+                    resultType = arrow::month_interval();
+                    break;
+                case datatype::INTERVAL_UNIT_DAY_TIME:
+                    resultType = arrow::day_time_interval();
+                    break;
+                case datatype::INTERVAL_UNIT_MONTH_DAY_NANO:
+                    resultType = arrow::month_day_nano_interval();
+                    break;
+                default:
+                    return arrow::Status::Invalid("unsupported unit");
+            }
+            break;
+        }
+        case datatype::TYPE_NAME_DURATION: {
+            auto unitEnum = datatype::GetUnitFromString(spec.mUnit);
+            switch (unitEnum) {
+                case datatype::DATE_TIME_UNIT_SECOND:
+                    resultType = arrow::duration(arrow::TimeUnit::SECOND);
+                    break;
+                case datatype::DATE_TIME_UNIT_MILLISECOND:
+                    resultType = arrow::duration(arrow::TimeUnit::MILLI);
+                    break;
+                case datatype::DATE_TIME_UNIT_MICROSECOND:
+                    resultType = arrow::duration(arrow::TimeUnit::MICRO);
+                    break;
+                case datatype::DATE_TIME_UNIT_NANOSECOND:
+                    resultType = arrow::duration(arrow::TimeUnit::NANO);
+                    break;
+                default:
+                    return arrow::Status::Invalid("unsupported unit");
+            }
+            break;
+        }
+        case datatype::TYPE_NAME_DECIMAL:
+            resultType = arrow::decimal(spec.mPrecision, spec.mScale);
+            break;
+        default:
+            return arrow::Status::Invalid("unsupported type");
+    }
+
+    if (interner != nullptr && isParametric(spec.mTypeName)) {
+        resultType = interner->Intern(resultType);
+    }
+
+    std::string fieldName{ spec.mName };
+
+    // Handle metadata
+    if (!hasMetadata) {
+        return arrow::field(std::move(fieldName), resultType);
+    }
+
+    int extKeyIdx = -1;
+    int extDataIdx = -1;
+    for (int i = 0; i < static_cast<int>(keys.size()); i++) {
+        if (keys[i] == EXTENSION_TYPE_KEY_NAME) {
+            extKeyIdx = i;
+        } else if (keys[i] == EXTENSION_METADATA_KEY_NAME) {
+            extDataIdx = i;
+        }
+    }
+
+    if (extKeyIdx == -1) {
+        return arrow::field(std::move(fieldName), resultType)
+            ->WithMetadata(arrow::KeyValueMetadata::Make(keys, values));
+    }
+
+    auto extType = arrow::GetExtensionType(values[extKeyIdx]);
+    if (extType ==
+        nullptr) { // unregistered extension type, just keep the metadata
+        return arrow::field(std::move(fieldName), resultType)
+            ->WithMetadata(arrow::KeyValueMetadata::Make(keys, values));
+    }
+
+    std::string extData{};
+    if (extDataIdx != -1) {
+        extData = values[extDataIdx];
+    }
+
+    auto deserializeResult = extType->Deserialize(resultType, extData);
+    if (deserializeResult.ok()) {
+        resultType = deserializeResult.ValueUnsafe();
+        if (interner != nullptr) {
+            resultType = interner->Intern(resultType);
+        }
+    }
+
+    return arrow::field(std::move(fieldName), resultType);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> BuildSchema(
+    std::vector<std::shared_ptr<arrow::Field>> fields,
+    bool hasMetadata,
+    const std::vector<std::string>& keys,
+    const std::vector<std::string>& values) {
+    if (!hasMetadata) {
+        return arrow::schema(std::move(fields));
+    }
+    return arrow::schema(std::move(fields))
+        ->WithMetadata(arrow::KeyValueMetadata::Make(keys, values));
+}
@@ -0,0 +1,146 @@
+#ifndef _FIELD_BUILDER_H_
+#define _FIELD_BUILDER_H_
+
+#include <arrow/result.h>
+#include <arrow/type.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DataTypes.h"
+#include "Schema_JSON_TypeInterner.h"
+
+/**
+ * TypeParam flags the members a type object carries besides its name
+ */
+enum TypeParam {
+    TYPE_PARAM_IS_SIGNED = 1 << 0,
+    TYPE_PARAM_BIT_WIDTH = 1 << 1,
+    TYPE_PARAM_PRECISION_NAME = 1 << 2, // "precision" of a floatingpoint
+    TYPE_PARAM_PRECISION = 1 << 3,      // "precision" of a decimal
+    TYPE_PARAM_SCALE = 1 << 4,
+    TYPE_PARAM_UNIT = 1 << 5,
+    TYPE_PARAM_TIMEZONE = 1 << 6,
+    TYPE_PARAM_BYTE_WIDTH = 1 << 7,
+    TYPE_PARAM_KEY_SORTED = 1 << 8,
+};
+
+/**
+ * @brief Members the type object of a type must carry
+ * @return TypeParam flags
+ */
+int RequiredTypeParams(datatype::TypeName typeName);
+
+/**
+ * @brief Json member name of a type parameter, for error messages
+ * @param[in] param A single TypeParam flag
+ */
+const char* TypeParamKey(int param);
+
+/**
+ * @brief Whether a json integer fits the int a numeric type parameter is read
+ * into. Decoders reject values which do not, rather than truncate them
+ */
+inline bool FitsTypeParam(int64_t value) {
+    return value >= std::numeric_limits<int>::min() &&
+           value <= std::numeric_limits<int>::max();
+}
+
+inline bool FitsTypeParam(uint64_t value) {
+    return value <= static_cast<uint64_t>(std::numeric_limits<int>::max());
+}
+
+/**
+ * @brief Whether the json object of a field of this type must have children
+ */
+bool HasChildren(datatype::TypeName typeName);
+
+/**
+ * @brief Whether JSONToSchema reads an element of the "children" of a field
+ * of this type: all of them for a struct, the first one for a list or a map,
+ * none for the other types. Decoders ignore the elements it does not read
+ * @param[in] index Position of the element in "children"
+ */
+bool ReadsChild(datatype::TypeName typeName, size_t index);
+
+/**
+ * FieldSpec is what the json object of a field says about it, except for its
+ * children and metadata. It is filled by the decoders (DOM or event driven)
+ * and turned into an arrow::Field by BuildField(). Strings are views into the
+ * decoder's storage
+ *
+ * mName: field name
+ * mTypeName: type name
+ * mIsSigned: "isSigned" of an int
+ * mBitWidth: "bitWidth" of an int or a time
+ * mPrecisionName: "precision" of a floatingpoint
+ * mPrecision: "precision" of a decimal
+ * mScale: "scale" of a decimal
+ * mUnit: "unit" of a date, time, timestamp, interval or duration
+ * mTimezone: "timezone" of a timestamp
+ * mByteWidth: "byteWidth" of a fixedsizebinary
+ * mKeySorted: "keySorted" of a map
+ */
+struct FieldSpec {
+    std::string_view mName{};
+    datatype::TypeName mTypeName{};
+    bool mIsSigned{};
+    int mBitWidth{};
+    std::string_view mPrecisionName{};
+    int mPrecision{};
+    int mScale{};
+    std::string_view mUnit{};
+    std::string_view mTimezone{};
+    int mByteWidth{};
+    bool mKeySorted{};
+};
+
+/**
+ * @brief Check the type of a field the way BuildField() does (known type
+ * name, supported bit width, precision and unit), without building anything.
+ * BuildField() runs it first
+ * @return OK if the type can be built, descriptive status otherwise
+ */
+arrow::Status ValidateFieldSpec(const FieldSpec& spec);
+
+/**
+ * @brief Build an arrow::Field once its children are converted
+ * @param[in] spec What the field's json object says about it
+ * @param[in] children Converted children: the element of a list, the key and
+ * item of a map, the fields of a struct. They are moved into the result
+ * @param[in] hasMetadata Whether the field's json object has a metadata array
+ * @param[in] keys Metadata keys
+ * @param[in] values Metadata values
+ * @param[in] interner Interning table the type of the field is looked up in,
+ * nullptr if it is not interned
+ * @return arrow::Result contains the converted arrow::Field if successful,
+ * descriptive status otherwise
+ */
+arrow::Result<std::shared_ptr<arrow::Field>> BuildField(
+    const FieldSpec& spec,
+    std::vector<std::shared_ptr<arrow::Field>>& children,
+    bool hasMetadata,
+    const std::vector<std::string>& keys,
+    const std::vector<std::string>& values,
+    converter::TypeInterner* interner = nullptr);
+
+/**
+ * @brief Build an arrow::Schema from its converted fields
+ * @param[in] fields Converted fields
+ * @param[in] hasMetadata Whether the schema's json object has a metadata array
+ * @param[in] keys Metadata keys
+ * @param[in] values Metadata values
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise
+ */
+arrow::Result<std::shared_ptr<arrow::Schema>> BuildSchema(
+    std::vector<std::shared_ptr<arrow::Field>> fields,
+    bool hasMetadata,
+    const std::vector<std::string>& keys,
+    const std::vector<std::string>& values);
+
+#endif // _FIELD_BUILDER_H_
@@ -0,0 +1,508 @@
+#include "JSONPushParser.h"
+
+#include <charconv>
+#include <cstdlib>
+
+#include "SchemaSaxHandler.h"
+
+/**
+ * NumberKind is what the text of a number is, if it is one
+ */
+enum NumberKind {
+    NUMBER_INVALID,
+    NUMBER_INTEGER,
+    NUMBER_FLOAT,
+};
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief Whether a character may continue a number. The token is checked
+ * against the number grammar once complete
+ */
+static bool isNumberChar(char c) {
+    return isDigit(c) || c == '.' || c == 'e' || c == 'E' || c == '+' ||
+           c == '-';
+}
+
+/**
+ * @brief Check a token against the json number grammar:
+ * -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+static NumberKind numberKind(std::string_view text) {
+    size_t i = 0;
+    size_t size = text.size();
+    auto digits = [&]() {
+        size_t start = i;
+        while (i < size && isDigit(text[i])) {
+            i++;
+        }
+        return i > start;
+    };
+
+    if (i < size && text[i] == '-') {
+        i++;
+    }
+    if (i < size && text[i] == '0') {
+        i++;
+    } else if (!digits()) {
+        return NUMBER_INVALID;
+    }
+    auto kind = NUMBER_INTEGER;
+    if (i < size && text[i] == '.') {
+        i++;
+        if (!digits()) {
+            return NUMBER_INVALID;
+        }
+        kind = NUMBER_FLOAT;
+    }
+    if (i < size && (text[i] == 'e' || text[i] == 'E')) {
+        i++;
+        if (i < size && (text[i] == '+' || text[i] == '-')) {
+            i++;
+        }
+        if (!digits()) {
+            return NUMBER_INVALID;
+        }
+        kind = NUMBER_FLOAT;
+    }
+    return i == size ? kind : NUMBER_INVALID;
+}
+
+/**
+ * UTF-8 byte order mark
+ */
+static constexpr unsigned char kBom[] = { 0xEF, 0xBB, 0xBF };
+
+JSONPushParser::JSONPushParser(SchemaSaxHandler* handler)
+    : mHandler{ handler } {}
+
+void JSONPushParser::Reset() {
+    mBomBytes = 0;
+    mContainers.clear();
+    mExpect = EXPECT_VALUE;
+    mToken = TOKEN_NONE;
+    mText.clear();
+    mHighSurrogate = 0;
+    mUtf8Pending = 0;
+    mOffset = 0;
+    mStatus = arrow::Status::OK();
+}
+
+bool JSONPushParser::fail(const char* message) {
+    if (mStatus.ok()) {
+        mStatus = arrow::Status::Invalid(
+            "syntax error at byte ", mOffset + mPos, ": ", message);
+    }
+    return false;
+}
+
+bool JSONPushParser::rejected() {
+    mStatus = mHandler->CurrentStatus();
+    if (mStatus.ok()) {
+        mStatus = arrow::Status::Invalid("document rejected");
+    }
+    return false;
+}
+
+bool JSONPushParser::valueDone() {
+    mExpect = mContainers.empty() ? EXPECT_DONE : EXPECT_COMMA_OR_END;
+    return true;
+}
+
+arrow::Status JSONPushParser::Feed(std::string_view chunk) {
+    if (!mStatus.ok()) {
+        return mStatus;
+    }
+
+    mPos = 0;
+    // a leading UTF-8 byte order mark is skipped, as sax_parse skips it. It
+    // may be split across chunks too
+    while (mBomBytes < kBomSize && mPos < chunk.size()) {
+        if (static_cast<unsigned char>(chunk[mPos]) != kBom[mBomBytes]) {
+            if (mBomBytes > 0) {
+                fail("invalid byte order mark");
+                return mStatus;
+            }
+            mBomBytes = kBomSize;
+            break;
+        }
+        mBomBytes++;
+        mPos++;
+    }
+    while (mPos < chunk.size()) {
+        char c = chunk[mPos];
+        switch (mToken) {
+            case TOKEN_STRING:
+                if (!readString(chunk)) {
+                    return mStatus;
+                }
+                continue;
+            case TOKEN_ESCAPE:
+                if (!readEscape(c)) {
+                    return mStatus;
+                }
+                mPos++;
+                continue;
+            case TOKEN_UNICODE:
+                if (!readUnicode(c)) {
+                    return mStatus;
+                }
+                mPos++;
+                continue;
+            case TOKEN_NUMBER:
+                if (isNumberChar(c)) {
+                    mText.push_back(c);
+                    mPos++;
+                    continue;
+                }
+                if (!endNumber()) {
+                    return mStatus;
+                }
+                break;
+            case TOKEN_LITERAL:
+                if (c >= 'a' && c <= 'z') {
+                    mText.push_back(c);
+                    mPos++;
+                    continue;
+                }
+                if (!endLiteral()) {
+                    return mStatus;
+                }
+                break;
+            default:
+                break;
+        }
+
+        // between tokens
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r' &&
+            !structural(c)) {
+            return mStatus;
+        }
+        mPos++;
+    }
+    mOffset += chunk.size();
+    mPos = 0;
+    return arrow::Status::OK();
+}
+
+arrow::Status JSONPushParser::Finish() {
+    if (!mStatus.ok()) {
+        return mStatus;
+    }
+    switch (mToken) {
+        case TOKEN_NUMBER:
+            endNumber();
+            break;
+        case TOKEN_LITERAL:
+            endLiteral();
+            break;
+        case TOKEN_NONE:
+            break;
+        default:
+            fail("unterminated string");
+            break;
+    }
+    if (mStatus.ok() && mExpect != EXPECT_DONE) {
+        fail("incomplete document");
+    }
+    return mStatus;
+}
+
+bool JSONPushParser::structural(char c) {
+    bool expectValue =
+        mExpect == EXPECT_VALUE || mExpect == EXPECT_VALUE_OR_END;
+    char container = mContainers.empty() ? '\0' : mContainers.back();
+    switch (c) {
+        case '{':
+            if (!expectValue) {
+                return fail("unexpected '{'");
+            }
+            if (!mHandler->start_object(static_cast<std::size_t>(-1))) {
+                return rejected();
+            }
+            mContainers.push_back('{');
+            mExpect = EXPECT_KEY_OR_END;
+            return true;
+        case '[':
+            if (!expectValue) {
+                return fail("unexpected '['");
+            }
+            if (!mHandler->start_array(static_cast<std::size_t>(-1))) {
+                return rejected();
+            }
+            mContainers.push_back('[');
+            mExpect = EXPECT_VALUE_OR_END;
+            return true;
+        case '}':
+            if (container != '{' || (mExpect != EXPECT_KEY_OR_END &&
+                                     mExpect != EXPECT_COMMA_OR_END)) {
+                return fail("unexpected '}'");
+            }
+            if (!mHandler->end_object()) {
+                return rejected();
+            }
+            mContainers.pop_back();
+            return valueDone();
+        case ']':
+            if (container != '[' || (mExpect != EXPECT_VALUE_OR_END &&
+                                     mExpect != EXPECT_COMMA_OR_END)) {
+                return fail("unexpected ']'");
+            }
+            if (!mHandler->end_array()) {
+                return rejected();
+            }
+            mContainers.pop_back();
+            return valueDone();
+        case ':':
+            if (mExpect != EXPECT_COLON) {
+                return fail("unexpected ':'");
+            }
+            mExpect = EXPECT_VALUE;
+            return true;
+        case ',':
+            if (mExpect != EXPECT_COMMA_OR_END) {
+                return fail("unexpected ','");
+            }
+            mExpect = container == '{' ? EXPECT_KEY : EXPECT_VALUE;
+            return true;
+        case '"':
+            if (mExpect == EXPECT_KEY || mExpect == EXPECT_KEY_OR_END) {
+                mIsKey = true;
+            } else if (expectValue) {
+                mIsKey = false;
+            } else {
+                return fail("unexpected string");
+            }
+            mToken = TOKEN_STRING;
+            mText.clear();
+            return true;
+        default:
+            break;
+    }
+
+    if (c == '-' || isDigit(c)) {
+        mToken = TOKEN_NUMBER;
+    } else if (c == 't' || c == 'f' || c == 'n') {
+        mToken = TOKEN_LITERAL;
+    } else {
+        return fail(mExpect == EXPECT_DONE ? "trailing content"
+                                           : "unexpected character");
+    }
+    if (!expectValue) {
+        return fail(mExpect == EXPECT_DONE ? "trailing content"
+                                           : "unexpected value");
+    }
+    mText.assign(1, c);
+    return true;
+}
+
+bool JSONPushParser::readString(std::string_view chunk) {
+    size_t start = mPos;
+    auto flush = [&]() { mText.append(chunk.data() + start, mPos - start); };
+    while (mPos < chunk.size()) {
+        auto c = static_cast<unsigned char>(chunk[mPos]);
+        if (mUtf8Pending > 0) {
+            if (c < mUtf8Lower || c > mUtf8Upper) {
+                return fail("invalid UTF-8 in string");
+            }
+            mUtf8Pending--;
+            mUtf8Lower = 0x80;
+            mUtf8Upper = 0xBF;
+            mPos++;
+            continue;
+        }
+        if (mHighSurrogate != 0 && c != '\\') {
+            return fail("unpaired UTF-16 surrogate");
+        }
+        if (c == '"') {
+            flush();
+            mPos++;
+            return endString();
+        }
+        if (c == '\\') {
+            flush();
+            mPos++;
+            mToken = TOKEN_ESCAPE;
+            return true;
+        }
+        if (c < 0x20) {
+            return fail("control character in string");
+        }
+        if (c >= 0x80) {
+            // expected continuation bytes, per Unicode table 3-7
+            mUtf8Lower = 0x80;
+            mUtf8Upper = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF) {
+                mUtf8Pending = 1;
+            } else if (c >= 0xE0 && c <= 0xEF) {
+                mUtf8Pending = 2;
+                mUtf8Lower = c == 0xE0 ? 0xA0 : 0x80;
+                mUtf8Upper = c == 0xED ? 0x9F : 0xBF;
+            } else if (c >= 0xF0 && c <= 0xF4) {
+                mUtf8Pending = 3;
+                mUtf8Lower = c == 0xF0 ? 0x90 : 0x80;
+                mUtf8Upper = c == 0xF4 ? 0x8F : 0xBF;
+            } else {
+                return fail("invalid UTF-8 in string");
+            }
+        }
+        mPos++;
+    }
+    flush();
+    return true;
+}
+
+bool JSONPushParser::readEscape(char c) {
+    if (mHighSurrogate != 0 && c != 'u') {
+        return fail("unpaired UTF-16 surrogate");
+    }
+    mToken = TOKEN_STRING;
+    switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            mText.push_back(c);
+            return true;
+        case 'b':
+            mText.push_back('\b');
+            return true;
+        case 'f':
+            mText.push_back('\f');
+            return true;
+        case 'n':
+            mText.push_back('\n');
+            return true;
+        case 'r':
+            mText.push_back('\r');
+            return true;
+        case 't':
+            mText.push_back('\t');
+            return true;
+        case 'u':
+            mToken = TOKEN_UNICODE;
+            mCodePoint = 0;
+            mDigits = 0;
+            return true;
+        default:
+            return fail("invalid escape sequence");
+    }
+}
+
+bool JSONPushParser::readUnicode(char c) {
+    uint32_t digit = 0;
+    if (isDigit(c)) {
+        digit = static_cast<uint32_t>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+        digit = static_cast<uint32_t>(c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+        digit = static_cast<uint32_t>(c - 'A' + 10);
+    } else {
+        return fail("invalid \\u escape");
+    }
+    mCodePoint = mCodePoint * 16 + digit;
+    if (++mDigits < 4) {
+        return true;
+    }
+
+    mToken = TOKEN_STRING;
+    bool isHigh = mCodePoint >= 0xD800 && mCodePoint <= 0xDBFF;
+    bool isLow = mCodePoint >= 0xDC00 && mCodePoint <= 0xDFFF;
+    if (mHighSurrogate != 0) {
+        if (!isLow) {
+            return fail("unpaired UTF-16 surrogate");
+        }
+        appendCodePoint(0x10000 + ((mHighSurrogate - 0xD800) << 10) +
+                        (mCodePoint - 0xDC00));
+        mHighSurrogate = 0;
+    } else if (isHigh) {
+        mHighSurrogate = mCodePoint;
+    } else if (isLow) {
+        return fail("unpaired UTF-16 surrogate");
+    } else {
+        appendCodePoint(mCodePoint);
+    }
+    return true;
+}
+
+void JSONPushParser::appendCodePoint(uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        mText.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        mText.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        mText.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        mText.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        mText.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        mText.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        mText.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        mText.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        mText.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        mText.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+bool JSONPushParser::endString() {
+    mToken = TOKEN_NONE;
+    if (mIsKey) {
+        if (!mHandler->key(mText)) {
+            return rejected();
+        }
+        mExpect = EXPECT_COLON;
+        return true;
+    }
+    if (!mHandler->string(mText)) {
+        return rejected();
+    }
+    return valueDone();
+}
+
+bool JSONPushParser::endNumber() {
+    mToken = TOKEN_NONE;
+    auto kind = numberKind(mText);
+    if (kind == NUMBER_INVALID) {
+        return fail("invalid number");
+    }
+
+    bool accepted = false;
+    const char* begin = mText.data();
+    const char* end = begin + mText.size();
+    if (kind == NUMBER_INTEGER) {
+        // integers that do not fit in 64 bits are reported as floats
+        if (mText[0] == '-') {
+            int64_t value = 0;
+            auto result = std::from_chars(begin, end, value);
+            if (result.ec == std::errc{}) {
+                accepted = mHandler->number_integer(value);
+                return accepted ? valueDone() : rejected();
+            }
+        } else {
+            uint64_t value = 0;
+            auto result = std::from_chars(begin, end, value);
+            if (result.ec == std::errc{}) {
+                accepted = mHandler->number_unsigned(value);
+                return accepted ? valueDone() : rejected();
+            }
+        }
+    }
+    accepted = mHandler->number_float(std::strtod(begin, nullptr), mText);
+    return accepted ? valueDone() : rejected();
+}
+
+bool JSONPushParser::endLiteral() {
+    mToken = TOKEN_NONE;
+    bool accepted = false;
+    if (mText == "true") {
+        accepted = mHandler->boolean(true);
+    } else if (mText == "false") {
+        accepted = mHandler->boolean(false);
+    } else if (mText == "null") {
+        accepted = mHandler->null();
+    } else {
+        return fail("invalid literal");
+    }
+    return accepted ? valueDone() : rejected();
+}
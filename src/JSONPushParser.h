@@ -0,0 +1,121 @@
+#ifndef _JSON_PUSH_PARSER_H_
+#define _JSON_PUSH_PARSER_H_
+
+#include <arrow/status.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SchemaSaxHandler;
+
+/**
+ * JSONPushParser is a resumable json tokenizer: text is pushed in chunks of
+ * any size, split anywhere (even inside a string, an escape sequence, a
+ * multi-byte character or a number), and turned into the SAX events of a
+ * SchemaSaxHandler as soon as they are complete. Only the token being read
+ * and the stack of open containers are kept between chunks.
+ *
+ * It accepts what nlohmann::json::sax_parse() accepts (RFC 8259, strings
+ * checked to be valid UTF-8, a leading UTF-8 byte order mark skipped) and
+ * reports numbers the same way: integers as number_integer or number_unsigned
+ * while they fit, number_float otherwise.
+ *
+ * mHandler: receiver of the events
+ * mBomBytes: bytes of a leading byte order mark read so far, kBomSize once
+ * the document is past it (or has none)
+ * mContainers: open containers, innermost last ('{' or '[')
+ * mExpect: what may come next
+ * mToken: kind of token being read
+ * mText: characters of the token being read (string contents unescaped)
+ * mIsKey: whether the string being read is an object key
+ * mCodePoint: code point of the \u escape being read
+ * mHighSurrogate: first half of a surrogate pair, 0 if none
+ * mDigits: hex digits of the \u escape read so far
+ * mUtf8Pending: continuation bytes the current character still needs
+ * mUtf8Lower, mUtf8Upper: range of the next continuation byte
+ * mOffset: bytes of the previous chunks, for error messages
+ * mPos: position in the chunk being parsed
+ * mStatus: first error, the parser ignores its input from then on
+ */
+class JSONPushParser {
+public:
+    /**
+     * @param[in] handler Receiver of the events, must outlive the parser
+     */
+    explicit JSONPushParser(SchemaSaxHandler* handler);
+
+    /**
+     * @brief Forget the current document, keeping the scratch storage. The
+     * handler is reset separately
+     */
+    void Reset();
+
+    /**
+     * @brief Parse the next chunk of the text
+     * @return OK if the text is valid so far and accepted by the handler,
+     * descriptive status otherwise (the same status on every later call)
+     */
+    arrow::Status Feed(std::string_view chunk);
+
+    /**
+     * @brief Tell the parser the text is complete: ends a trailing number
+     * @return OK if the text is one complete json value, descriptive status
+     * otherwise
+     */
+    arrow::Status Finish();
+
+private:
+    enum Expect {
+        EXPECT_VALUE,         // document start, after ':' or ',' in an array
+        EXPECT_VALUE_OR_END,  // after '['
+        EXPECT_KEY,           // after ',' in an object
+        EXPECT_KEY_OR_END,    // after '{'
+        EXPECT_COLON,         // after a key
+        EXPECT_COMMA_OR_END,  // after a value in a container
+        EXPECT_DONE,          // after the top-level value
+    };
+
+    enum Token {
+        TOKEN_NONE,
+        TOKEN_STRING,
+        TOKEN_ESCAPE,   // after a backslash in a string
+        TOKEN_UNICODE,  // in the hex digits of a \u escape
+        TOKEN_NUMBER,
+        TOKEN_LITERAL,  // true, false or null
+    };
+
+    bool fail(const char* message);
+    bool rejected();
+    bool valueDone();
+    bool structural(char c);
+    bool readString(std::string_view chunk);
+    bool readEscape(char c);
+    bool readUnicode(char c);
+    bool endString();
+    bool endNumber();
+    bool endLiteral();
+    void appendCodePoint(uint32_t codePoint);
+
+    static constexpr int kBomSize = 3;
+
+    SchemaSaxHandler* mHandler;
+    int mBomBytes{};
+    std::vector<char> mContainers{};
+    Expect mExpect{ EXPECT_VALUE };
+    Token mToken{ TOKEN_NONE };
+    std::string mText{};
+    bool mIsKey{};
+    uint32_t mCodePoint{};
+    uint32_t mHighSurrogate{};
+    int mDigits{};
+    int mUtf8Pending{};
+    unsigned char mUtf8Lower{};
+    unsigned char mUtf8Upper{};
+    uint64_t mOffset{};
+    size_t mPos{};
+    arrow::Status mStatus{};
+};
+
+#endif // _JSON_PUSH_PARSER_H_
@@ -0,0 +1,246 @@
+#ifndef _JSON_WRITER_H_
+#define _JSON_WRITER_H_
+
+#include <arrow/io/interfaces.h>
+#include <arrow/status.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * JSONWriter emits JSON text token by token into a growable byte buffer. The
+ * output is byte-identical to nlohmann::json::dump() with default arguments,
+ * as long as the caller emits object keys in lexicographical order (which is
+ * how nlohmann::json stores them).
+ *
+ * If a sink is given, the buffer is flushed into it whenever it grows past
+ * kFlushThreshold, so the whole text is never staged in memory.
+ *
+ * Container sizes given to StartObject/StartArray are ignored, they are only
+ * needed by the length-prefixed binary writers (see BinaryWriter.h).
+ *
+ * mBuffer: output buffer, owned by the caller
+ * mSink: optional output stream the buffer is flushed into
+ * mNeedComma: whether the next key/value has to be preceded by a comma
+ * mStatus: first error encountered (invalid UTF-8, sink failure)
+ */
+class JSONWriter {
+public:
+    using Buffer = std::string;
+
+    static constexpr size_t kFlushThreshold = 64 * 1024;
+
+    explicit JSONWriter(std::string* buffer,
+                        arrow::io::OutputStream* sink = nullptr)
+        : mBuffer{ buffer }
+        , mSink{ sink } {};
+
+    ~JSONWriter() = default;
+
+    void StartObject(size_t = 0) {
+        separate();
+        mBuffer->push_back('{');
+        mNeedComma = false;
+    }
+
+    void EndObject() {
+        mBuffer->push_back('}');
+        mNeedComma = true;
+        maybeFlush();
+    }
+
+    void StartArray(size_t = 0) {
+        separate();
+        mBuffer->push_back('[');
+        mNeedComma = false;
+    }
+
+    void EndArray() {
+        mBuffer->push_back(']');
+        mNeedComma = true;
+        maybeFlush();
+    }
+
+    void Key(std::string_view key) {
+        separate();
+        appendEscaped(key);
+        mBuffer->push_back(':');
+        mNeedComma = false;
+    }
+
+    void String(std::string_view value) {
+        separate();
+        appendEscaped(value);
+        mNeedComma = true;
+    }
+
+    void Int(int64_t value) {
+        separate();
+        mBuffer->append(std::to_string(value));
+        mNeedComma = true;
+    }
+
+    void Bool(bool value) {
+        separate();
+        mBuffer->append(value ? "true" : "false");
+        mNeedComma = true;
+    }
+
+    void Null() {
+        separate();
+        mBuffer->append("null");
+        mNeedComma = true;
+    }
+
+    /**
+     * @brief Append already serialized JSON text as is
+     * @param[in] value Serialized value (or comma-separated run of values
+     * inside an array), must be valid JSON text. Empty input is skipped
+     */
+    void RawValue(std::string_view value) {
+        if (value.empty()) {
+            return;
+        }
+        separate();
+        mBuffer->append(value);
+        mNeedComma = true;
+        maybeFlush();
+    }
+
+    /**
+     * @brief Flush the remaining bytes into the sink (if any)
+     * @return First error encountered while writing, OK otherwise
+     */
+    arrow::Status Finish() {
+        if (mStatus.ok() && mSink != nullptr && !mBuffer->empty()) {
+            mStatus = mSink->Write(mBuffer->data(), mBuffer->size());
+            mBuffer->clear();
+        }
+        return mStatus;
+    }
+
+    const arrow::Status& status() const { return mStatus; }
+
+private:
+    void separate() {
+        if (mNeedComma) {
+            mBuffer->push_back(',');
+        }
+    }
+
+    void maybeFlush() {
+        if (mSink == nullptr || mBuffer->size() < kFlushThreshold ||
+            !mStatus.ok()) {
+            return;
+        }
+        mStatus = mSink->Write(mBuffer->data(), mBuffer->size());
+        mBuffer->clear();
+    }
+
+    /**
+     * @brief Append a quoted string, escaped the same way nlohmann::json does
+     * (control characters, quotation mark and reverse solidus only). Invalid
+     * UTF-8 is reported through mStatus, as nlohmann::json::dump() throws on it
+     */
+    void appendEscaped(std::string_view str) {
+        static const char kHex[] = "0123456789abcdef";
+
+        mBuffer->push_back('"');
+        size_t i = 0;
+        while (i < str.size()) {
+            auto byte = static_cast<uint8_t>(str[i]);
+            if (byte >= 0x80) {
+                size_t length = utf8SequenceLength(str, i);
+                if (length == 0) {
+                    if (mStatus.ok()) {
+                        mStatus = arrow::Status::Invalid(
+                            "invalid UTF-8 byte at index ", i);
+                    }
+                    length = 1;
+                }
+                mBuffer->append(str.data() + i, length);
+                i += length;
+                continue;
+            }
+
+            switch (byte) {
+                case '\b':
+                    mBuffer->append("\\b");
+                    break;
+                case '\t':
+                    mBuffer->append("\\t");
+                    break;
+                case '\n':
+                    mBuffer->append("\\n");
+                    break;
+                case '\f':
+                    mBuffer->append("\\f");
+                    break;
+                case '\r':
+                    mBuffer->append("\\r");
+                    break;
+                case '"':
+                    mBuffer->append("\\\"");
+                    break;
+                case '\\':
+                    mBuffer->append("\\\\");
+                    break;
+                default:
+                    if (byte <= 0x1F) {
+                        mBuffer->append("\\u00");
+                        mBuffer->push_back(kHex[byte >> 4]);
+                        mBuffer->push_back(kHex[byte & 0xF]);
+                    } else {
+                        mBuffer->push_back(static_cast<char>(byte));
+                    }
+                    break;
+            }
+            i++;
+        }
+        mBuffer->push_back('"');
+    }
+
+    /**
+     * @brief Length of the well-formed UTF-8 sequence starting at str[pos]
+     * @return Sequence length (2-4), 0 if the sequence is ill-formed
+     */
+    static size_t utf8SequenceLength(std::string_view str, size_t pos) {
+        auto at = [&](size_t offset) -> int {
+            return pos + offset < str.size()
+                       ? static_cast<uint8_t>(str[pos + offset])
+                       : -1;
+        };
+        auto inRange = [](int byte, int low, int high) {
+            return byte >= low && byte <= high;
+        };
+
+        int lead = at(0);
+        if (inRange(lead, 0xC2, 0xDF)) {
+            return inRange(at(1), 0x80, 0xBF) ? 2 : 0;
+        }
+        if (inRange(lead, 0xE0, 0xEF)) {
+            int low = lead == 0xE0 ? 0xA0 : 0x80;
+            int high = lead == 0xED ? 0x9F : 0xBF;
+            return inRange(at(1), low, high) && inRange(at(2), 0x80, 0xBF)
+                       ? 3
+                       : 0;
+        }
+        if (inRange(lead, 0xF0, 0xF4)) {
+            int low = lead == 0xF0 ? 0x90 : 0x80;
+            int high = lead == 0xF4 ? 0x8F : 0xBF;
+            return inRange(at(1), low, high) && inRange(at(2), 0x80, 0xBF) &&
+                           inRange(at(3), 0x80, 0xBF)
+                       ? 4
+                       : 0;
+        }
+        return 0;
+    }
+
+    std::string* mBuffer{};
+    arrow::io::OutputStream* mSink{};
+    bool mNeedComma{};
+    arrow::Status mStatus{};
+};
+
+#endif // _JSON_WRITER_H_
@@ -1,363 +1,1578 @@
 #include "Schema_JSON_Conversion.h"
+#include "Schema_JSON_Converter.h"
+#include "Schema_JSON_Index.h"
+#include "Schema_JSON_LazySchema.h"
 
-#include <arrow/extension_type.h>
-#include <arrow/util/key_value_metadata.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 
 #include "DataTypes.h"
+#include "FieldBuilder.h"
+#include "Parallel.h"
+#include "SchemaSaxHandler.h"
 
 /**
- * @brief Helper function converts a json object into arrow::Field
- * @param[in] schema Input json object
- * @return arrow::Result contains the converted arrow::Field if successful,
- * descriptive status otherwise
+ * ProjectionNode is a ProjectionSpec turned into a tree of names: a node
+ * stands for a field, its children for the selected children of the field
+ *
+ * mAll: whether the whole field is selected, mChildren being ignored
+ * mChildren: selected children by name
  */
-static arrow::Result<std::shared_ptr<arrow::Field>> unmarshalJSON(
-    const json& jsonObj);
-
-arrow::Result<std::shared_ptr<arrow::Schema>> converter::JSONToSchema(
-    const json& jsonObj) {
-    auto schemaJson = jsonObj.at("schema");
-    std::vector<std::shared_ptr<arrow::Field>> fields{};
+struct ProjectionNode {
+    bool mAll{};
+    std::map<std::string, ProjectionNode, std::less<>> mChildren{};
+};
 
-    for (auto fieldJson : schemaJson.at("fields")) {
-        auto field = unmarshalJSON(fieldJson);
-        if (!field.ok()) {
-            return field.status();
+/**
+ * @brief Build the tree of a projection, the root standing for the schema
+ */
+static arrow::Result<ProjectionNode> makeProjection(
+    const converter::ProjectionSpec& projection) {
+    ProjectionNode root{};
+    for (const auto& path : projection.paths) {
+        auto* node = &root;
+        std::string_view rest = path;
+        while (!node->mAll) {
+            auto dot = rest.find('.');
+            auto name = rest.substr(0, dot);
+            if (name.empty()) {
+                return arrow::Status::Invalid("empty name in path ", path);
+            }
+            node = &node->mChildren[std::string{ name }];
+            if (dot == std::string_view::npos) {
+                node->mAll = true;
+                node->mChildren.clear();
+                break;
+            }
+            rest.remove_prefix(dot + 1);
         }
-        fields.push_back(std::move(field).ValueOrDie());
     }
+    return root;
+}
+
+/**
+ * Selection is how much of a child field a projection keeps
+ */
+enum Selection {
+    SELECTION_NONE,
+    SELECTION_ALL,
+    SELECTION_PART,
+};
+
+/**
+ * @brief Look up a child in the node of its parent
+ * @param[in] node Node of the parent, nullptr if it is selected whole
+ * @param[out] child Node of the child if it is partly selected, nullptr
+ * otherwise
+ */
+static Selection selectChild(const ProjectionNode* node,
+                             std::string_view name,
+                             const ProjectionNode*& child) {
+    child = nullptr;
+    if (node == nullptr) {
+        return SELECTION_ALL;
+    }
+    auto item = node->mChildren.find(name);
+    if (item == node->mChildren.end()) {
+        return SELECTION_NONE;
+    }
+    if (item->second.mAll) {
+        return SELECTION_ALL;
+    }
+    child = &item->second;
+    return SELECTION_PART;
+}
+
+/**
+ * Malformed documents are reported without throwing: every member is looked
+ * up with find() and checked with is_*() before it is read. Errors name the
+ * offending value by its JSON pointer (RFC 6901), e.g.
+ * "/schema/fields/3/type/bitWidth: expected an integer". The pointer is built
+ * from the innermost value outwards, each caller prefixing the status with
+ * the path of the value it passed down, so nothing is spent on paths unless
+ * the decoding fails.
+ */
+
+/**
+ * @brief Prefix an error with the path of the value it was found in
+ */
+static arrow::Status atPath(const arrow::Status& status,
+                            std::string_view path) {
+    if (status.ok() || path.empty()) {
+        return status;
+    }
+    const auto& message = status.message();
+    if (!message.empty() && message[0] == '/') {
+        return status.WithMessage(path, message);
+    }
+    return status.WithMessage(path, ": ", message);
+}
 
-    if (!schemaJson.contains("metadata")) {
-        return arrow::schema(fields);
+/**
+ * @brief Look up a member of a json object
+ */
+template <typename JSON>
+static arrow::Status findMember(const JSON& object,
+                                const char* key,
+                                const JSON*& member) {
+    if (!object.is_object()) {
+        return arrow::Status::Invalid("expected an object");
+    }
+    auto item = object.find(key);
+    if (item == object.end()) {
+        return arrow::Status::Invalid("/", key, ": missing");
     }
+    member = &*item;
+    return arrow::Status::OK();
+}
 
-    std::vector<std::string> keys{};
-    std::vector<std::string> values{};
-    auto metadata = schemaJson.at("metadata");
+template <typename JSON>
+static arrow::Status findArray(const JSON& object,
+                               const char* key,
+                               const JSON*& member) {
+    auto status = findMember(object, key, member);
+    if (status.ok() && !member->is_array()) {
+        return arrow::Status::Invalid("/", key, ": expected an array");
+    }
+    return status;
+}
+
+/**
+ * @brief Read a string member of a json object without a copy
+ */
+template <typename JSON>
+static arrow::Status getString(const JSON& object,
+                               const char* key,
+                               std::string_view& value) {
+    const JSON* member = nullptr;
+    auto status = findMember(object, key, member);
+    if (!status.ok()) {
+        return status;
+    }
+    if (!member->is_string()) {
+        return arrow::Status::Invalid("/", key, ": expected a string");
+    }
+    value = member->template get_ref<const std::string&>();
+    return arrow::Status::OK();
+}
+
+template <typename JSON>
+static arrow::Status getInt(const JSON& object, const char* key, int& value) {
+    const JSON* member = nullptr;
+    auto status = findMember(object, key, member);
+    if (!status.ok()) {
+        return status;
+    }
+    if (!member->is_number_integer()) {
+        return arrow::Status::Invalid("/", key, ": expected an integer");
+    }
+    // get<int>() would wrap values which do not fit
+    bool fits = member->is_number_unsigned()
+                    ? FitsTypeParam(member->template get<uint64_t>())
+                    : FitsTypeParam(member->template get<int64_t>());
+    if (!fits) {
+        return arrow::Status::Invalid("/", key, ": integer out of range");
+    }
+    value = member->template get<int>();
+    return arrow::Status::OK();
+}
 
-    for (auto item : metadata) {
-        keys.push_back(item.at("key"));
-        values.push_back(item.at("value"));
+template <typename JSON>
+static arrow::Status getBool(const JSON& object, const char* key, bool& value) {
+    const JSON* member = nullptr;
+    auto status = findMember(object, key, member);
+    if (!status.ok()) {
+        return status;
+    }
+    if (!member->is_boolean()) {
+        return arrow::Status::Invalid("/", key, ": expected a boolean");
     }
+    value = member->template get<bool>();
+    return arrow::Status::OK();
+}
 
-    return arrow::schema(fields)->WithMetadata(
-        arrow::KeyValueMetadata::Make(keys, values));
+/**
+ * @brief Path of the i-th top-level field of a document
+ */
+static std::string fieldPath(size_t index) {
+    return "/schema/fields/" + std::to_string(index);
 }
 
+/**
+ * UnmarshalFrame is a field whose children are being converted by the
+ * iterative traversal. Frames are reused from one field to the next, so the
+ * children vectors of lists and maps keep their capacity
+ *
+ * mJson: json object of the field
+ * mTypeJson: "type" object of the field
+ * mChildrenJson: "children" array of the field (its first entry for a map),
+ * nullptr if the type has no children
+ * mTypeName: type name of the field
+ * mChildren: children converted so far
+ * mNumChildren: number of children in json
+ * mNextChild: index of the next child to visit
+ * mProjection: selected children, nullptr if the field is selected whole
+ * mDropped: whether the projection selects nothing in the field
+ */
+template <typename JSON>
+struct UnmarshalFrame {
+    const JSON* mJson{};
+    const JSON* mTypeJson{};
+    const JSON* mChildrenJson{};
+    datatype::TypeName mTypeName{};
+    std::vector<std::shared_ptr<arrow::Field>> mChildren{};
+    size_t mNumChildren{};
+    size_t mNextChild{};
+    const ProjectionNode* mProjection{};
+    bool mDropped{};
+};
+
+/**
+ * DecodeScratch is the working storage of a decoding, reused across calls
+ *
+ * mStack: work stack of the field traversal, frames past the current depth
+ * are kept for reuse
+ * mFields: top-level fields converted so far
+ * mKeys: metadata keys of the object being converted
+ * mValues: metadata values of the object being converted
+ * mInterner: interning table of the converted types, nullptr if not interning
+ */
+template <typename JSON>
+struct DecodeScratch {
+    std::vector<UnmarshalFrame<JSON>> mStack{};
+    std::vector<std::shared_ptr<arrow::Field>> mFields{};
+    std::vector<std::string> mKeys{};
+    std::vector<std::string> mValues{};
+    converter::TypeInterner* mInterner{};
+};
+
+/**
+ * @brief Helper function converts a json object into arrow::Field. Nested
+ * fields are walked with an explicit work stack instead of recursion, so the
+ * nesting depth does not grow the call stack
+ * @param[in] jsonField Input json object
+ * @param[in] scratch Working storage, reused across calls
+ * @param[in] projection Selected children, nullptr to convert the whole field
+ * @return arrow::Result contains the converted arrow::Field if successful
+ * (nullptr if the projection selects nothing in it), descriptive status
+ * otherwise
+ */
+template <typename JSON>
 static arrow::Result<std::shared_ptr<arrow::Field>> unmarshalJSON(
-    const json& jsonField) {
-    std::shared_ptr<arrow::Field> resultField{};
-    std::shared_ptr<arrow::DataType> resultType{};
+    const JSON& jsonField,
+    DecodeScratch<JSON>& scratch,
+    const ProjectionNode* projection = nullptr);
 
-    auto fieldName = jsonField.at("name").get<std::string>();
-    auto typeNameStr = jsonField.at("type").at("name").get<std::string>();
-    auto typeNameEnum = datatype::GetTypeFromString(typeNameStr);
+/**
+ * @brief Helper function reads what the json object of a field says about it,
+ * besides its children. Metadata goes to the scratch key and value vectors
+ * @param[in] jsonField Input json object
+ * @param[in] type "type" object of the field
+ * @param[in] typeNameEnum Type name of the field
+ * @param[out] spec What is read, views into jsonField
+ * @param[out] hasMetadata Whether the field has metadata
+ * @return OK if the field is well-formed, descriptive status otherwise (path
+ * relative to the field)
+ */
+template <typename JSON>
+static arrow::Status readField(const JSON& jsonField,
+                               const JSON& type,
+                               datatype::TypeName typeNameEnum,
+                               FieldSpec& spec,
+                               bool& hasMetadata,
+                               DecodeScratch<JSON>& scratch);
 
-    switch (typeNameEnum) {
-        case datatype::TYPE_NAME_NULL:
-            resultType = arrow::null();
-            break;
-        case datatype::TYPE_NAME_BOOL:
-            resultType = arrow::boolean();
-            break;
-        case datatype::TYPE_NAME_INT: {
-            auto isSigned = jsonField.at("type").at("isSigned").get<bool>();
-            auto bitWidth = jsonField.at("type").at("bitWidth").get<int>();
-
-            if (isSigned) {
-                switch (bitWidth) {
-                    case 8:
-                        resultType = arrow::int8();
-                        break;
-                    case 16:
-                        resultType = arrow::int16();
-                        break;
-                    case 32:
-                        resultType = arrow::int32();
-                        break;
-                    case 64:
-                        resultType = arrow::int64();
-                        break;
-                    default:
-                        return arrow::Status::Invalid("unsupported bit width");
-                }
-            } else {
-                switch (bitWidth) {
-                    case 8:
-                        resultType = arrow::uint8();
-                        break;
-                    case 16:
-                        resultType = arrow::uint16();
-                        break;
-                    case 32:
-                        resultType = arrow::uint32();
-                        break;
-                    case 64:
-                        resultType = arrow::uint64();
-                        break;
-                    default:
-                        return arrow::Status::Invalid("unsupported bit width");
+/**
+ * @brief Helper function builds an arrow::Field from its json object once its
+ * children are converted
+ * @param[in] jsonField Input json object
+ * @param[in] type "type" object of the field
+ * @param[in] typeNameEnum Type name of the field
+ * @param[in] children Converted children, in the order they appear in json
+ * @param[in] scratch Working storage of the metadata, and interning table
+ * @return arrow::Result contains the converted arrow::Field if successful,
+ * descriptive status otherwise
+ */
+template <typename JSON>
+static arrow::Result<std::shared_ptr<arrow::Field>> makeField(
+    const JSON& jsonField,
+    const JSON& type,
+    datatype::TypeName typeNameEnum,
+    std::vector<std::shared_ptr<arrow::Field>>& children,
+    DecodeScratch<JSON>& scratch);
+
+/**
+ * @brief Helper function checks a json field the way unmarshalJSON converts
+ * it, in the same order, without building any arrow object
+ * @param[in] jsonField Input json object
+ * @param[in] index Index of the field in the "fields" array, for the paths
+ * @param[in] scratch Working storage, reused across calls
+ * @param[out] errors Every error found, nullptr to stop at the first one
+ * @return The first error found, OK if the field is valid
+ */
+template <typename JSON>
+static arrow::Status validateField(const JSON& jsonField,
+                                   size_t index,
+                                   DecodeScratch<JSON>& scratch,
+                                   std::vector<arrow::Status>* errors);
+
+/**
+ * @brief Helper function reads a json "metadata" array into the scratch key
+ * and value vectors. Strings are assigned in place, so their buffers are
+ * reused from one object to the next
+ * @return OK if every entry has a string key and value, descriptive status
+ * otherwise (path relative to the array)
+ */
+template <typename JSON>
+static arrow::Status readMetadata(const JSON& metadata,
+                                  DecodeScratch<JSON>& scratch) {
+    if (!metadata.is_array()) {
+        return arrow::Status::Invalid("expected an array");
+    }
+    auto& keys = scratch.mKeys;
+    auto& values = scratch.mValues;
+    keys.resize(metadata.size());
+    values.resize(metadata.size());
+    for (size_t i = 0; i < metadata.size(); i++) {
+        std::string_view key{};
+        std::string_view value{};
+        auto status = getString(metadata[i], "key", key);
+        status &= getString(metadata[i], "value", value);
+        if (!status.ok()) {
+            return atPath(status, "/" + std::to_string(i));
+        }
+        keys[i].assign(key);
+        values[i].assign(value);
+    }
+    return arrow::Status::OK();
+}
+
+/**
+ * @brief Helper function builds arrow::Schema from the "schema" object of a
+ * json document and its already converted fields
+ * @param[in] schemaJson Input "schema" object
+ * @param[in] fields Converted fields
+ * @param[in] scratch Working storage of the metadata
+ * @return arrow::Result contains the converted arrow::Schema if successful,
+ * descriptive status otherwise
+ */
+template <typename JSON>
+static arrow::Result<std::shared_ptr<arrow::Schema>> makeSchema(
+    const JSON& schemaJson,
+    std::vector<std::shared_ptr<arrow::Field>> fields,
+    DecodeScratch<JSON>& scratch) {
+    auto metadata = schemaJson.find("metadata");
+    bool hasMetadata = metadata != schemaJson.end();
+    if (hasMetadata) {
+        auto status = readMetadata(*metadata, scratch);
+        if (!status.ok()) {
+            return atPath(status, "/schema/metadata");
+        }
+    }
+    return BuildSchema(
+        std::move(fields), hasMetadata, scratch.mKeys, scratch.mValues);
+}
+
+/**
+ * @brief Look up the "schema" object of a document and its "fields" array
+ */
+template <typename JSON>
+static arrow::Status findSchema(const JSON& jsonObj,
+                                const JSON*& schemaJson,
+                                const JSON*& fieldsJson) {
+    auto status = findMember(jsonObj, "schema", schemaJson);
+    if (!status.ok()) {
+        return status;
+    }
+    return atPath(findArray(*schemaJson, "fields", fieldsJson), "/schema");
+}
+
+/**
+ * @brief Helper function converts the top-level fields of a json "fields"
+ * array on several threads. Each range of fields fills its own slots, with
+ * its own scratch storage
+ * @return The error of the first failing field in field order, OK otherwise
+ */
+template <typename JSON>
+static arrow::Status unmarshalFieldsParallel(
+    const JSON& fieldsJson,
+    const converter::JSONToSchemaOptions& options,
+    std::vector<std::shared_ptr<arrow::Field>>& fields) {
+    fields.resize(fieldsJson.size());
+    return ParallelForRanges(
+        static_cast<int>(fieldsJson.size()),
+        options.executor,
+        [&](int, int begin, int end) {
+            DecodeScratch<JSON> scratch{};
+            scratch.mInterner = options.interner;
+            for (int i = begin; i < end; i++) {
+                auto field = unmarshalJSON(fieldsJson[i], scratch);
+                if (!field.ok()) {
+                    return atPath(field.status(), fieldPath(i));
                 }
+                fields[i] = std::move(field).ValueOrDie();
             }
+            return arrow::Status::OK();
+        });
+}
 
-            break;
+/**
+ * @brief Helper function converts json of any nlohmann::basic_json
+ * instantiation into arrow::Schema
+ * @param[in] parallel Options of the parallel conversion, nullptr to convert
+ * serially
+ */
+template <typename JSON>
+static arrow::Result<std::shared_ptr<arrow::Schema>> unmarshalSchema(
+    const JSON& jsonObj,
+    DecodeScratch<JSON>& scratch,
+    const converter::JSONToSchemaOptions* parallel = nullptr) {
+    const JSON* schemaJson = nullptr;
+    const JSON* fieldsJson = nullptr;
+    auto status = findSchema(jsonObj, schemaJson, fieldsJson);
+    if (!status.ok()) {
+        return status;
+    }
+    auto& fields = scratch.mFields;
+    fields.clear();
+
+    if (parallel != nullptr && parallel->useThreads &&
+        fieldsJson->size() >=
+            static_cast<size_t>(parallel->parallelThreshold)) {
+        status = unmarshalFieldsParallel(*fieldsJson, *parallel, fields);
+        if (!status.ok()) {
+            fields.clear();
+            return status;
         }
-        case datatype::TYPE_NAME_FLOATING_POINT: {
-            auto precisionStr =
-                jsonField.at("type").at("precision").get<std::string>();
-            auto precisionEnum = datatype::GetPrecisionFromString(precisionStr);
-            switch (precisionEnum) {
-                case datatype::PRECISION_HALF:
-                    resultType = arrow::float16();
-                    break;
-                case datatype::PRECISION_SINGLE:
-                    resultType = arrow::float32();
-                    break;
-                case datatype::PRECISION_DOUBLE:
-                    resultType = arrow::float64();
-                    break;
-                default:
-                    return arrow::Status::Invalid("unsupported precision");
+    } else {
+        fields.reserve(fieldsJson->size());
+        for (size_t i = 0; i < fieldsJson->size(); i++) {
+            auto field = unmarshalJSON((*fieldsJson)[i], scratch);
+            if (!field.ok()) {
+                fields.clear();
+                return atPath(field.status(), fieldPath(i));
             }
-            break;
+            fields.push_back(std::move(field).ValueOrDie());
         }
-        case datatype::TYPE_NAME_BINARY:
-            resultType = arrow::binary();
-            break;
-        case datatype::TYPE_NAME_UTF8:
-            resultType = arrow::utf8();
-            break;
-        case datatype::TYPE_NAME_DATE: {
-            auto unitStr = jsonField.at("type").at("unit").get<std::string>();
-            auto unitEnum = datatype::GetUnitFromString(unitStr);
-            switch (unitEnum) {
-                case datatype::DATE_TIME_UNIT_DAY:
-                    resultType = arrow::date32();
-                    break;
-                case datatype::DATE_TIME_UNIT_MILLISECOND:
-                    resultType = arrow::date64();
-                    break;
-                default:
-                    return arrow::Status::Invalid("unsupported unit");
-            }
-            break;
+    }
+
+    // the schema gets its own copy of the fields, the scratch vector keeps
+    // its capacity for the next call
+    auto schema = makeSchema(*schemaJson, fields, scratch);
+    fields.clear();
+    return schema;
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::JSONToSchema(
+    const json& jsonObj,
+    const JSONToSchemaOptions& options) {
+    DecodeScratch<json> scratch{};
+    scratch.mInterner = options.interner;
+    return unmarshalSchema(jsonObj, scratch, &options);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::JSONToSchema(
+    const json& jsonObj,
+    const ProjectionSpec& projection,
+    const JSONToSchemaOptions& options) {
+    auto root = makeProjection(projection);
+    if (!root.ok()) {
+        return root.status();
+    }
+    const auto& projectionRoot = root.ValueOrDie();
+
+    DecodeScratch<json> scratch{};
+    scratch.mInterner = options.interner;
+    const json* schemaJson = nullptr;
+    const json* fieldsJson = nullptr;
+    auto status = findSchema(jsonObj, schemaJson, fieldsJson);
+    if (!status.ok()) {
+        return status;
+    }
+    auto& fields = scratch.mFields;
+    for (size_t i = 0; i < fieldsJson->size(); i++) {
+        const auto& fieldJson = (*fieldsJson)[i];
+        std::string_view name{};
+        status = getString(fieldJson, "name", name);
+        if (!status.ok()) {
+            return atPath(status, fieldPath(i));
         }
-        case datatype::TYPE_NAME_TIME: {
-            auto bitWidth = jsonField.at("type").at("bitWidth").get<int>();
-            auto unitStr = jsonField.at("type").at("unit").get<std::string>();
-            auto unitEnum = datatype::GetUnitFromString(unitStr);
-
-            switch (bitWidth) {
-                case 32:
-                    switch (unitEnum) {
-                        case datatype::DATE_TIME_UNIT_SECOND:
-                            resultType = arrow::time32(arrow::TimeUnit::SECOND);
-                            break;
-                        case datatype::DATE_TIME_UNIT_MILLISECOND:
-                            resultType = arrow::time32(arrow::TimeUnit::MILLI);
-                            break;
-                        default:
-                            return arrow::Status::Invalid("unsupported unit");
-                    }
-                    break;
-                case 64:
-                    switch (unitEnum) {
-                        case datatype::DATE_TIME_UNIT_MICROSECOND:
-                            resultType = arrow::time64(arrow::TimeUnit::MICRO);
-                            break;
-                        case datatype::DATE_TIME_UNIT_NANOSECOND:
-                            resultType = arrow::time64(arrow::TimeUnit::NANO);
-                            break;
-                        default:
-                            return arrow::Status::Invalid("unsupported unit");
-                    }
-                    break;
-                default:
-                    return arrow::Status::Invalid("unsupported bit width");
-            }
-            break;
+        const ProjectionNode* node = nullptr;
+        if (selectChild(&projectionRoot, name, node) == SELECTION_NONE) {
+            continue;
         }
-        case datatype::TYPE_NAME_TIMESTAMP: {
-            auto unitStr = jsonField.at("type").at("unit").get<std::string>();
-            auto unitEnum = datatype::GetUnitFromString(unitStr);
-            auto timezone =
-                jsonField.at("type").at("timezone").get<std::string>();
-            switch (unitEnum) {
-                case datatype::DATE_TIME_UNIT_SECOND:
-                    resultType =
-                        arrow::timestamp(arrow::TimeUnit::SECOND, timezone);
-                    break;
-                case datatype::DATE_TIME_UNIT_MILLISECOND:
-                    resultType =
-                        arrow::timestamp(arrow::TimeUnit::MILLI, timezone);
-                    break;
-                case datatype::DATE_TIME_UNIT_MICROSECOND:
-                    resultType =
-                        arrow::timestamp(arrow::TimeUnit::MICRO, timezone);
-                    break;
-                case datatype::DATE_TIME_UNIT_NANOSECOND:
-                    resultType =
-                        arrow::timestamp(arrow::TimeUnit::NANO, timezone);
-                    break;
-                default:
-                    return arrow::Status::Invalid("unsupported unit");
-            }
+        auto field = unmarshalJSON(fieldJson, scratch, node);
+        if (!field.ok()) {
+            return atPath(field.status(), fieldPath(i));
+        }
+        if (field.ValueOrDie() != nullptr) {
+            fields.push_back(std::move(field).ValueOrDie());
+        }
+    }
+    return makeSchema(*schemaJson, std::move(fields), scratch);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::JSONToSchema(
+    const PoolJSON& jsonObj,
+    const JSONToSchemaOptions& options) {
+    DecodeScratch<PoolJSON> scratch{};
+    scratch.mInterner = options.interner;
+    return unmarshalSchema(jsonObj, scratch, &options);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::JSONTextToSchema(
+    std::string_view text,
+    const JSONToSchemaOptions& options) {
+    SchemaSaxHandler handler{ options.interner };
+    json::sax_parse(text.begin(), text.end(), &handler);
+    return handler.Finish();
+}
+
+/**
+ * Files smaller than this are read instead of mapped: mapping and unmapping
+ * a file costs more than copying a few pages
+ */
+static constexpr size_t kMapThreshold = 64 * 1024;
+
+/**
+ * FileMapping is a read-only mapping of a whole file, unmapped on destruction
+ *
+ * mData: first byte of the mapping, nullptr if nothing is mapped
+ * mSize: length of the mapping
+ */
+struct FileMapping {
+    ~FileMapping() {
+        if (mData != nullptr) {
+            ::munmap(mData, mSize);
+        }
+    }
+
+    void* mData{};
+    size_t mSize{};
+};
+
+/**
+ * FileDescriptor closes a file descriptor on destruction
+ */
+struct FileDescriptor {
+    ~FileDescriptor() {
+        if (mFd >= 0) {
+            ::close(mFd);
+        }
+    }
+
+    int mFd{ -1 };
+};
+
+/**
+ * @brief IOError of a failed system call on a file, from errno
+ */
+static arrow::Status fileError(const char* action, const std::string& path) {
+    return arrow::Status::IOError(
+        "cannot ", action, " '", path, "': ", std::strerror(errno));
+}
+
+/**
+ * @brief Read a whole small file into a buffer
+ */
+static arrow::Status readFile(int fd,
+                              size_t size,
+                              const std::string& path,
+                              std::string& buffer) {
+    buffer.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        auto count = ::read(fd, buffer.data() + done, size - done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return fileError("read", path);
+        }
+        if (count == 0) {
+            // truncated since fstat
             break;
         }
-        case datatype::TYPE_NAME_LIST: {
-            if (!jsonField.contains("children")) {
-                return arrow::Status::Invalid("no children found");
+        done += static_cast<size_t>(count);
+    }
+    buffer.resize(done);
+    return arrow::Status::OK();
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::JSONFileToSchema(
+    const std::string& path,
+    const JSONToSchemaOptions& options) {
+    FileDescriptor file{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (file.mFd < 0) {
+        return fileError("open", path);
+    }
+    struct stat info {};
+    if (::fstat(file.mFd, &info) != 0) {
+        return fileError("stat", path);
+    }
+    auto size = static_cast<size_t>(info.st_size);
+
+    if (size < kMapThreshold) {
+        // reused, so that loading many small files allocates nothing here
+        static thread_local std::string tBuffer{};
+        auto status = readFile(file.mFd, size, path, tBuffer);
+        if (!status.ok()) {
+            return status;
+        }
+        return JSONTextToSchema(tBuffer, options);
+    }
+
+    FileMapping mapping{};
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.mFd, 0);
+    if (data == MAP_FAILED) {
+        return fileError("map", path);
+    }
+    mapping.mData = data;
+    mapping.mSize = size;
+    ::madvise(data, size, MADV_SEQUENTIAL);
+
+    std::string_view text{ static_cast<const char*>(data), size };
+    return JSONTextToSchema(text, options);
+}
+
+/**
+ * SyntaxChecker is a json_sax handler accepting every value, keeping the parse
+ * error of malformed text as a status
+ */
+struct SyntaxChecker : nlohmann::json_sax<json> {
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t) override { return true; }
+    bool number_unsigned(number_unsigned_t) override { return true; }
+    bool number_float(number_float_t, const string_t&) override {
+        return true;
+    }
+    bool string(string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+    bool start_object(std::size_t) override { return true; }
+    bool key(string_t&) override { return true; }
+    bool end_object() override { return true; }
+    bool start_array(std::size_t) override { return true; }
+    bool end_array() override { return true; }
+
+    bool parse_error(std::size_t,
+                     const std::string&,
+                     const json::exception& ex) override {
+        mStatus = arrow::Status::Invalid(ex.what());
+        return false;
+    }
+
+    arrow::Status mStatus{};
+};
+
+/**
+ * @brief Parse text into a json DOM without throwing
+ * @return OK if the text is well-formed, Invalid naming the parse error
+ * otherwise
+ */
+static arrow::Status parseText(std::string_view text, json& value) {
+    value = json::parse(text.begin(), text.end(), nullptr, false);
+    if (!value.is_discarded()) {
+        return arrow::Status::OK();
+    }
+    // parse() drops the error when it does not throw: find it again
+    SyntaxChecker checker{};
+    json::sax_parse(text.begin(), text.end(), &checker);
+    return checker.mStatus;
+}
+
+arrow::Status converter::ValidateSchemaJSON(
+    const json& jsonObj,
+    std::vector<arrow::Status>* errors) {
+    // frames and metadata strings keep their capacity from one call to the
+    // next, validating a recurring shape allocates nothing
+    thread_local DecodeScratch<json> tScratch{};
+    arrow::Status first{};
+    auto report = [&](const arrow::Status& status) {
+        if (first.ok()) {
+            first = status;
+        }
+        if (errors != nullptr) {
+            errors->push_back(status);
+        }
+        return errors != nullptr;
+    };
+
+    const json* schemaJson = nullptr;
+    const json* fieldsJson = nullptr;
+    auto status = findSchema(jsonObj, schemaJson, fieldsJson);
+    if (!status.ok()) {
+        report(status);
+        return first;
+    }
+    for (size_t i = 0; i < fieldsJson->size(); i++) {
+        // validateField reports to errors itself
+        status = validateField((*fieldsJson)[i], i, tScratch, errors);
+        if (!status.ok()) {
+            if (first.ok()) {
+                first = status;
             }
-            auto field = unmarshalJSON(jsonField.at("children")[0]);
-            if (!field.ok()) {
-                return field.status();
+            if (errors == nullptr) {
+                return first;
             }
-            resultType = arrow::list(std::move(field).ValueOrDie());
-            break;
         }
-        case datatype::TYPE_NAME_MAP: {
-            if (!jsonField.contains("children")) {
-                return arrow::Status::Invalid("no children found");
+    }
+    auto metadata = schemaJson->find("metadata");
+    if (metadata != schemaJson->end()) {
+        status = readMetadata(*metadata, tScratch);
+        if (!status.ok()) {
+            report(atPath(status, "/schema/metadata"));
+        }
+    }
+    return first;
+}
+
+arrow::Status converter::ValidateSchemaJSONText(
+    std::string_view text,
+    std::vector<arrow::Status>* errors) {
+    // checked while parsing, the way JSONTextToSchema decodes it
+    thread_local SchemaSaxHandler tHandler{ nullptr, true };
+    tHandler.Reset();
+    json::sax_parse(text.begin(), text.end(), &tHandler);
+    auto checked = tHandler.Finish();
+    if (checked.ok()) {
+        return arrow::Status::OK();
+    }
+
+    // the handler does not know where the error is: parse the failing text
+    // to a DOM to name its path (and find the other errors)
+    json jsonObj{};
+    auto status = parseText(text, jsonObj);
+    if (status.ok()) {
+        return ValidateSchemaJSON(jsonObj, errors);
+    }
+    if (errors != nullptr) {
+        errors->push_back(status);
+    }
+    return status;
+}
+
+/**
+ * @brief Check that an index was built from a text of this size
+ */
+static arrow::Status checkIndex(std::string_view text,
+                                const converter::SchemaIndex& index) {
+    if (index.TextSize() != text.size()) {
+        return arrow::Status::Invalid("schema index built for a text of ",
+                                      index.TextSize(),
+                                      " bytes, got ",
+                                      text.size());
+    }
+    return arrow::Status::OK();
+}
+
+/**
+ * @brief Helper function parses the json value at a byte range of an indexed
+ * text
+ */
+static arrow::Status parseIndexed(std::string_view text,
+                                  uint64_t offset,
+                                  uint64_t length,
+                                  json& value) {
+    if (offset > text.size() || length > text.size() - offset) {
+        return arrow::Status::Invalid("schema index range out of the text");
+    }
+    return parseText(text.substr(offset, length), value);
+}
+
+/**
+ * @brief Prefix an error with the field it was found in: the JSON pointer of
+ * a top-level field, the path of a nested one
+ */
+static arrow::Status atEntry(const arrow::Status& status,
+                             const converter::SchemaIndexEntry& entry) {
+    if (status.ok() || entry.parent < 0) {
+        return atPath(status, fieldPath(entry.position));
+    }
+    return status.WithMessage("field ", entry.path, ": ", status.message());
+}
+
+arrow::Result<std::shared_ptr<arrow::Field>> converter::JSONTextToField(
+    std::string_view text,
+    const SchemaIndex& index,
+    std::string_view path,
+    const JSONToSchemaOptions& options) {
+    auto status = checkIndex(text, index);
+    if (!status.ok()) {
+        return status;
+    }
+    auto i = index.Find(path);
+    if (i == -1) {
+        return arrow::Status::KeyError("no indexed field ", path);
+    }
+    const auto& entry = index.Entries()[i];
+    json fieldJson{};
+    status = parseIndexed(text, entry.offset, entry.length, fieldJson);
+    if (!status.ok()) {
+        return atEntry(status, entry);
+    }
+    DecodeScratch<json> scratch{};
+    scratch.mInterner = options.interner;
+    auto field = unmarshalJSON(fieldJson, scratch);
+    if (!field.ok()) {
+        return atEntry(field.status(), entry);
+    }
+    return field;
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::JSONTextToSchema(
+    std::string_view text,
+    const SchemaIndex& index,
+    const ProjectionSpec& projection,
+    const JSONToSchemaOptions& options) {
+    auto status = checkIndex(text, index);
+    if (!status.ok()) {
+        return status;
+    }
+    auto root = makeProjection(projection);
+    if (!root.ok()) {
+        return root.status();
+    }
+    const auto& projectionRoot = root.ValueOrDie();
+
+    // top-level entries carry their name as path: the selected fields are
+    // looked up, the others are not even visited
+    std::vector<int> selected{};
+    for (const auto& child : projectionRoot.mChildren) {
+        for (auto i : index.FindAll(child.first)) {
+            if (index.Entries()[i].parent < 0) {
+                selected.push_back(i);
             }
-            auto keySorted = jsonField.at("type").at("keySorted").get<bool>();
-            auto keyField =
-                unmarshalJSON(jsonField.at("children")[0].at("key"));
-            if (!keyField.ok()) {
-                return keyField.status();
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+
+    DecodeScratch<json> scratch{};
+    scratch.mInterner = options.interner;
+    auto& fields = scratch.mFields;
+    json value{};
+    for (auto i : selected) {
+        const auto& entry = index.Entries()[i];
+        const ProjectionNode* node = nullptr;
+        selectChild(&projectionRoot, entry.path, node);
+        status = parseIndexed(text, entry.offset, entry.length, value);
+        if (!status.ok()) {
+            return atEntry(status, entry);
+        }
+        auto field = unmarshalJSON(value, scratch, node);
+        if (!field.ok()) {
+            return atEntry(field.status(), entry);
+        }
+        if (field.ValueOrDie() != nullptr) {
+            fields.push_back(std::move(field).ValueOrDie());
+        }
+    }
+
+    bool hasMetadata = index.MetadataLength() > 0;
+    if (hasMetadata) {
+        status = parseIndexed(
+            text, index.MetadataOffset(), index.MetadataLength(), value);
+        if (status.ok()) {
+            status = readMetadata(value, scratch);
+        }
+        if (!status.ok()) {
+            return atPath(status, "/schema/metadata");
+        }
+    }
+    return BuildSchema(
+        std::move(fields), hasMetadata, scratch.mKeys, scratch.mValues);
+}
+
+/**
+ * Scratch storage of the decoding direction of a Converter
+ *
+ * mScratch: working storage of the DOM decoding
+ * mSaxHandler: event handler of the text decoding
+ */
+struct converter::Converter::DecodeState {
+    explicit DecodeState(converter::TypeInterner* interner)
+        : mSaxHandler{ interner } {
+        mScratch.mInterner = interner;
+    }
+
+    DecodeScratch<json> mScratch{};
+    SchemaSaxHandler mSaxHandler;
+};
+
+void converter::Converter::DecodeStateDeleter::operator()(
+    DecodeState* state) const {
+    delete state;
+}
+
+converter::Converter::DecodeState& converter::Converter::decodeState() {
+    if (mDecode == nullptr) {
+        mDecode.reset(new DecodeState{ mDecodeOptions.interner });
+    }
+    return *mDecode;
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>>
+converter::Converter::JSONToSchema(const json& jsonObj) {
+    return unmarshalSchema(jsonObj, decodeState().mScratch, &mDecodeOptions);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>>
+converter::Converter::JSONTextToSchema(std::string_view text) {
+    auto& handler = decodeState().mSaxHandler;
+    handler.Reset();
+    json::sax_parse(text.begin(), text.end(), &handler);
+    return handler.Finish();
+}
+
+std::vector<arrow::Result<std::shared_ptr<arrow::Schema>>>
+converter::JSONToSchemaBatch(const std::vector<const json*>& jsonObjs,
+                             const BatchOptions& options) {
+    int fieldsPerTask = std::max(1, options.fieldsPerTask);
+
+    // Every document is split into field ranges, so a huge schema is spread
+    // over all workers instead of holding up the batch
+    std::vector<const json*> fieldArrays(jsonObjs.size());
+    std::vector<std::vector<std::shared_ptr<arrow::Field>>> fields(
+        jsonObjs.size());
+    std::vector<arrow::Status> itemStatuses(jsonObjs.size());
+    std::vector<BatchTask> tasks{};
+    for (size_t item = 0; item < jsonObjs.size(); item++) {
+        if (jsonObjs[item] == nullptr) {
+            itemStatuses[item] = arrow::Status::Invalid("null json");
+            continue;
+        }
+        const json* schemaJson = nullptr;
+        itemStatuses[item] =
+            findSchema(*jsonObjs[item], schemaJson, fieldArrays[item]);
+        if (!itemStatuses[item].ok()) {
+            continue;
+        }
+
+        int numFields = static_cast<int>(fieldArrays[item]->size());
+        fields[item].resize(numFields);
+        for (int begin = 0; begin < numFields; begin += fieldsPerTask) {
+            int end = std::min(numFields, begin + fieldsPerTask);
+            tasks.push_back({ item, begin, end });
+        }
+    }
+
+    auto status = ParallelForDynamic(
+        static_cast<int>(tasks.size()), options.executor, [&](int index) {
+            auto& task = tasks[index];
+            const auto& fieldsJson = *fieldArrays[task.mItem];
+            auto& items = fields[task.mItem];
+            DecodeScratch<json> scratch{};
+            scratch.mInterner = options.interner;
+            for (int i = task.mBegin; i < task.mEnd; i++) {
+                auto field = unmarshalJSON(fieldsJson[i], scratch);
+                if (!field.ok()) {
+                    task.mStatus = atPath(field.status(), fieldPath(i));
+                    return;
+                }
+                items[i] = std::move(field).ValueOrDie();
             }
-            auto itemField =
-                unmarshalJSON(jsonField.at("children")[0].at("item"));
-            if (!itemField.ok()) {
-                return itemField.status();
+        });
+
+    std::vector<arrow::Result<std::shared_ptr<arrow::Schema>>> results{};
+    results.reserve(jsonObjs.size());
+    DecodeScratch<json> scratch{};
+    size_t nextTask = 0;
+    for (size_t item = 0; item < jsonObjs.size(); item++) {
+        // the first failing range of the document, in field order
+        arrow::Status itemStatus = status.ok() ? itemStatuses[item] : status;
+        for (; nextTask < tasks.size() && tasks[nextTask].mItem == item;
+             nextTask++) {
+            if (itemStatus.ok()) {
+                itemStatus = tasks[nextTask].mStatus;
             }
-            resultType = arrow::map(std::move(keyField).ValueOrDie()->type(),
-                                    std::move(itemField).ValueOrDie(),
-                                    keySorted);
-            break;
         }
-        case datatype::TYPE_NAME_STRUCT: {
-            if (!jsonField.contains("children")) {
-                return arrow::Status::Invalid("no children found");
+
+        if (!itemStatus.ok()) {
+            results.emplace_back(itemStatus);
+            continue;
+        }
+        results.push_back(makeSchema(*jsonObjs[item]->find("schema"),
+                                     std::move(fields[item]),
+                                     scratch));
+    }
+    return results;
+}
+
+/**
+ * Number of locks the fields of a LazySchema are spread over
+ */
+static constexpr size_t kLazyLockStripes = 64;
+
+/**
+ * LazyField is the conversion state of one field of a LazySchema
+ *
+ * mReady: whether mField and mStatus are set, readable without the lock
+ * mField: converted field
+ * mStatus: status of the conversion
+ */
+struct LazyField {
+    std::atomic<bool> mReady{ false };
+    std::shared_ptr<arrow::Field> mField{};
+    arrow::Status mStatus{};
+};
+
+/**
+ * mJson: the document, owning everything the other members point into
+ * mSchemaJson: its "schema" object
+ * mFieldsJson: the "fields" array of the schema
+ * mOptions: options of the field conversions
+ * mNames: index of each field name, -1 for a name used several times
+ * mFields: conversion state of each field
+ * mLocks: locks of the conversions, field i taking lock i % kLazyLockStripes
+ * mNumMaterialized: number of fields converted so far
+ * mSchemaMutex: lock of mSchema
+ * mSchema: the whole schema, once built
+ */
+class converter::LazySchema::Impl {
+public:
+    Impl(std::shared_ptr<const json> jsonObj,
+         const json* schemaJson,
+         const json* fieldsJson,
+         const JSONToSchemaOptions& options)
+        : mJson{ std::move(jsonObj) }
+        , mSchemaJson{ schemaJson }
+        , mFieldsJson{ fieldsJson }
+        , mOptions{ options }
+        , mFields(mFieldsJson->size()) {};
+
+    /**
+     * @brief Convert a field unless it already is
+     */
+    const LazyField& materialize(size_t index) {
+        auto& slot = mFields[index];
+        if (slot.mReady.load(std::memory_order_acquire)) {
+            return slot;
+        }
+
+        std::lock_guard<std::mutex> lock(mLocks[index % kLazyLockStripes]);
+        if (slot.mReady.load(std::memory_order_relaxed)) {
+            return slot;
+        }
+        DecodeScratch<json> scratch{};
+        scratch.mInterner = mOptions.interner;
+        auto field = unmarshalJSON((*mFieldsJson)[index], scratch);
+        if (field.ok()) {
+            slot.mField = std::move(field).ValueOrDie();
+        } else {
+            slot.mStatus = atPath(field.status(), fieldPath(index));
+        }
+        mNumMaterialized++;
+        slot.mReady.store(true, std::memory_order_release);
+        return slot;
+    }
+
+    std::shared_ptr<const json> mJson;
+    const json* mSchemaJson{};
+    const json* mFieldsJson{};
+    JSONToSchemaOptions mOptions{};
+    std::unordered_map<std::string_view, int> mNames{};
+    std::vector<LazyField> mFields;
+    std::mutex mLocks[kLazyLockStripes]{};
+    std::atomic<int> mNumMaterialized{ 0 };
+    std::mutex mSchemaMutex{};
+    std::shared_ptr<arrow::Schema> mSchema{};
+};
+
+converter::LazySchema::LazySchema(std::unique_ptr<Impl> impl)
+    : mImpl{ std::move(impl) } {}
+
+converter::LazySchema::~LazySchema() = default;
+
+arrow::Result<std::shared_ptr<converter::LazySchema>>
+converter::JSONToLazySchema(std::shared_ptr<const json> jsonObj,
+                            const JSONToSchemaOptions& options) {
+    if (jsonObj == nullptr) {
+        return arrow::Status::Invalid("null json");
+    }
+
+    const json* schemaJson = nullptr;
+    const json* fieldsJson = nullptr;
+    auto status = findSchema(*jsonObj, schemaJson, fieldsJson);
+    if (!status.ok()) {
+        return status;
+    }
+
+    // names are checked here, so FieldName() can read them unchecked
+    std::unordered_map<std::string_view, int> names{};
+    names.reserve(fieldsJson->size());
+    for (size_t i = 0; i < fieldsJson->size(); i++) {
+        std::string_view name{};
+        status = getString((*fieldsJson)[i], "name", name);
+        if (!status.ok()) {
+            return atPath(status, fieldPath(i));
+        }
+        auto inserted = names.emplace(name, static_cast<int>(i));
+        if (!inserted.second) {
+            inserted.first->second = -1;
+        }
+    }
+    auto impl = std::make_unique<LazySchema::Impl>(
+        std::move(jsonObj), schemaJson, fieldsJson, options);
+    impl->mNames = std::move(names);
+    return std::shared_ptr<LazySchema>(new LazySchema(std::move(impl)));
+}
+
+int converter::LazySchema::NumFields() const {
+    return static_cast<int>(mImpl->mFields.size());
+}
+
+std::string_view converter::LazySchema::FieldName(int index) const {
+    const auto& fieldJson = (*mImpl->mFieldsJson)[index];
+    return fieldJson.find("name")->get_ref<const std::string&>();
+}
+
+int converter::LazySchema::GetFieldIndex(std::string_view name) const {
+    auto item = mImpl->mNames.find(name);
+    if (item == mImpl->mNames.end()) {
+        return -1;
+    }
+    return item->second;
+}
+
+arrow::Result<std::shared_ptr<arrow::Field>> converter::LazySchema::Field(
+    int index) {
+    if (index < 0 || index >= NumFields()) {
+        return arrow::Status::IndexError("field index out of range");
+    }
+    const auto& slot = mImpl->materialize(index);
+    if (!slot.mStatus.ok()) {
+        return slot.mStatus;
+    }
+    return slot.mField;
+}
+
+arrow::Result<std::shared_ptr<arrow::Field>>
+converter::LazySchema::GetFieldByName(std::string_view name) {
+    auto index = GetFieldIndex(name);
+    if (index == -1) {
+        return arrow::Status::KeyError("no single field named ", name);
+    }
+    return Field(index);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>>
+converter::LazySchema::ToSchema() {
+    std::lock_guard<std::mutex> lock(mImpl->mSchemaMutex);
+    if (mImpl->mSchema != nullptr) {
+        return mImpl->mSchema;
+    }
+
+    std::vector<std::shared_ptr<arrow::Field>> fields{};
+    fields.reserve(mImpl->mFields.size());
+    for (int i = 0; i < NumFields(); i++) {
+        auto field = Field(i);
+        if (!field.ok()) {
+            return field.status();
+        }
+        fields.push_back(std::move(field).ValueOrDie());
+    }
+
+    DecodeScratch<json> scratch{};
+    auto schema = makeSchema(*mImpl->mSchemaJson, std::move(fields), scratch);
+    if (!schema.ok()) {
+        return schema.status();
+    }
+    mImpl->mSchema = std::move(schema).ValueOrDie();
+    return mImpl->mSchema;
+}
+
+int converter::LazySchema::NumMaterialized() const {
+    return mImpl->mNumMaterialized.load();
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::CBORToSchema(
+    const std::vector<uint8_t>& data,
+    const JSONToSchemaOptions& options) {
+    SchemaSaxHandler handler{ options.interner };
+    json::sax_parse(
+        data.begin(), data.end(), &handler, json::input_format_t::cbor);
+    return handler.Finish();
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::MsgPackToSchema(
+    const std::vector<uint8_t>& data,
+    const JSONToSchemaOptions& options) {
+    SchemaSaxHandler handler{ options.interner };
+    json::sax_parse(
+        data.begin(), data.end(), &handler, json::input_format_t::msgpack);
+    return handler.Finish();
+}
+
+/**
+ * @brief Path of the field at a level of the work stack (0 being the field
+ * the traversal started from), relative to that field. Only built on errors
+ */
+template <typename JSON>
+static std::string framePath(const std::vector<UnmarshalFrame<JSON>>& stack,
+                             size_t level) {
+    std::string path{};
+    for (size_t i = 0; i < level; i++) {
+        // the parent has moved past the child being converted
+        const auto& parent = stack[i];
+        switch (parent.mTypeName) {
+            case datatype::TYPE_NAME_LIST:
+                path += "/children/0";
+                break;
+            case datatype::TYPE_NAME_MAP:
+                path += parent.mNextChild == 1 ? "/children/0/key"
+                                               : "/children/0/item";
+                break;
+            default:
+                path += "/children/" + std::to_string(parent.mNextChild - 1);
+                break;
+        }
+    }
+    return path;
+}
+
+/**
+ * @brief Push a field on the work stack, looking up its type and children
+ * once
+ * @param[in] projection Selected children, nullptr if the field is selected
+ * whole
+ * @param[in] depth Number of frames in use, incremented
+ * @return OK if the field is well-formed, descriptive status otherwise (path
+ * relative to the field)
+ */
+template <typename JSON>
+static arrow::Status pushField(const JSON& jsonField,
+                               const ProjectionNode* projection,
+                               std::vector<UnmarshalFrame<JSON>>& stack,
+                               size_t& depth) {
+    const JSON* typeJson = nullptr;
+    auto status = findMember(jsonField, "type", typeJson);
+    if (!status.ok()) {
+        return status;
+    }
+    std::string_view typeName{};
+    status = getString(*typeJson, "name", typeName);
+    if (!status.ok()) {
+        return atPath(status, "/type");
+    }
+
+    if (depth == stack.size()) {
+        stack.emplace_back();
+    }
+    auto& frame = stack[depth];
+    frame.mJson = &jsonField;
+    frame.mTypeJson = typeJson;
+    frame.mTypeName = datatype::GetTypeFromString(typeName);
+    frame.mChildrenJson = nullptr;
+    frame.mChildren.clear();
+    frame.mNumChildren = 0;
+    frame.mNextChild = 0;
+    frame.mProjection = projection;
+    frame.mDropped = false;
+
+    if (HasChildren(frame.mTypeName)) {
+        status = findArray(jsonField, "children", frame.mChildrenJson);
+        if (!status.ok()) {
+            return status;
+        }
+    } else if (projection != nullptr) {
+        // a path going through a field without children
+        frame.mDropped = true;
+    }
+
+    switch (frame.mTypeName) {
+        case datatype::TYPE_NAME_LIST:
+            if (frame.mChildrenJson->empty()) {
+                return arrow::Status::Invalid(
+                    "/children: list has no element field");
             }
-            std::vector<std::shared_ptr<arrow::Field>> fields{};
-            for (auto childJson : jsonField.at("children")) {
-                auto childField = unmarshalJSON(childJson);
-                if (!childField.ok()) {
-                    return childField.status();
+            frame.mNumChildren = 1;
+            if (projection != nullptr) {
+                std::string_view elementName{};
+                status =
+                    getString((*frame.mChildrenJson)[0], "name", elementName);
+                if (!status.ok()) {
+                    return atPath(status, "/children/0");
                 }
-                fields.push_back(std::move(childField).ValueOrDie());
+                frame.mDropped =
+                    projection->mChildren.find(elementName) ==
+                    projection->mChildren.end();
             }
-            resultType = arrow::struct_(fields);
-            break;
-        }
-        case datatype::TYPE_NAME_FIXED_SIZE_BINARY: {
-            auto byteWidth = jsonField.at("type").at("byteWidth").get<int>();
-            resultType = arrow::fixed_size_binary(byteWidth);
             break;
-        }
-        case datatype::TYPE_NAME_INTERVAL: {
-            auto unitStr = jsonField.at("type").at("unit").get<std::string>();
-            auto unitEnum = datatype::GetIntervalUnitFromString(unitStr);
-            switch (unitEnum) {
-                case datatype::INTERVAL_UNIT_YEAR_MONTH:
-                    resultType = arrow::month_interval();
-                    break;
-                case datatype::INTERVAL_UNIT_DAY_TIME:
-                    resultType = arrow::day_time_interval();
-                    break;
-                case datatype::INTERVAL_UNIT_MONTH_DAY_NANO:
-                    resultType = arrow::month_day_nano_interval();
-                    break;
-                default:
-                    return arrow::Status::Invalid("unsupported unit");
+        case datatype::TYPE_NAME_MAP: {
+            if (frame.mChildrenJson->empty()) {
+                return arrow::Status::Invalid(
+                    "/children: map has no key and item fields");
             }
-            break;
-        }
-        case datatype::TYPE_NAME_DURATION: {
-            auto unitStr = jsonField.at("type").at("unit").get<std::string>();
-            auto unitEnum = datatype::GetUnitFromString(unitStr);
-            switch (unitEnum) {
-                case datatype::DATE_TIME_UNIT_SECOND:
-                    resultType = arrow::duration(arrow::TimeUnit::SECOND);
-                    break;
-                case datatype::DATE_TIME_UNIT_MILLISECOND:
-                    resultType = arrow::duration(arrow::TimeUnit::MILLI);
-                    break;
-                case datatype::DATE_TIME_UNIT_MICROSECOND:
-                    resultType = arrow::duration(arrow::TimeUnit::MICRO);
-                    break;
-                case datatype::DATE_TIME_UNIT_NANOSECOND:
-                    resultType = arrow::duration(arrow::TimeUnit::NANO);
-                    break;
-                default:
-                    return arrow::Status::Invalid("unsupported unit");
+            frame.mChildrenJson = &(*frame.mChildrenJson)[0];
+            const JSON* member = nullptr;
+            status = findMember(*frame.mChildrenJson, "key", member);
+            status &= findMember(*frame.mChildrenJson, "item", member);
+            if (!status.ok()) {
+                return atPath(status, "/children/0");
+            }
+            frame.mNumChildren = 2;
+            if (projection != nullptr) {
+                frame.mDropped = projection->mChildren.count("key") == 0 &&
+                                 projection->mChildren.count("item") == 0;
             }
             break;
         }
-        case datatype::TYPE_NAME_DECIMAL: {
-            auto precision = jsonField.at("type").at("precision").get<int>();
-            auto scale = jsonField.at("type").at("scale").get<int>();
-            resultType = arrow::decimal(precision, scale);
+        case datatype::TYPE_NAME_STRUCT:
+            frame.mNumChildren = frame.mChildrenJson->size();
             break;
-        }
         default:
-            return arrow::Status::Invalid("unsupported type");
+            break;
     }
+    if (frame.mDropped) {
+        frame.mNumChildren = 0;
+    }
+    frame.mChildren.reserve(frame.mNumChildren);
+
+    depth++;
+    return arrow::Status::OK();
+}
 
-    // Handle metadata
-    if (!jsonField.contains("metadata")) {
-        //std::cout << "no metadata in " << fieldName << std::endl;
-        return arrow::field(fieldName, resultType);
+/**
+ * @brief Json object of the next child of a field on the work stack, which
+ * pushField made sure exists
+ * @param[out] mapMember "key" or "item" for the children of a map, nullptr
+ * otherwise
+ */
+template <typename JSON>
+static const JSON& nextChild(UnmarshalFrame<JSON>& frame,
+                             const char*& mapMember) {
+    auto index = frame.mNextChild++;
+    mapMember = nullptr;
+    switch (frame.mTypeName) {
+        case datatype::TYPE_NAME_LIST:
+            return (*frame.mChildrenJson)[0];
+        case datatype::TYPE_NAME_MAP:
+            mapMember = index == 0 ? "key" : "item";
+            return *frame.mChildrenJson->find(mapMember);
+        default:
+            return (*frame.mChildrenJson)[index];
     }
+}
 
-    auto jsonMeta = jsonField.at("metadata");
-    //std::cout << fieldName << " has " << jsonMeta.size() << " metadata\n";
-    std::vector<std::string> keys{};
-    std::vector<std::string> values{};
-    int extKeyIdx = -1;
-    int extDataIdx = -1;
+template <typename JSON>
+static arrow::Result<std::shared_ptr<arrow::Field>> unmarshalJSON(
+    const JSON& jsonField,
+    DecodeScratch<JSON>& scratch,
+    const ProjectionNode* projection) {
+    auto& stack = scratch.mStack;
+    size_t depth = 0;
+    auto status = pushField(jsonField, projection, stack, depth);
+    if (!status.ok()) {
+        return status;
+    }
 
-    for (int i = 0; i < jsonMeta.size(); i++) {
-        auto key = jsonMeta[i].at("key");
+    while (true) {
+        auto& frame = stack[depth - 1];
 
-        if (key == EXTENSION_TYPE_KEY_NAME) {
-            extKeyIdx = i;
-        } else if (key == EXTENSION_METADATA_KEY_NAME) {
-            extDataIdx = i;
+        if (frame.mNextChild < frame.mNumChildren) {
+            const char* mapMember = nullptr;
+            const JSON* childJson = &nextChild(frame, mapMember);
+
+            const ProjectionNode* childProjection = nullptr;
+            if (frame.mProjection != nullptr) {
+                std::string_view childName{ mapMember != nullptr ? mapMember
+                                                                 : "" };
+                if (mapMember == nullptr) {
+                    status = getString(*childJson, "name", childName);
+                    if (!status.ok()) {
+                        return atPath(status, framePath(stack, depth));
+                    }
+                }
+                auto selection =
+                    selectChild(frame.mProjection, childName, childProjection);
+                // a map needs both its key and item, the one not selected is
+                // converted whole
+                if (selection == SELECTION_NONE &&
+                    frame.mTypeName == datatype::TYPE_NAME_STRUCT) {
+                    continue;
+                }
+            }
+
+            // frame may be invalidated from here on, the stack can reallocate
+            status = pushField(*childJson, childProjection, stack, depth);
+            if (!status.ok()) {
+                return atPath(status, framePath(stack, depth));
+            }
+            continue;
+        }
+
+        std::shared_ptr<arrow::Field> field{};
+        bool dropped =
+            frame.mDropped ||
+            (frame.mProjection != nullptr && frame.mChildren.empty());
+        if (!dropped) {
+            auto built = makeField(*frame.mJson,
+                                   *frame.mTypeJson,
+                                   frame.mTypeName,
+                                   frame.mChildren,
+                                   scratch);
+            if (!built.ok()) {
+                return atPath(built.status(), framePath(stack, depth - 1));
+            }
+            field = std::move(built).ValueOrDie();
+        }
+        depth--;
+        if (depth == 0) {
+            return field;
         }
 
-        keys.push_back(key);
-        values.push_back(jsonMeta[i].at("value"));
+        auto& parent = stack[depth - 1];
+        if (field != nullptr) {
+            parent.mChildren.push_back(std::move(field));
+        } else if (parent.mTypeName != datatype::TYPE_NAME_STRUCT) {
+            // the element of a list, or the key or item of a map, is required
+            parent.mDropped = true;
+            parent.mNextChild = parent.mNumChildren;
+        }
     }
+}
 
-    if (extKeyIdx == -1) {
-        return arrow::field(fieldName, resultType)
-            ->WithMetadata(arrow::KeyValueMetadata::Make(keys, values));
+template <typename JSON>
+static arrow::Status readField(const JSON& jsonField,
+                               const JSON& type,
+                               datatype::TypeName typeNameEnum,
+                               FieldSpec& spec,
+                               bool& hasMetadata,
+                               DecodeScratch<JSON>& scratch) {
+    auto status = getString(jsonField, "name", spec.mName);
+    if (!status.ok()) {
+        return status;
     }
+    spec.mTypeName = typeNameEnum;
 
-    auto extType = arrow::GetExtensionType(values[extKeyIdx]);
-    if (extType ==
-        nullptr) { // unregistered extension type, just keep the metadata
-        return arrow::field(fieldName, resultType)
-            ->WithMetadata(arrow::KeyValueMetadata::Make(keys, values));
+    int params = RequiredTypeParams(typeNameEnum);
+    if (params & TYPE_PARAM_IS_SIGNED) {
+        status &= getBool(type, "isSigned", spec.mIsSigned);
+    }
+    if (params & TYPE_PARAM_BIT_WIDTH) {
+        status &= getInt(type, "bitWidth", spec.mBitWidth);
+    }
+    if (params & TYPE_PARAM_PRECISION_NAME) {
+        status &= getString(type, "precision", spec.mPrecisionName);
+    }
+    if (params & TYPE_PARAM_PRECISION) {
+        status &= getInt(type, "precision", spec.mPrecision);
+    }
+    if (params & TYPE_PARAM_SCALE) {
+        status &= getInt(type, "scale", spec.mScale);
+    }
+    if (params & TYPE_PARAM_UNIT) {
+        status &= getString(type, "unit", spec.mUnit);
+    }
+    if (params & TYPE_PARAM_TIMEZONE) {
+        status &= getString(type, "timezone", spec.mTimezone);
+    }
+    if (params & TYPE_PARAM_BYTE_WIDTH) {
+        status &= getInt(type, "byteWidth", spec.mByteWidth);
+    }
+    if (params & TYPE_PARAM_KEY_SORTED) {
+        status &= getBool(type, "keySorted", spec.mKeySorted);
+    }
+    if (!status.ok()) {
+        return atPath(status, "/type");
     }
 
-    std::string extData{};
-    if (extDataIdx != -1) {
-        extData = values[extDataIdx];
-        keys.erase(keys.begin() + extKeyIdx);
-        values.erase(values.begin() + extKeyIdx);
-        keys.erase(keys.begin() + extDataIdx);
-        values.erase(values.begin() + extDataIdx);
-    } else {
-        keys.erase(keys.begin() + extKeyIdx);
-        values.erase(values.begin() + extKeyIdx);
+    auto metadata = jsonField.find("metadata");
+    hasMetadata = metadata != jsonField.end();
+    if (hasMetadata) {
+        return atPath(readMetadata(*metadata, scratch), "/metadata");
+    }
+    return arrow::Status::OK();
+}
+
+template <typename JSON>
+static arrow::Result<std::shared_ptr<arrow::Field>> makeField(
+    const JSON& jsonField,
+    const JSON& type,
+    datatype::TypeName typeNameEnum,
+    std::vector<std::shared_ptr<arrow::Field>>& children,
+    DecodeScratch<JSON>& scratch) {
+    FieldSpec spec{};
+    bool hasMetadata = false;
+    auto status =
+        readField(jsonField, type, typeNameEnum, spec, hasMetadata, scratch);
+    if (!status.ok()) {
+        return status;
     }
+    return BuildField(spec,
+                      children,
+                      hasMetadata,
+                      scratch.mKeys,
+                      scratch.mValues,
+                      scratch.mInterner);
+}
+
+template <typename JSON>
+static arrow::Status validateField(const JSON& jsonField,
+                                   size_t index,
+                                   DecodeScratch<JSON>& scratch,
+                                   std::vector<arrow::Status>* errors) {
+    auto& stack = scratch.mStack;
+    arrow::Status first{};
+    // record an error of the field at a level of the stack, and tell whether
+    // to go on
+    auto report = [&](const arrow::Status& status, size_t level) {
+        auto error =
+            atPath(atPath(status, framePath(stack, level)), fieldPath(index));
+        if (first.ok()) {
+            first = error;
+        }
+        if (errors != nullptr) {
+            errors->push_back(std::move(error));
+        }
+        return errors != nullptr;
+    };
 
-    auto deserializeResult = extType->Deserialize(resultType, extData);
-    if (deserializeResult.ok()) {
-        resultType = deserializeResult.ValueUnsafe();
+    size_t depth = 0;
+    auto status = pushField(jsonField, nullptr, stack, depth);
+    if (!status.ok()) {
+        report(status, 0);
+        return first;
     }
 
-    return arrow::field(fieldName, resultType);
+    while (depth > 0) {
+        auto& frame = stack[depth - 1];
+        if (frame.mNextChild < frame.mNumChildren) {
+            const char* mapMember = nullptr;
+            const auto& childJson = nextChild(frame, mapMember);
+            // frame may be invalidated from here on, the stack can reallocate
+            status = pushField(childJson, nullptr, stack, depth);
+            if (!status.ok() && !report(status, depth)) {
+                return first;
+            }
+            continue;
+        }
+
+        FieldSpec spec{};
+        bool hasMetadata = false;
+        status = readField(*frame.mJson,
+                           *frame.mTypeJson,
+                           frame.mTypeName,
+                           spec,
+                           hasMetadata,
+                           scratch);
+        if (status.ok()) {
+            status = ValidateFieldSpec(spec);
+        }
+        depth--;
+        if (!status.ok() && !report(status, depth)) {
+            return first;
+        }
+    }
+    return first;
 }
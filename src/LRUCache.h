@@ -0,0 +1,147 @@
+#ifndef _LRU_CACHE_H_
+#define _LRU_CACHE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * ShardedLRUCache is a bounded, thread-safe key-value cache. Keys are spread
+ * over independent shards by hash, each shard has its own mutex and evicts its
+ * least recently used entry once it is full, so concurrent lookups of
+ * different keys rarely contend on the same lock.
+ *
+ * mShards: the shards, never resized after construction
+ * mShardCapacity: maximum number of entries per shard
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLRUCache {
+public:
+    /**
+     * Counters summed over all shards
+     */
+    struct Counters {
+        uint64_t hits{};
+        uint64_t misses{};
+        uint64_t evictions{};
+        size_t size{};
+    };
+
+    ShardedLRUCache(size_t capacity, size_t numShards)
+        : mShards(numShards == 0 ? 1 : numShards)
+        , mShardCapacity{ std::max<size_t>(
+              1, (capacity + mShards.size() - 1) / mShards.size()) } {};
+
+    ~ShardedLRUCache() = default;
+
+    /**
+     * @brief Look up a key and mark it as most recently used
+     * @return The cached value, std::nullopt on a miss
+     */
+    std::optional<Value> Get(const Key& key) {
+        auto& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+
+        auto item = shard.mIndex.find(key);
+        if (item == shard.mIndex.end()) {
+            shard.mMisses++;
+            return std::nullopt;
+        }
+        shard.mHits++;
+        shard.mEntries.splice(
+            shard.mEntries.begin(), shard.mEntries, item->second);
+        return item->second->second;
+    }
+
+    /**
+     * @brief Insert or replace a key, evicting the least recently used entry of
+     * its shard when the shard is full
+     */
+    void Put(const Key& key, Value value) {
+        auto& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+
+        auto item = shard.mIndex.find(key);
+        if (item != shard.mIndex.end()) {
+            item->second->second = std::move(value);
+            shard.mEntries.splice(
+                shard.mEntries.begin(), shard.mEntries, item->second);
+            return;
+        }
+
+        if (shard.mIndex.size() >= mShardCapacity) {
+            shard.mIndex.erase(shard.mEntries.back().first);
+            shard.mEntries.pop_back();
+            shard.mEvictions++;
+        }
+        shard.mEntries.emplace_front(key, std::move(value));
+        shard.mIndex.emplace(key, shard.mEntries.begin());
+    }
+
+    /**
+     * @brief Remove a key
+     * @return true if the key was cached
+     */
+    bool Erase(const Key& key) {
+        auto& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+
+        auto item = shard.mIndex.find(key);
+        if (item == shard.mIndex.end()) {
+            return false;
+        }
+        shard.mEntries.erase(item->second);
+        shard.mIndex.erase(item);
+        return true;
+    }
+
+    /**
+     * @brief Remove all entries. Counters are kept
+     */
+    void Clear() {
+        for (auto& shard : mShards) {
+            std::lock_guard<std::mutex> lock(shard.mMutex);
+            shard.mIndex.clear();
+            shard.mEntries.clear();
+        }
+    }
+
+    Counters GetCounters() const {
+        Counters result{};
+        for (auto& shard : mShards) {
+            std::lock_guard<std::mutex> lock(shard.mMutex);
+            result.hits += shard.mHits;
+            result.misses += shard.mMisses;
+            result.evictions += shard.mEvictions;
+            result.size += shard.mIndex.size();
+        }
+        return result;
+    }
+
+private:
+    struct Shard {
+        mutable std::mutex mMutex{};
+        std::list<std::pair<Key, Value>> mEntries{};
+        std::unordered_map<Key,
+                           typename std::list<std::pair<Key, Value>>::iterator,
+                           Hash>
+            mIndex{};
+        uint64_t mHits{};
+        uint64_t mMisses{};
+        uint64_t mEvictions{};
+    };
+
+    Shard& shardOf(const Key& key) {
+        return mShards[Hash{}(key) % mShards.size()];
+    }
+
+    std::vector<Shard> mShards;
+    size_t mShardCapacity{};
+};
+
+#endif // _LRU_CACHE_H_
@@ -0,0 +1,148 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <arrow/status.h>
+#include <arrow/util/parallel.h>
+#include <arrow/util/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Number of ranges ParallelForRanges splits `length` items into.
+ *
+ * Ranges are several times more numerous than the executor's threads, so an
+ * expensive range does not leave the other threads idle. When called from one
+ * of the executor's own threads there is a single range, run serially, because
+ * blocking a worker on its own pool may deadlock.
+ *
+ * @param[in] length Number of items
+ * @param[in] executor Executor running the ranges, arrow's CPU thread pool if
+ * null
+ */
+inline int ParallelRangeCount(int length,
+                              arrow::internal::Executor* executor) {
+    if (executor == nullptr) {
+        executor = arrow::internal::GetCpuThreadPool();
+    }
+    if (length <= 0) {
+        return 0;
+    }
+    if (executor->OwnsThisThread()) {
+        return 1;
+    }
+    return std::min(length, std::max(1, executor->GetCapacity() * 4));
+}
+
+/**
+ * @brief Split [0, length) into ParallelRangeCount() contiguous ranges and run
+ * func(range, begin, end) on each of them through an executor, blocking until
+ * all ranges are done
+ *
+ * @param[in] length Number of items
+ * @param[in] executor Executor running the ranges, arrow's CPU thread pool if
+ * null
+ * @param[in] func Callable with signature
+ * arrow::Status(int range, int begin, int end)
+ * @return The status of the first failing range in item order, OK otherwise
+ */
+template <typename Func>
+arrow::Status ParallelForRanges(int length,
+                                arrow::internal::Executor* executor,
+                                Func&& func) {
+    if (executor == nullptr) {
+        executor = arrow::internal::GetCpuThreadPool();
+    }
+    int numRanges = ParallelRangeCount(length, executor);
+    if (numRanges <= 1) {
+        return numRanges == 0 ? arrow::Status::OK() : func(0, 0, length);
+    }
+
+    std::vector<arrow::Status> statuses(numRanges);
+    auto status = arrow::internal::ParallelFor(
+        numRanges,
+        [&](int range) {
+            int begin = static_cast<int>(static_cast<int64_t>(length) * range /
+                                         numRanges);
+            int end = static_cast<int>(static_cast<int64_t>(length) *
+                                       (range + 1) / numRanges);
+            statuses[range] = func(range, begin, end);
+            return arrow::Status::OK();
+        },
+        executor);
+    if (!status.ok()) {
+        return status;
+    }
+
+    for (auto& rangeStatus : statuses) {
+        if (!rangeStatus.ok()) {
+            return rangeStatus;
+        }
+    }
+    return arrow::Status::OK();
+}
+
+/**
+ * BatchTask is a range of fields of one schema (or json document) of a batch
+ * conversion
+ *
+ * mItem: index of the schema in the batch
+ * mBegin: first field of the range
+ * mEnd: one past the last field of the range
+ * mStatus: outcome of the range
+ */
+struct BatchTask {
+    size_t mItem{};
+    int mBegin{};
+    int mEnd{};
+    arrow::Status mStatus{};
+};
+
+/**
+ * @brief Run func(task) for every task in [0, numTasks) on a few workers of an
+ * executor, blocking until all tasks are done
+ *
+ * Tasks are not assigned up front: each worker takes the next pending task as
+ * soon as it is done with its current one, so uneven tasks keep every worker
+ * busy until the queue is drained. Called from one of the executor's own
+ * threads, the tasks run serially.
+ *
+ * @param[in] numTasks Number of tasks
+ * @param[in] executor Executor running the workers, arrow's CPU thread pool if
+ * null
+ * @param[in] func Callable with signature void(int task), must not throw
+ * @return Error starting the workers, OK otherwise
+ */
+template <typename Func>
+arrow::Status ParallelForDynamic(int numTasks,
+                                 arrow::internal::Executor* executor,
+                                 Func&& func) {
+    if (executor == nullptr) {
+        executor = arrow::internal::GetCpuThreadPool();
+    }
+    if (numTasks <= 0) {
+        return arrow::Status::OK();
+    }
+
+    std::atomic<int> nextTask{ 0 };
+    auto worker = [&](int) {
+        for (int task = nextTask++; task < numTasks; task = nextTask++) {
+            func(task);
+        }
+        return arrow::Status::OK();
+    };
+
+    int numWorkers = executor->OwnsThisThread()
+                         ? 1
+                         : std::min(numTasks,
+                                    std::max(1, executor->GetCapacity()));
+    if (numWorkers == 1) {
+        return worker(0);
+    }
+    return arrow::internal::ParallelFor(numWorkers, worker, executor);
+}
+
+#endif // _PARALLEL_H_
@@ -0,0 +1,774 @@
+#include "SchemaSaxHandler.h"
+
+#include "DataTypes.h"
+#include "FieldBuilder.h"
+
+/**
+ * Scope is the kind of container a level stands for
+ */
+enum Scope {
+    SCOPE_DOCUMENT,       // top-level object
+    SCOPE_SCHEMA,         // "schema" object
+    SCOPE_FIELDS,         // "fields" array of the schema
+    SCOPE_FIELD,          // object of a field
+    SCOPE_CHILDREN,       // "children" array of a field
+    SCOPE_CHILD,          // element of "children", not told apart yet
+    SCOPE_ENTRY,          // map entry: {"key": field, "item": field}
+    SCOPE_TYPE,           // "type" object of a field
+    SCOPE_METADATA,       // "metadata" array of a schema or a field
+    SCOPE_METADATA_ITEM,  // {"key": string, "value": string}
+    SCOPE_SKIPPED,        // container of an ignored member
+};
+
+/**
+ * Slot is what the next value of a container stands for
+ */
+enum Slot {
+    SLOT_IGNORED,
+    SLOT_DOCUMENT,
+    SLOT_SCHEMA,
+    SLOT_FIELDS,
+    SLOT_FIELD,
+    SLOT_CHILDREN,
+    SLOT_CHILD,
+    SLOT_TYPE,
+    SLOT_METADATA,
+    SLOT_METADATA_ITEM,
+    SLOT_METADATA_KEY,
+    SLOT_METADATA_VALUE,
+    SLOT_NAME,
+    SLOT_TYPE_NAME,
+    SLOT_IS_SIGNED,
+    SLOT_BIT_WIDTH,
+    SLOT_PRECISION,
+    SLOT_SCALE,
+    SLOT_UNIT,
+    SLOT_TIMEZONE,
+    SLOT_BYTE_WIDTH,
+    SLOT_KEY_SORTED,
+};
+
+/**
+ * Target is where a field goes once converted
+ */
+enum Target {
+    TARGET_SCHEMA,   // fields of the schema
+    TARGET_CHILD,    // children of the enclosing field
+    TARGET_MAP_KEY,  // key of the enclosing map
+    TARGET_MAP_ITEM, // item of the enclosing map
+};
+
+static constexpr int kMetadataKey = 1 << 0;
+static constexpr int kMetadataValue = 1 << 1;
+
+/**
+ * Level is an open container
+ *
+ * mScope: kind of container
+ * mNext: what the next value stands for (set by each key of an object)
+ * mOwner: field the container belongs to, -1 for the schema
+ * mIndex: number of elements started (arrays), element index (children),
+ * members seen (metadata items)
+ */
+struct SchemaSaxHandler::Level {
+    Scope mScope{};
+    Slot mNext{};
+    int mOwner{};
+    int mIndex{};
+};
+
+/**
+ * FieldState is a field whose object is open
+ *
+ * mSpec: type name, numeric and boolean members of the field's type
+ * mName, mPrecisionName, mUnit, mTimezone: string members, mSpec gets views
+ * of them when the field closes
+ * mParams: type members seen so far (TypeParam flags)
+ * mHasName: whether "name" was seen
+ * mHasTypeName: whether the type's "name" was seen
+ * mHasChildren: whether "children" was seen
+ * mHasMetadata: whether "metadata" was seen
+ * mChildren: converted children fields, in order
+ * mFirstIsEntry: whether the first element of "children" is a map entry
+ * mAnyEntry: whether any element of "children" is a map entry
+ * mMapKey, mMapItem: fields of the first map entry
+ * mChildStatus: first error of an element of "children" met while the type
+ * was not known, OK if none
+ * mChildIndex: position of that element in "children"
+ * mKeys, mValues: metadata
+ * mTarget: where the field goes once converted
+ */
+struct SchemaSaxHandler::FieldState {
+    FieldSpec mSpec{};
+    std::string mName{};
+    std::string mPrecisionName{};
+    std::string mUnit{};
+    std::string mTimezone{};
+    int mParams{};
+    bool mHasName{};
+    bool mHasTypeName{};
+    bool mHasChildren{};
+    bool mHasMetadata{};
+    std::vector<std::shared_ptr<arrow::Field>> mChildren{};
+    bool mFirstIsEntry{};
+    bool mAnyEntry{};
+    std::shared_ptr<arrow::Field> mMapKey{};
+    std::shared_ptr<arrow::Field> mMapItem{};
+    arrow::Status mChildStatus{};
+    int mChildIndex{};
+    std::vector<std::string> mKeys{};
+    std::vector<std::string> mValues{};
+    Target mTarget{};
+};
+
+SchemaSaxHandler::SchemaSaxHandler(converter::TypeInterner* interner,
+                                   bool validateOnly)
+    : mInterner{ interner }
+    , mValidateOnly{ validateOnly } {
+    Reset();
+}
+
+SchemaSaxHandler::~SchemaSaxHandler() = default;
+
+void SchemaSaxHandler::Reset() {
+    mLevels.clear();
+    mDepth = 0;
+    mSchemaFields.clear();
+    mSchemaKeys.clear();
+    mSchemaValues.clear();
+    mHasSchema = false;
+    mHasFields = false;
+    mHasMetadata = false;
+    mDone = false;
+    mStatus = arrow::Status::OK();
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>> SchemaSaxHandler::Finish() {
+    if (!mStatus.ok()) {
+        return mStatus;
+    }
+    if (!mDone) {
+        return arrow::Status::Invalid("incomplete document");
+    }
+    if (!mHasSchema) {
+        return arrow::Status::Invalid("no schema found");
+    }
+    if (!mHasFields) {
+        return arrow::Status::Invalid("no fields found");
+    }
+    if (mValidateOnly) {
+        return nullptr;
+    }
+    return BuildSchema(std::move(mSchemaFields),
+                       mHasMetadata,
+                       mSchemaKeys,
+                       mSchemaValues);
+}
+
+bool SchemaSaxHandler::fail(const std::string& message) {
+    return fail(arrow::Status::Invalid(message));
+}
+
+bool SchemaSaxHandler::fail(arrow::Status status) {
+    // an error inside an element of "children" only counts if JSONToSchema
+    // reads that element, which the type of the field tells
+    for (size_t i = mLevels.size(); i-- > 0;) {
+        auto& level = mLevels[i];
+        if (level.mScope != SCOPE_CHILDREN) {
+            continue;
+        }
+        auto& owner = mFields[level.mOwner];
+        // a value of the array itself was not counted yet
+        bool isElement = i + 1 == mLevels.size();
+        int index = isElement ? level.mIndex : level.mIndex - 1;
+        if (owner.mHasTypeName &&
+            ReadsChild(owner.mSpec.mTypeName, static_cast<size_t>(index))) {
+            continue;
+        }
+        if (!owner.mHasTypeName && owner.mChildStatus.ok()) {
+            // held until the field closes and its type is known
+            owner.mChildStatus = std::move(status);
+            owner.mChildIndex = index;
+        }
+
+        // the rest of the element is ignored
+        if (isElement) {
+            level.mIndex++;
+        }
+        for (size_t j = i + 1; j < mLevels.size(); j++) {
+            mLevels[j].mScope = SCOPE_SKIPPED;
+            mLevels[j].mNext = SLOT_IGNORED;
+        }
+        mDepth = static_cast<size_t>(level.mOwner) + 1;
+        return true;
+    }
+
+    if (mStatus.ok()) {
+        mStatus = std::move(status);
+    }
+    return false;
+}
+
+/**
+ * @brief What the next value stands for
+ */
+#define NEXT_SLOT() (mLevels.empty() ? SLOT_DOCUMENT : mLevels.back().mNext)
+
+bool SchemaSaxHandler::null() {
+    if (NEXT_SLOT() != SLOT_IGNORED) {
+        return fail("unexpected null");
+    }
+    return true;
+}
+
+bool SchemaSaxHandler::boolean(bool value) {
+    switch (NEXT_SLOT()) {
+        case SLOT_IGNORED:
+            return true;
+        case SLOT_IS_SIGNED: {
+            auto& field = mFields[mDepth - 1];
+            field.mSpec.mIsSigned = value;
+            field.mParams |= TYPE_PARAM_IS_SIGNED;
+            return true;
+        }
+        case SLOT_KEY_SORTED: {
+            auto& field = mFields[mDepth - 1];
+            field.mSpec.mKeySorted = value;
+            field.mParams |= TYPE_PARAM_KEY_SORTED;
+            return true;
+        }
+        default:
+            return fail("unexpected boolean");
+    }
+}
+
+/**
+ * @brief The numeric type parameter a slot stands for
+ * @return TypeParam flag, 0 if the slot takes no number
+ */
+static int numericParam(Slot slot) {
+    switch (slot) {
+        case SLOT_BIT_WIDTH:
+            return TYPE_PARAM_BIT_WIDTH;
+        case SLOT_PRECISION:
+            return TYPE_PARAM_PRECISION;
+        case SLOT_SCALE:
+            return TYPE_PARAM_SCALE;
+        case SLOT_BYTE_WIDTH:
+            return TYPE_PARAM_BYTE_WIDTH;
+        default:
+            return 0;
+    }
+}
+
+bool SchemaSaxHandler::number(int value) {
+    auto slot = NEXT_SLOT();
+    if (slot == SLOT_IGNORED) {
+        return true;
+    }
+    auto param = numericParam(slot);
+    if (mDepth == 0 || param == 0) {
+        return fail("unexpected number");
+    }
+
+    auto& field = mFields[mDepth - 1];
+    switch (param) {
+        case TYPE_PARAM_BIT_WIDTH:
+            field.mSpec.mBitWidth = value;
+            break;
+        case TYPE_PARAM_PRECISION:
+            field.mSpec.mPrecision = value;
+            break;
+        case TYPE_PARAM_SCALE:
+            field.mSpec.mScale = value;
+            break;
+        default:
+            field.mSpec.mByteWidth = value;
+            break;
+    }
+    field.mParams |= param;
+    return true;
+}
+
+bool SchemaSaxHandler::badNumber(const char* problem) {
+    auto slot = NEXT_SLOT();
+    if (slot == SLOT_IGNORED) {
+        return true;
+    }
+    auto param = numericParam(slot);
+    if (mDepth == 0 || param == 0) {
+        return fail("unexpected number");
+    }
+    // named like the innermost step of JSONToSchema's path
+    return fail(std::string{ "/" } + TypeParamKey(param) + ": " + problem);
+}
+
+bool SchemaSaxHandler::number_integer(json::number_integer_t value) {
+    if (!FitsTypeParam(static_cast<int64_t>(value))) {
+        return badNumber("integer out of range");
+    }
+    return number(static_cast<int>(value));
+}
+
+bool SchemaSaxHandler::number_unsigned(json::number_unsigned_t value) {
+    if (!FitsTypeParam(static_cast<uint64_t>(value))) {
+        return badNumber("integer out of range");
+    }
+    return number(static_cast<int>(value));
+}
+
+bool SchemaSaxHandler::number_float(json::number_float_t,
+                                    const json::string_t&) {
+    return badNumber("expected an integer");
+}
+
+bool SchemaSaxHandler::string(json::string_t& value) {
+    auto slot = NEXT_SLOT();
+    switch (slot) {
+        case SLOT_IGNORED:
+            return true;
+        case SLOT_METADATA_KEY:
+        case SLOT_METADATA_VALUE: {
+            auto& level = mLevels.back();
+            auto& metadata = slot == SLOT_METADATA_KEY
+                                 ? metadataKeys(level)
+                                 : metadataValues(level);
+            metadata.back() = value;
+            level.mIndex |=
+                slot == SLOT_METADATA_KEY ? kMetadataKey : kMetadataValue;
+            return true;
+        }
+        default:
+            break;
+    }
+    if (mDepth == 0) {
+        return fail("unexpected string");
+    }
+
+    auto& field = mFields[mDepth - 1];
+    switch (slot) {
+        case SLOT_NAME:
+            field.mName = value;
+            field.mHasName = true;
+            return true;
+        case SLOT_TYPE_NAME:
+            field.mSpec.mTypeName = datatype::GetTypeFromString(value);
+            field.mHasTypeName = true;
+            return true;
+        case SLOT_PRECISION:
+            field.mPrecisionName = value;
+            field.mParams |= TYPE_PARAM_PRECISION_NAME;
+            return true;
+        case SLOT_UNIT:
+            field.mUnit = value;
+            field.mParams |= TYPE_PARAM_UNIT;
+            return true;
+        case SLOT_TIMEZONE:
+            field.mTimezone = value;
+            field.mParams |= TYPE_PARAM_TIMEZONE;
+            return true;
+        default:
+            return fail("unexpected string");
+    }
+}
+
+bool SchemaSaxHandler::binary(json::binary_t&) {
+    if (NEXT_SLOT() != SLOT_IGNORED) {
+        return fail("unexpected binary value");
+    }
+    return true;
+}
+
+bool SchemaSaxHandler::start_object(std::size_t) {
+    auto slot = NEXT_SLOT();
+    int owner = mDepth > 0 ? static_cast<int>(mDepth) - 1 : -1;
+    switch (slot) {
+        case SLOT_DOCUMENT:
+            mLevels.push_back({ SCOPE_DOCUMENT, SLOT_IGNORED, -1, 0 });
+            return true;
+        case SLOT_SCHEMA:
+            mLevels.push_back({ SCOPE_SCHEMA, SLOT_IGNORED, -1, 0 });
+            return true;
+        case SLOT_FIELD: {
+            auto target = TARGET_SCHEMA;
+            auto& parent = mLevels.back();
+            if (parent.mScope == SCOPE_ENTRY) {
+                target = parent.mNext == SLOT_FIELD && parent.mIndex == 1
+                             ? TARGET_MAP_ITEM
+                             : TARGET_MAP_KEY;
+            }
+            return openField(target);
+        }
+        case SLOT_CHILD: {
+            int index = mLevels.back().mIndex++;
+            const auto& parent = mFields[owner];
+            if (parent.mHasTypeName &&
+                !ReadsChild(parent.mSpec.mTypeName,
+                            static_cast<size_t>(index))) {
+                // an element JSONToSchema does not read, like the second
+                // element of a list
+                mLevels.push_back({ SCOPE_SKIPPED, SLOT_IGNORED, owner, 0 });
+                return true;
+            }
+            mLevels.push_back({ SCOPE_CHILD, SLOT_IGNORED, owner, index });
+            return true;
+        }
+        case SLOT_TYPE:
+            mFields[mDepth - 1].mParams = 0;
+            mFields[mDepth - 1].mHasTypeName = false;
+            mLevels.push_back({ SCOPE_TYPE, SLOT_IGNORED, owner, 0 });
+            return true;
+        case SLOT_METADATA_ITEM: {
+            auto& level = mLevels.back();
+            metadataKeys(level).emplace_back();
+            metadataValues(level).emplace_back();
+            mLevels.push_back(
+                { SCOPE_METADATA_ITEM, SLOT_IGNORED, level.mOwner, 0 });
+            return true;
+        }
+        case SLOT_IGNORED:
+            mLevels.push_back({ SCOPE_SKIPPED, SLOT_IGNORED, owner, 0 });
+            return true;
+        default:
+            // skipped, should the error be held
+            mLevels.push_back({ SCOPE_SKIPPED, SLOT_IGNORED, owner, 0 });
+            return fail("unexpected object");
+    }
+}
+
+bool SchemaSaxHandler::openField(int target) {
+    if (mDepth == mFields.size()) {
+        mFields.emplace_back();
+    }
+    auto& field = mFields[mDepth++];
+    field.mSpec = FieldSpec{};
+    field.mParams = 0;
+    field.mHasName = false;
+    field.mHasTypeName = false;
+    field.mHasChildren = false;
+    field.mHasMetadata = false;
+    field.mChildren.clear();
+    field.mFirstIsEntry = false;
+    field.mAnyEntry = false;
+    field.mMapKey = nullptr;
+    field.mMapItem = nullptr;
+    field.mChildStatus = arrow::Status::OK();
+    field.mChildIndex = 0;
+    field.mKeys.clear();
+    field.mValues.clear();
+    field.mTarget = static_cast<Target>(target);
+
+    mLevels.push_back({ SCOPE_FIELD,
+                        SLOT_IGNORED,
+                        static_cast<int>(mDepth) - 1,
+                        0 });
+    return true;
+}
+
+bool SchemaSaxHandler::fieldKey(const json::string_t& key) {
+    auto& level = mLevels.back();
+    auto& field = mFields[level.mOwner];
+    if (key == "name") {
+        level.mNext = SLOT_NAME;
+    } else if (key == "type") {
+        level.mNext = SLOT_TYPE;
+    } else if (key == "children") {
+        field.mHasChildren = true;
+        field.mChildren.clear();
+        field.mFirstIsEntry = false;
+        field.mAnyEntry = false;
+        level.mNext = SLOT_CHILDREN;
+    } else if (key == "metadata") {
+        field.mHasMetadata = true;
+        level.mNext = SLOT_METADATA;
+    } else {
+        level.mNext = SLOT_IGNORED;
+    }
+    return true;
+}
+
+bool SchemaSaxHandler::key(json::string_t& key) {
+    auto& level = mLevels.back();
+    switch (level.mScope) {
+        case SCOPE_DOCUMENT:
+            level.mNext = SLOT_IGNORED;
+            if (key == "schema") {
+                mHasSchema = true;
+                level.mNext = SLOT_SCHEMA;
+            }
+            return true;
+        case SCOPE_SCHEMA:
+            level.mNext = SLOT_IGNORED;
+            if (key == "fields") {
+                mHasFields = true;
+                mSchemaFields.clear();
+                level.mNext = SLOT_FIELDS;
+            } else if (key == "metadata") {
+                mHasMetadata = true;
+                level.mNext = SLOT_METADATA;
+            }
+            return true;
+        case SCOPE_FIELD:
+            return fieldKey(key);
+        case SCOPE_CHILD: {
+            // the first member tells a map entry from a field
+            auto& parent = mFields[level.mOwner];
+            if (key != "key" && key != "item") {
+                auto index = level.mIndex;
+                mLevels.pop_back();
+                openField(TARGET_CHILD);
+                mLevels.back().mIndex = index;
+                return fieldKey(key);
+            }
+            parent.mAnyEntry = true;
+            if (level.mIndex != 0) {
+                // only the first entry of a map counts
+                level.mScope = SCOPE_SKIPPED;
+                level.mNext = SLOT_IGNORED;
+                return true;
+            }
+            parent.mFirstIsEntry = true;
+            level.mScope = SCOPE_ENTRY;
+            return this->key(key);
+        }
+        case SCOPE_ENTRY:
+            // mIndex tells the field being opened which role it has
+            level.mNext = SLOT_IGNORED;
+            if (key == "key") {
+                level.mNext = SLOT_FIELD;
+                level.mIndex = 0;
+            } else if (key == "item") {
+                level.mNext = SLOT_FIELD;
+                level.mIndex = 1;
+            }
+            return true;
+        case SCOPE_TYPE:
+            if (key == "name") {
+                level.mNext = SLOT_TYPE_NAME;
+            } else if (key == "isSigned") {
+                level.mNext = SLOT_IS_SIGNED;
+            } else if (key == "bitWidth") {
+                level.mNext = SLOT_BIT_WIDTH;
+            } else if (key == "precision") {
+                level.mNext = SLOT_PRECISION;
+            } else if (key == "scale") {
+                level.mNext = SLOT_SCALE;
+            } else if (key == "unit") {
+                level.mNext = SLOT_UNIT;
+            } else if (key == "timezone") {
+                level.mNext = SLOT_TIMEZONE;
+            } else if (key == "byteWidth") {
+                level.mNext = SLOT_BYTE_WIDTH;
+            } else if (key == "keySorted") {
+                level.mNext = SLOT_KEY_SORTED;
+            } else {
+                level.mNext = SLOT_IGNORED;
+            }
+            return true;
+        case SCOPE_METADATA_ITEM:
+            level.mNext = SLOT_IGNORED;
+            if (key == "key") {
+                level.mNext = SLOT_METADATA_KEY;
+            } else if (key == "value") {
+                level.mNext = SLOT_METADATA_VALUE;
+            }
+            return true;
+        default:
+            level.mNext = SLOT_IGNORED;
+            return true;
+    }
+}
+
+bool SchemaSaxHandler::end_object() {
+    // an error inside an element of "children" may be held, the object is
+    // then closed as skipped
+    bool ok = true;
+    switch (mLevels.back().mScope) {
+        case SCOPE_FIELD:
+            ok = closeField();
+            break;
+        case SCOPE_CHILD:
+            ok = fail("empty child object");
+            break;
+        case SCOPE_METADATA_ITEM:
+            ok = closeMetadataItem();
+            break;
+        default:
+            break;
+    }
+    if (!ok) {
+        return false;
+    }
+
+    mLevels.pop_back();
+    mDone = mLevels.empty();
+    return true;
+}
+
+bool SchemaSaxHandler::closeMetadataItem() {
+    int seen = mLevels.back().mIndex;
+    if (!(seen & kMetadataKey)) {
+        return fail("metadata entry has no key");
+    }
+    if (!(seen & kMetadataValue)) {
+        return fail("metadata entry has no value");
+    }
+    return true;
+}
+
+bool SchemaSaxHandler::closeField() {
+    auto& field = mFields[mDepth - 1];
+    if (!field.mHasName) {
+        return fail("field has no name");
+    }
+    if (!field.mHasTypeName) {
+        return fail("field has no type name");
+    }
+
+    auto& spec = field.mSpec;
+    if (!field.mChildStatus.ok() &&
+        ReadsChild(spec.mTypeName, static_cast<size_t>(field.mChildIndex))) {
+        return fail(field.mChildStatus);
+    }
+    spec.mName = field.mName;
+    spec.mPrecisionName = field.mPrecisionName;
+    spec.mUnit = field.mUnit;
+    spec.mTimezone = field.mTimezone;
+
+    if (HasChildren(spec.mTypeName) && !field.mHasChildren) {
+        return fail("no children found");
+    }
+    int required = RequiredTypeParams(spec.mTypeName);
+    int missing = required & ~field.mParams;
+    if (missing != 0) {
+        return fail(std::string{ "type has no " } +
+                    TypeParamKey(missing & -missing));
+    }
+
+    switch (spec.mTypeName) {
+        case datatype::TYPE_NAME_LIST:
+            if (field.mChildren.empty() || field.mFirstIsEntry) {
+                return fail("list has no element field");
+            }
+            break;
+        case datatype::TYPE_NAME_MAP:
+            if (!field.mFirstIsEntry || field.mMapKey == nullptr ||
+                field.mMapItem == nullptr) {
+                return fail("map has no key and item fields");
+            }
+            field.mChildren.clear();
+            field.mChildren.push_back(std::move(field.mMapKey));
+            field.mChildren.push_back(std::move(field.mMapItem));
+            break;
+        case datatype::TYPE_NAME_STRUCT:
+            if (field.mAnyEntry) {
+                return fail("struct child is not a field");
+            }
+            break;
+        default:
+            break;
+    }
+
+    arrow::Result<std::shared_ptr<arrow::Field>> result{};
+    if (mValidateOnly) {
+        // children only need to be there, a shared stand-in takes their place
+        static const auto kCheckedField = arrow::field("", arrow::null());
+        auto status = ValidateFieldSpec(spec);
+        if (!status.ok()) {
+            return fail(std::move(status));
+        }
+        result = kCheckedField;
+    } else {
+        result = BuildField(spec,
+                            field.mChildren,
+                            field.mHasMetadata,
+                            field.mKeys,
+                            field.mValues,
+                            mInterner);
+    }
+    if (!result.ok()) {
+        return fail(result.status());
+    }
+
+    auto target = field.mTarget;
+    mDepth--;
+    if (target == TARGET_SCHEMA) {
+        mSchemaFields.push_back(std::move(result).ValueOrDie());
+        return true;
+    }
+
+    auto& parent = mFields[mDepth - 1];
+    switch (target) {
+        case TARGET_MAP_KEY:
+            parent.mMapKey = std::move(result).ValueOrDie();
+            break;
+        case TARGET_MAP_ITEM:
+            parent.mMapItem = std::move(result).ValueOrDie();
+            break;
+        default:
+            parent.mChildren.push_back(std::move(result).ValueOrDie());
+            break;
+    }
+    return true;
+}
+
+bool SchemaSaxHandler::start_array(std::size_t) {
+    auto slot = NEXT_SLOT();
+    int owner = mDepth > 0 ? static_cast<int>(mDepth) - 1 : -1;
+    switch (slot) {
+        case SLOT_FIELDS:
+            mLevels.push_back({ SCOPE_FIELDS, SLOT_FIELD, -1, 0 });
+            return true;
+        case SLOT_CHILDREN:
+            mLevels.push_back({ SCOPE_CHILDREN, SLOT_CHILD, owner, 0 });
+            return true;
+        case SLOT_METADATA: {
+            // the metadata of the schema or of the innermost open field
+            if (mLevels.back().mScope == SCOPE_SCHEMA) {
+                owner = -1;
+            }
+            Level level{ SCOPE_METADATA, SLOT_METADATA_ITEM, owner, 0 };
+            metadataKeys(level).clear();
+            metadataValues(level).clear();
+            mLevels.push_back(level);
+            return true;
+        }
+        case SLOT_IGNORED:
+            mLevels.push_back({ SCOPE_SKIPPED, SLOT_IGNORED, owner, 0 });
+            return true;
+        default:
+            // skipped, should the error be held
+            if (slot == SLOT_CHILD) {
+                mLevels.back().mIndex++;
+            }
+            mLevels.push_back({ SCOPE_SKIPPED, SLOT_IGNORED, owner, 0 });
+            return fail("unexpected array");
+    }
+}
+
+bool SchemaSaxHandler::end_array() {
+    mLevels.pop_back();
+    mDone = mLevels.empty();
+    return true;
+}
+
+#undef NEXT_SLOT
+
+bool SchemaSaxHandler::parse_error(std::size_t,
+                                   const std::string&,
+                                   const nlohmann::detail::exception& ex) {
+    // a syntax error ends the document, it is never held
+    if (mStatus.ok()) {
+        mStatus = arrow::Status::Invalid(ex.what());
+    }
+    return false;
+}
+
+std::vector<std::string>& SchemaSaxHandler::metadataKeys(const Level& level) {
+    return level.mOwner < 0 ? mSchemaKeys : mFields[level.mOwner].mKeys;
+}
+
+std::vector<std::string>& SchemaSaxHandler::metadataValues(
+    const Level& level) {
+    return level.mOwner < 0 ? mSchemaValues : mFields[level.mOwner].mValues;
+}
@@ -0,0 +1,132 @@
+#ifndef _SCHEMA_SAX_HANDLER_H_
+#define _SCHEMA_SAX_HANDLER_H_
+
+#include <arrow/result.h>
+#include <arrow/type.h>
+
+#include <cstdint>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace converter {
+class TypeInterner;
+}
+
+/**
+ * SchemaSaxHandler builds an arrow::Schema straight from the events of
+ * nlohmann::json::sax_parse(), without materializing the document as a DOM.
+ * A field is turned into an arrow::Field (through BuildField) as soon as its
+ * object closes, so only the fields still open are held in memory.
+ *
+ * Members of an object may come in any order: the children of a field are
+ * converted before its type is known, map entries ({"key", "item"}) being
+ * told apart from fields by their first member. The elements of "children"
+ * JSONToSchema does not read (ReadsChild) are skipped: an error inside one
+ * met before the type of its field is held until the field closes. The
+ * handler accepts the same documents as converter::JSONToSchema, reporting
+ * malformed ones through Finish() instead of throwing.
+ *
+ * The handler is reusable: Reset() prepares it for another document and keeps
+ * the capacity of its scratch storage.
+ *
+ * mInterner: interning table of the built types, nullptr if not interning
+ * mValidateOnly: whether fields are only checked, not built
+ * mLevels: containers currently open, innermost last
+ * mFields: fields currently open, innermost last (mFields[0, mDepth))
+ * mDepth: number of fields currently open
+ * mSchemaFields: top-level fields converted so far
+ * mSchemaKeys: schema metadata keys
+ * mSchemaValues: schema metadata values
+ * mHasSchema: whether the "schema" member was seen
+ * mHasFields: whether the "fields" member of the schema was seen
+ * mHasMetadata: whether the "metadata" member of the schema was seen
+ * mDone: whether the top-level value is complete
+ * mStatus: first error encountered
+ */
+class SchemaSaxHandler {
+public:
+    using json = nlohmann::json;
+
+    /**
+     * @param[in] interner Interning table of the built types, nullptr if they
+     * are not interned. Must outlive the handler
+     * @param[in] validateOnly Check the fields (ValidateFieldSpec) without
+     * building them, Finish() returning a null schema for a valid document
+     */
+    explicit SchemaSaxHandler(converter::TypeInterner* interner = nullptr,
+                              bool validateOnly = false);
+    ~SchemaSaxHandler();
+
+    /**
+     * @brief Forget the current document, keeping the scratch storage
+     */
+    void Reset();
+
+    /**
+     * @brief Build the schema once the parser returned
+     * @return arrow::Result contains the converted arrow::Schema if the
+     * document was complete and valid, descriptive status otherwise
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> Finish();
+
+    /**
+     * @brief First error encountered so far, OK if none. This is why an event
+     * returned false
+     */
+    const arrow::Status& CurrentStatus() const { return mStatus; }
+
+    /**
+     * @brief Number of top-level fields converted so far
+     */
+    size_t NumSchemaFields() const { return mSchemaFields.size(); }
+
+    // nlohmann::json_sax interface
+    bool null();
+    bool boolean(bool value);
+    bool number_integer(json::number_integer_t value);
+    bool number_unsigned(json::number_unsigned_t value);
+    bool number_float(json::number_float_t value, const json::string_t&);
+    bool string(json::string_t& value);
+    bool binary(json::binary_t& value);
+    bool start_object(std::size_t);
+    bool key(json::string_t& key);
+    bool end_object();
+    bool start_array(std::size_t);
+    bool end_array();
+    bool parse_error(std::size_t position,
+                     const std::string& lastToken,
+                     const nlohmann::detail::exception& ex);
+
+private:
+    struct Level;
+    struct FieldState;
+
+    bool fail(const std::string& message);
+    bool fail(arrow::Status status);
+    bool number(int value);
+    bool badNumber(const char* problem);
+    bool openField(int target);
+    bool closeField();
+    bool closeMetadataItem();
+    bool fieldKey(const json::string_t& key);
+    std::vector<std::string>& metadataKeys(const Level& level);
+    std::vector<std::string>& metadataValues(const Level& level);
+
+    converter::TypeInterner* mInterner{};
+    bool mValidateOnly{};
+    std::vector<Level> mLevels;
+    std::vector<FieldState> mFields;
+    size_t mDepth{};
+    std::vector<std::shared_ptr<arrow::Field>> mSchemaFields{};
+    std::vector<std::string> mSchemaKeys{};
+    std::vector<std::string> mSchemaValues{};
+    bool mHasSchema{};
+    bool mHasFields{};
+    bool mHasMetadata{};
+    bool mDone{};
+    arrow::Status mStatus{};
+};
+
+#endif // _SCHEMA_SAX_HANDLER_H_
@@ -0,0 +1,120 @@
+#include "Schema_JSON_Allocator.h"
+
+#include <algorithm>
+#include <cstring>
+
+static thread_local arrow::MemoryPool* tCurrentPool = nullptr;
+
+arrow::MemoryPool* converter::CurrentMemoryPool() {
+    return tCurrentPool != nullptr ? tCurrentPool
+                                   : arrow::default_memory_pool();
+}
+
+converter::MemoryPoolScope::MemoryPoolScope(arrow::MemoryPool* pool)
+    : mPrevious{ tCurrentPool } {
+    tCurrentPool = pool;
+}
+
+converter::MemoryPoolScope::~MemoryPoolScope() {
+    tCurrentPool = mPrevious;
+}
+
+converter::ArenaMemoryPool::ArenaMemoryPool(arrow::MemoryPool* parent,
+                                            int64_t blockSize)
+    : mParent{ parent != nullptr ? parent : arrow::default_memory_pool() }
+    , mBlockSize{ std::max<int64_t>(blockSize, 1024) } {}
+
+converter::ArenaMemoryPool::~ArenaMemoryPool() {
+    Reset();
+}
+
+arrow::Status converter::ArenaMemoryPool::Allocate(int64_t size,
+                                                   int64_t alignment,
+                                                   uint8_t** out) {
+    if (size < 0) {
+        return arrow::Status::Invalid("negative allocation size");
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // alignment is a power of two
+    auto alignedOffset = [&](int64_t offset) {
+        auto address = reinterpret_cast<uintptr_t>(mBlocks.back().first);
+        auto aligned = (address + offset + alignment - 1) &
+                       ~static_cast<uintptr_t>(alignment - 1);
+        return static_cast<int64_t>(aligned - address);
+    };
+
+    if (mBlocks.empty() ||
+        alignedOffset(mOffset) + size > mBlocks.back().second) {
+        int64_t blockSize = std::max(mBlockSize, size + alignment);
+        uint8_t* block = nullptr;
+        auto status = mParent->Allocate(blockSize, &block);
+        if (!status.ok()) {
+            return status;
+        }
+        mBlocks.emplace_back(block, blockSize);
+        mOffset = 0;
+    }
+
+    int64_t offset = alignedOffset(mOffset);
+    *out = mBlocks.back().first + offset;
+    mOffset = offset + size;
+
+    auto bytes = mBytesAllocated.fetch_add(size) + size;
+    auto peak = mMaxMemory.load();
+    while (bytes > peak && !mMaxMemory.compare_exchange_weak(peak, bytes)) {
+    }
+    mTotalBytesAllocated.fetch_add(size);
+    mNumAllocations.fetch_add(1);
+    return arrow::Status::OK();
+}
+
+arrow::Status converter::ArenaMemoryPool::Reallocate(int64_t oldSize,
+                                                     int64_t newSize,
+                                                     int64_t alignment,
+                                                     uint8_t** ptr) {
+    uint8_t* data = nullptr;
+    auto status = Allocate(newSize, alignment, &data);
+    if (!status.ok()) {
+        return status;
+    }
+    std::memcpy(data, *ptr, static_cast<size_t>(std::min(oldSize, newSize)));
+    Free(*ptr, oldSize, alignment);
+    *ptr = data;
+    return arrow::Status::OK();
+}
+
+void converter::ArenaMemoryPool::Free(uint8_t*, int64_t size, int64_t) {
+    mBytesAllocated.fetch_sub(size);
+}
+
+void converter::ArenaMemoryPool::Reset() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& block : mBlocks) {
+        mParent->Free(block.first, block.second);
+    }
+    mBlocks.clear();
+    mOffset = 0;
+    mBytesAllocated = 0;
+}
+
+int64_t converter::ArenaMemoryPool::bytes_allocated() const {
+    return mBytesAllocated.load();
+}
+
+int64_t converter::ArenaMemoryPool::max_memory() const {
+    return mMaxMemory.load();
+}
+
+int64_t converter::ArenaMemoryPool::total_bytes_allocated() const {
+    return mTotalBytesAllocated.load();
+}
+
+int64_t converter::ArenaMemoryPool::num_allocations() const {
+    return mNumAllocations.load();
+}
+
+std::string converter::ArenaMemoryPool::backend_name() const {
+    return "arena(" + mParent->backend_name() + ")";
+}
@@ -0,0 +1,193 @@
+#include "Schema_JSON_Cache.h"
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <variant>
+
+#include "LRUCache.h"
+#include "Schema_JSON_Conversion.h"
+
+using json = nlohmann::json;
+
+/**
+ * Both result forms live in the same cache. The key is the schema's
+ * fingerprints prefixed with a tag telling which form is stored
+ */
+using CachedResult = std::variant<std::shared_ptr<const json>,
+                                  std::shared_ptr<const std::string>>;
+
+static constexpr char kJsonTag = 'j';
+static constexpr char kStringTag = 's';
+
+/**
+ * @brief Build the cache key of a schema
+ * @return The key, empty if the schema cannot be fingerprinted
+ */
+static std::string makeKey(char tag, const arrow::Schema& schema) {
+    const auto& fingerprint = schema.fingerprint();
+    if (fingerprint.empty()) {
+        return {};
+    }
+    const auto& metadataFingerprint = schema.metadata_fingerprint();
+
+    std::string key{};
+    key.reserve(fingerprint.size() + metadataFingerprint.size() + 2);
+    key.push_back(tag);
+    key.append(fingerprint);
+    key.push_back('\0');
+    key.append(metadataFingerprint);
+    return key;
+}
+
+class converter::SchemaJSONCache::Impl {
+public:
+    Impl(size_t capacity, size_t numShards)
+        : mCache{ capacity, numShards } {};
+
+    ShardedLRUCache<std::string, CachedResult> mCache;
+};
+
+converter::SchemaJSONCache::SchemaJSONCache(size_t capacity, size_t numShards)
+    : mImpl{ std::make_unique<Impl>(capacity, numShards) } {}
+
+converter::SchemaJSONCache::~SchemaJSONCache() = default;
+
+arrow::Result<std::shared_ptr<const json>>
+converter::SchemaJSONCache::SchemaToJSON(
+    const std::shared_ptr<arrow::Schema>& schema) {
+    auto key = makeKey(kJsonTag, *schema);
+    if (!key.empty()) {
+        auto cached = mImpl->mCache.Get(key);
+        if (cached.has_value()) {
+            return std::get<std::shared_ptr<const json>>(*cached);
+        }
+    }
+
+    auto result = converter::SchemaToJSON(schema);
+    if (!result.ok()) {
+        return result.status();
+    }
+    auto shared =
+        std::make_shared<const json>(std::move(result).ValueOrDie());
+    if (!key.empty()) {
+        mImpl->mCache.Put(key, shared);
+    }
+    return shared;
+}
+
+arrow::Result<std::shared_ptr<const std::string>>
+converter::SchemaJSONCache::SchemaToJSONString(
+    const std::shared_ptr<arrow::Schema>& schema) {
+    auto key = makeKey(kStringTag, *schema);
+    if (!key.empty()) {
+        auto cached = mImpl->mCache.Get(key);
+        if (cached.has_value()) {
+            return std::get<std::shared_ptr<const std::string>>(*cached);
+        }
+    }
+
+    auto result = converter::SchemaToJSONString(schema);
+    if (!result.ok()) {
+        return result.status();
+    }
+    auto shared =
+        std::make_shared<const std::string>(std::move(result).ValueOrDie());
+    if (!key.empty()) {
+        mImpl->mCache.Put(key, shared);
+    }
+    return shared;
+}
+
+void converter::SchemaJSONCache::Invalidate(
+    const std::shared_ptr<arrow::Schema>& schema) {
+    auto key = makeKey(kJsonTag, *schema);
+    if (key.empty()) {
+        return;
+    }
+    mImpl->mCache.Erase(key);
+    key[0] = kStringTag;
+    mImpl->mCache.Erase(key);
+}
+
+void converter::SchemaJSONCache::Clear() {
+    mImpl->mCache.Clear();
+}
+
+converter::CacheStats converter::SchemaJSONCache::Stats() const {
+    auto counters = mImpl->mCache.GetCounters();
+    return {
+        counters.hits, counters.misses, counters.evictions, counters.size
+    };
+}
+
+/**
+ * A decoded schema together with the text it was decoded from, compared
+ * against on lookup since the key is only a hash of it
+ *
+ * mText: raw json text
+ * mSchema: decoded schema
+ */
+struct DecodedSchema {
+    std::string mText{};
+    std::shared_ptr<arrow::Schema> mSchema{};
+};
+
+class converter::SchemaDecodeCache::Impl {
+public:
+    Impl(size_t capacity,
+         size_t numShards,
+         const converter::JSONToSchemaOptions& options)
+        : mCache{ capacity, numShards }
+        , mOptions{ options } {};
+
+    ShardedLRUCache<uint64_t, std::shared_ptr<const DecodedSchema>> mCache;
+    converter::JSONToSchemaOptions mOptions;
+    // lookups whose hash matched a different text, counted by mCache as hits
+    std::atomic<uint64_t> mCollisions{ 0 };
+};
+
+converter::SchemaDecodeCache::SchemaDecodeCache(
+    size_t capacity,
+    size_t numShards,
+    const JSONToSchemaOptions& options)
+    : mImpl{ std::make_unique<Impl>(capacity, numShards, options) } {}
+
+converter::SchemaDecodeCache::~SchemaDecodeCache() = default;
+
+arrow::Result<std::shared_ptr<arrow::Schema>>
+converter::SchemaDecodeCache::JSONTextToSchema(std::string_view text) {
+    uint64_t key = std::hash<std::string_view>{}(text);
+    auto cached = mImpl->mCache.Get(key);
+    if (cached.has_value()) {
+        const auto& entry = **cached;
+        if (entry.mText.size() == text.size() &&
+            std::memcmp(entry.mText.data(), text.data(), text.size()) == 0) {
+            return entry.mSchema;
+        }
+        mImpl->mCollisions++;
+    }
+
+    auto result = converter::JSONTextToSchema(text, mImpl->mOptions);
+    if (!result.ok()) {
+        return result.status();
+    }
+    auto entry = std::make_shared<const DecodedSchema>(
+        DecodedSchema{ std::string{ text }, result.ValueOrDie() });
+    mImpl->mCache.Put(key, std::move(entry));
+    return result;
+}
+
+void converter::SchemaDecodeCache::Clear() {
+    mImpl->mCache.Clear();
+}
+
+converter::CacheStats converter::SchemaDecodeCache::Stats() const {
+    auto counters = mImpl->mCache.GetCounters();
+    uint64_t collisions = mImpl->mCollisions.load();
+    return { counters.hits - collisions,
+             counters.misses + collisions,
+             counters.evictions,
+             counters.size };
+}
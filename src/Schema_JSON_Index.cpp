@@ -0,0 +1,481 @@
+#include "Schema_JSON_Index.h"
+
+#include <arrow/buffer.h>
+#include <arrow/io/file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+/**
+ * Role is what a container of the text stands for, as far as the index is
+ * concerned
+ */
+enum Role {
+    ROLE_OTHER,    // anything the index skips over
+    ROLE_ROOT,     // the document
+    ROLE_SCHEMA,   // the "schema" object
+    ROLE_FIELDS,   // the "fields" array of the schema
+    ROLE_METADATA, // the "metadata" value of the schema
+    ROLE_FIELD,    // the object of an indexed field
+    ROLE_CHILDREN, // the "children" array of an indexed field
+    ROLE_CHILD,    // an element of "children", field or map entry
+    ROLE_ENTRY,    // a map entry ({"key", "item"})
+};
+
+/**
+ * ScanFrame is a container open at the current position of the scan
+ *
+ * mKind: '{' or '['
+ * mRole: what the container stands for
+ * mBegin: offset of its opening bracket
+ * mKey: last key of an object
+ * mExpectKey: whether the next string of an object is a key
+ * mEntry: entry of the field, or of the field owning the children or entry
+ * mDepth: nesting level of the field, 0 at the top level
+ * mCount: number of elements started so far in an array
+ */
+struct ScanFrame {
+    char mKind{};
+    Role mRole{};
+    size_t mBegin{};
+    std::string_view mKey{};
+    bool mExpectKey{};
+    int64_t mEntry{ -1 };
+    int mDepth{};
+    uint64_t mCount{};
+};
+
+static arrow::Status malformed(size_t pos) {
+    return arrow::Status::Invalid("malformed json at byte ", pos);
+}
+
+/**
+ * @brief Find the end of the string starting at pos
+ * @return Offset one past the closing quote, npos if the string is not
+ * terminated
+ */
+static size_t stringEnd(std::string_view text, size_t pos) {
+    const char* data = text.data();
+    size_t i = pos + 1;
+    while (i < text.size()) {
+        auto* quote = static_cast<const char*>(
+            std::memchr(data + i, '"', text.size() - i));
+        if (quote == nullptr) {
+            return std::string_view::npos;
+        }
+        size_t end = quote - data;
+        size_t slashes = 0;
+        while (end - slashes > pos + 1 && data[end - slashes - 1] == '\\') {
+            slashes++;
+        }
+        if (slashes % 2 == 0) {
+            return end + 1;
+        }
+        i = end + 1;
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * @brief Helper function turns a name token (quotes included) into the name
+ */
+static std::string unquote(std::string_view token) {
+    if (token.size() < 2) {
+        return {};
+    }
+    if (token.find('\\') == std::string_view::npos) {
+        return std::string{ token.substr(1, token.size() - 2) };
+    }
+    auto name = nlohmann::json::parse(token, nullptr, false);
+    if (!name.is_string()) {
+        return {};
+    }
+    return name.get<std::string>();
+}
+
+arrow::Result<converter::SchemaIndex> converter::BuildSchemaIndex(
+    std::string_view text,
+    const SchemaIndexOptions& options) {
+    SchemaIndex index{};
+    index.mTextSize = text.size();
+    auto& entries = index.mEntries;
+    // name token of each entry, "key" and "item" for the members of a map
+    std::vector<std::string_view> segments{};
+    std::vector<ScanFrame> stack{};
+    bool hasFields = false;
+    bool done = false;
+
+    auto addEntry = [&](int64_t parent, uint64_t position, size_t begin) {
+        SchemaIndexEntry entry{};
+        entry.parent = parent;
+        entry.position = position;
+        entry.offset = begin;
+        entries.push_back(std::move(entry));
+        segments.emplace_back();
+        return static_cast<int64_t>(entries.size() - 1);
+    };
+    auto indexesChildren = [&](int depth) {
+        return options.nestedDepth < 0 || depth < options.nestedDepth;
+    };
+
+    // called as a value starts, before it is pushed (containers) or skipped
+    // (scalars). Returns the role of a container value
+    auto startValue = [&](char kind, size_t pos) {
+        if (stack.empty()) {
+            return kind == '{' ? ROLE_ROOT : ROLE_OTHER;
+        }
+        auto& parent = stack.back();
+        if (parent.mKind == '[') {
+            parent.mCount++;
+        }
+        auto key = parent.mKey;
+        switch (parent.mRole) {
+        case ROLE_ROOT:
+            return key == "schema" && kind == '{' ? ROLE_SCHEMA : ROLE_OTHER;
+        case ROLE_SCHEMA:
+            if (key == "fields" && kind == '[') {
+                hasFields = true;
+                return ROLE_FIELDS;
+            }
+            if (key == "metadata") {
+                index.mMetadataOffset = pos;
+                return ROLE_METADATA;
+            }
+            return ROLE_OTHER;
+        case ROLE_FIELDS:
+            return kind == '{' ? ROLE_FIELD : ROLE_OTHER;
+        case ROLE_FIELD:
+            return key == "children" && kind == '[' &&
+                           indexesChildren(parent.mDepth)
+                       ? ROLE_CHILDREN
+                       : ROLE_OTHER;
+        case ROLE_CHILDREN:
+            return kind == '{' ? ROLE_CHILD : ROLE_OTHER;
+        case ROLE_ENTRY:
+            return (key == "key" || key == "item") && kind == '{'
+                       ? ROLE_FIELD
+                       : ROLE_OTHER;
+        default:
+            return ROLE_OTHER;
+        }
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        char c = text[pos];
+        switch (c) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+        case ':':
+            pos++;
+            continue;
+        case ',':
+            if (stack.empty()) {
+                return malformed(pos);
+            }
+            stack.back().mExpectKey = stack.back().mKind == '{';
+            pos++;
+            continue;
+        case '{':
+        case '[': {
+            if (done) {
+                return malformed(pos);
+            }
+            auto role = startValue(c, pos);
+            ScanFrame frame{};
+            frame.mKind = c;
+            frame.mRole = role;
+            frame.mBegin = pos;
+            frame.mExpectKey = c == '{';
+            if (!stack.empty()) {
+                const auto& parent = stack.back();
+                frame.mEntry = parent.mEntry;
+                frame.mDepth = parent.mDepth;
+                if (role == ROLE_FIELD && parent.mRole == ROLE_FIELDS) {
+                    frame.mEntry = addEntry(-1, parent.mCount - 1, pos);
+                } else if (role == ROLE_FIELD) {
+                    // a member of a map entry: the position of the entry
+                    const auto& children = stack[stack.size() - 2];
+                    frame.mEntry =
+                        addEntry(parent.mEntry, children.mCount - 1, pos);
+                    segments.back() = parent.mKey;
+                } else if (role == ROLE_CHILD) {
+                    frame.mDepth++;
+                }
+            }
+            stack.push_back(frame);
+            pos++;
+            continue;
+        }
+        case '}':
+        case ']': {
+            if (stack.empty() || (stack.back().mKind == '{') != (c == '}')) {
+                return malformed(pos);
+            }
+            const auto& frame = stack.back();
+            if (frame.mRole == ROLE_FIELD) {
+                entries[frame.mEntry].length = pos + 1 - frame.mBegin;
+            } else if (frame.mRole == ROLE_METADATA) {
+                index.mMetadataLength = pos + 1 - frame.mBegin;
+            }
+            stack.pop_back();
+            done = stack.empty();
+            pos++;
+            continue;
+        }
+        case '"': {
+            if (stack.empty()) {
+                return malformed(pos);
+            }
+            auto end = stringEnd(text, pos);
+            if (end == std::string_view::npos) {
+                return arrow::Status::Invalid(
+                    "unterminated string at byte ", pos);
+            }
+            auto token = text.substr(pos, end - pos);
+            auto& top = stack.back();
+            if (top.mExpectKey) {
+                top.mKey = token.substr(1, token.size() - 2);
+                top.mExpectKey = false;
+                if (top.mRole == ROLE_CHILD) {
+                    // told apart by the first member, the way the decoders do
+                    bool isEntry = top.mKey == "key" || top.mKey == "item";
+                    top.mRole = isEntry ? ROLE_ENTRY : ROLE_FIELD;
+                    const auto& children = stack[stack.size() - 2];
+                    if (!isEntry) {
+                        top.mEntry =
+                            addEntry(top.mEntry, children.mCount - 1,
+                                     top.mBegin);
+                    }
+                }
+            } else {
+                auto role = startValue('"', pos);
+                if (role == ROLE_METADATA) {
+                    index.mMetadataLength = token.size();
+                }
+                // the members of a map go by "key" and "item", not by name
+                if (top.mRole == ROLE_FIELD && top.mKey == "name" &&
+                    stack[stack.size() - 2].mRole != ROLE_ENTRY) {
+                    segments[top.mEntry] = token;
+                }
+            }
+            pos = end;
+            continue;
+        }
+        default: {
+            if (stack.empty()) {
+                return malformed(pos);
+            }
+            auto end = text.find_first_of(" \t\r\n,]}", pos);
+            if (end == std::string_view::npos) {
+                end = text.size();
+            }
+            if (startValue(c, pos) == ROLE_METADATA) {
+                index.mMetadataLength = end - pos;
+            }
+            pos = end;
+            continue;
+        }
+        }
+    }
+    if (!done) {
+        return arrow::Status::Invalid("unexpected end of json at byte ", pos);
+    }
+    if (!hasFields) {
+        return arrow::Status::Invalid("no schema fields array in the json");
+    }
+
+    // entries come before their children: the path of the parent is known
+    for (auto& entry : entries) {
+        auto i = &entry - entries.data();
+        auto segment = segments[i];
+        auto name = segment.empty() || segment[0] != '"'
+                        ? std::string{ segment }
+                        : unquote(segment);
+        entry.path = entry.parent < 0 ? std::move(name)
+                                      : entries[entry.parent].path + "." + name;
+    }
+    index.sortPaths();
+    return index;
+}
+
+void converter::SchemaIndex::sortPaths() {
+    mByPath.resize(mEntries.size());
+    for (size_t i = 0; i < mByPath.size(); i++) {
+        mByPath[i] = static_cast<int>(i);
+    }
+    std::stable_sort(mByPath.begin(), mByPath.end(), [this](int a, int b) {
+        return mEntries[a].path < mEntries[b].path;
+    });
+}
+
+/**
+ * @brief Helper function finds the entries with a path in the sorted ones
+ */
+static std::pair<std::vector<int>::const_iterator,
+                 std::vector<int>::const_iterator>
+equalPaths(const std::vector<converter::SchemaIndexEntry>& entries,
+           const std::vector<int>& byPath,
+           std::string_view path) {
+    auto begin = std::lower_bound(
+        byPath.begin(), byPath.end(), path, [&](int i, std::string_view p) {
+            return std::string_view{ entries[i].path } < p;
+        });
+    auto end = begin;
+    while (end != byPath.end() && entries[*end].path == path) {
+        end++;
+    }
+    return { begin, end };
+}
+
+int converter::SchemaIndex::Find(std::string_view path) const {
+    auto range = equalPaths(mEntries, mByPath, path);
+    return range.first == range.second ? -1 : *range.first;
+}
+
+std::vector<int> converter::SchemaIndex::FindAll(std::string_view path) const {
+    auto range = equalPaths(mEntries, mByPath, path);
+    return std::vector<int>{ range.first, range.second };
+}
+
+/**
+ * The binary form is the magic "SJIX", a version byte, then unsigned LEB128
+ * varints: text size, metadata offset and length, number of entries, and for
+ * each entry its path length and bytes, parent + 1, position, offset, length
+ */
+static constexpr char kIndexMagic[] = "SJIX";
+static constexpr uint8_t kIndexVersion = 1;
+
+static void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static bool getVarint(std::string_view& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        auto byte = static_cast<uint8_t>(in[0]);
+        in.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string converter::SchemaIndex::Serialize() const {
+    std::string out{ kIndexMagic };
+    out.push_back(static_cast<char>(kIndexVersion));
+    putVarint(out, mTextSize);
+    putVarint(out, mMetadataOffset);
+    putVarint(out, mMetadataLength);
+    putVarint(out, mEntries.size());
+    for (const auto& entry : mEntries) {
+        putVarint(out, entry.path.size());
+        out += entry.path;
+        putVarint(out, static_cast<uint64_t>(entry.parent + 1));
+        putVarint(out, entry.position);
+        putVarint(out, entry.offset);
+        putVarint(out, entry.length);
+    }
+    return out;
+}
+
+arrow::Result<converter::SchemaIndex> converter::SchemaIndex::Deserialize(
+    std::string_view data) {
+    auto truncated = [] {
+        return arrow::Status::Invalid("truncated schema index");
+    };
+    std::string_view magic{ kIndexMagic };
+    if (data.substr(0, magic.size()) != magic) {
+        return arrow::Status::Invalid("not a schema index");
+    }
+    data.remove_prefix(magic.size());
+    if (data.empty()) {
+        return truncated();
+    }
+    if (static_cast<uint8_t>(data[0]) != kIndexVersion) {
+        return arrow::Status::NotImplemented(
+            "schema index version ", static_cast<int>(data[0]));
+    }
+    data.remove_prefix(1);
+
+    SchemaIndex index{};
+    uint64_t count = 0;
+    if (!getVarint(data, index.mTextSize) ||
+        !getVarint(data, index.mMetadataOffset) ||
+        !getVarint(data, index.mMetadataLength) || !getVarint(data, count)) {
+        return truncated();
+    }
+    // every entry takes at least 5 bytes: do not trust count for reserving
+    index.mEntries.reserve(std::min<uint64_t>(count, data.size() / 5));
+    for (uint64_t i = 0; i < count; i++) {
+        SchemaIndexEntry entry{};
+        uint64_t size = 0;
+        uint64_t parent = 0;
+        if (!getVarint(data, size) || data.size() < size) {
+            return truncated();
+        }
+        entry.path.assign(data.substr(0, size));
+        data.remove_prefix(size);
+        if (!getVarint(data, parent) || !getVarint(data, entry.position) ||
+            !getVarint(data, entry.offset) || !getVarint(data, entry.length)) {
+            return truncated();
+        }
+        if (parent > i) {
+            return arrow::Status::Invalid(
+                "schema index entry ", i, " has a bad parent");
+        }
+        entry.parent = static_cast<int64_t>(parent) - 1;
+        index.mEntries.push_back(std::move(entry));
+    }
+    if (!data.empty()) {
+        return arrow::Status::Invalid("trailing bytes after the schema index");
+    }
+    index.sortPaths();
+    return index;
+}
+
+arrow::Status converter::WriteSchemaIndex(const SchemaIndex& index,
+                                          const std::string& path) {
+    auto file = arrow::io::FileOutputStream::Open(path);
+    if (!file.ok()) {
+        return file.status();
+    }
+    auto sink = std::move(file).ValueOrDie();
+    auto data = index.Serialize();
+    auto status = sink->Write(data.data(), static_cast<int64_t>(data.size()));
+    auto closed = sink->Close();
+    if (!status.ok()) {
+        return status;
+    }
+    return closed;
+}
+
+arrow::Result<converter::SchemaIndex> converter::ReadSchemaIndex(
+    const std::string& path) {
+    auto file = arrow::io::ReadableFile::Open(path);
+    if (!file.ok()) {
+        return file.status();
+    }
+    auto source = std::move(file).ValueOrDie();
+    auto size = source->GetSize();
+    if (!size.ok()) {
+        return size.status();
+    }
+    auto buffer = source->Read(size.ValueOrDie());
+    if (!buffer.ok()) {
+        return buffer.status();
+    }
+    auto data = std::move(buffer).ValueOrDie();
+    return SchemaIndex::Deserialize(std::string_view{
+        reinterpret_cast<const char*>(data->data()),
+        static_cast<size_t>(data->size()) });
+}
@@ -0,0 +1,53 @@
+#include "Schema_JSON_PushDecoder.h"
+
+#include "JSONPushParser.h"
+#include "SchemaSaxHandler.h"
+
+/**
+ * mHandler: builder of the schema, fed by mParser
+ * mParser: tokenizer of the chunks
+ */
+class converter::SchemaPushDecoder::Impl {
+public:
+    explicit Impl(const JSONToSchemaOptions& options)
+        : mHandler{ options.interner }
+        , mParser{ &mHandler } {}
+
+    void Reset() {
+        mHandler.Reset();
+        mParser.Reset();
+    }
+
+    SchemaSaxHandler mHandler;
+    JSONPushParser mParser;
+};
+
+converter::SchemaPushDecoder::SchemaPushDecoder(
+    const JSONToSchemaOptions& options)
+    : mImpl{ std::make_unique<Impl>(options) } {}
+
+converter::SchemaPushDecoder::~SchemaPushDecoder() = default;
+
+arrow::Status converter::SchemaPushDecoder::Feed(std::string_view chunk) {
+    return mImpl->mParser.Feed(chunk);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>>
+converter::SchemaPushDecoder::Finish() {
+    auto status = mImpl->mParser.Finish();
+    if (!status.ok()) {
+        mImpl->Reset();
+        return status;
+    }
+    auto result = mImpl->mHandler.Finish();
+    mImpl->Reset();
+    return result;
+}
+
+void converter::SchemaPushDecoder::Reset() {
+    mImpl->Reset();
+}
+
+int converter::SchemaPushDecoder::NumFields() const {
+    return static_cast<int>(mImpl->mHandler.NumSchemaFields());
+}
@@ -0,0 +1,284 @@
+#include "Schema_JSON_StreamReader.h"
+
+#include <arrow/io/file.h>
+#include <arrow/io/interfaces.h>
+
+#include <algorithm>
+#include <deque>
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <vector>
+
+#include "Parallel.h"
+#include "SchemaSaxHandler.h"
+
+using json = nlohmann::json;
+
+/**
+ * Line is a line of the stream waiting to be decoded
+ *
+ * mBegin: offset of its first byte in the read buffer
+ * mEnd: offset one past its last byte, newline excluded
+ * mNumber: line number, starting at 1
+ */
+struct Line {
+    size_t mBegin{};
+    size_t mEnd{};
+    int64_t mNumber{};
+};
+
+/**
+ * Decoded is the outcome of a line, waiting to be returned
+ *
+ * mNumber: line number
+ * mResult: decoded schema or error
+ */
+struct Decoded {
+    int64_t mNumber{};
+    arrow::Result<std::shared_ptr<arrow::Schema>> mResult{};
+};
+
+/**
+ * @brief Whether a line holds nothing but whitespace
+ */
+static bool isBlank(std::string_view line) {
+    return line.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+/**
+ * mInput: stream read from
+ * mOptions: reading options
+ * mBuffer: bytes read and not consumed yet, from mBegin on
+ * mBegin: offset of the first byte not consumed
+ * mScanned: offset up to which mBuffer is known to hold no newline
+ * mEnd: whether the input is exhausted
+ * mInputStatus: first error of the input stream
+ * mLineCount: number of lines consumed
+ * mLineNumber: line of the last result returned
+ * mBatch: lines of the batch being collected
+ * mReady: decoded lines not returned yet, in stream order
+ * mHandlers: parser handlers, one per range of a parallel batch ([0] when
+ * decoding serially)
+ */
+class converter::SchemaStreamReader::Impl {
+public:
+    Impl(std::shared_ptr<arrow::io::InputStream> input,
+         const StreamReaderOptions& options)
+        : mInput{ std::move(input) }
+        , mOptions{ options } {
+        mOptions.blockSize = std::max<int64_t>(1, mOptions.blockSize);
+        mOptions.batchSize = std::max(1, mOptions.batchSize);
+    }
+
+    arrow::Result<std::shared_ptr<arrow::Schema>> Next();
+
+    std::shared_ptr<arrow::io::InputStream> mInput;
+    StreamReaderOptions mOptions;
+    std::string mBuffer{};
+    size_t mBegin{};
+    size_t mScanned{};
+    bool mEnd{};
+    arrow::Status mInputStatus{};
+    int64_t mLineCount{};
+    int64_t mLineNumber{};
+    std::vector<Line> mBatch{};
+    std::deque<Decoded> mReady{};
+    std::vector<std::unique_ptr<SchemaSaxHandler>> mHandlers{};
+
+private:
+    arrow::Status readBlock();
+    arrow::Result<bool> nextLine(Line& line);
+    void collectBatch(size_t maxLines);
+    void decode(SchemaSaxHandler& handler, const Line& line, Decoded& out);
+    SchemaSaxHandler& handler(size_t index);
+};
+
+/**
+ * @brief Read the next block of the input, after dropping the consumed bytes
+ * from the buffer. Offsets of the lines collected so far are shifted along
+ */
+arrow::Status converter::SchemaStreamReader::Impl::readBlock() {
+    size_t keep = mBatch.empty() ? mBegin : mBatch.front().mBegin;
+    if (keep > 0) {
+        mBuffer.erase(0, keep);
+        mBegin -= keep;
+        mScanned -= keep;
+        for (auto& line : mBatch) {
+            line.mBegin -= keep;
+            line.mEnd -= keep;
+        }
+    }
+
+    auto size = mBuffer.size();
+    auto blockSize = static_cast<size_t>(mOptions.blockSize);
+    mBuffer.resize(size + blockSize);
+    auto result = mInput->Read(mOptions.blockSize, mBuffer.data() + size);
+    if (!result.ok()) {
+        mBuffer.resize(size);
+        return result.status();
+    }
+    auto count = static_cast<size_t>(result.ValueOrDie());
+    mBuffer.resize(size + count);
+    mEnd = count == 0;
+    return arrow::Status::OK();
+}
+
+/**
+ * @brief Find the next line, reading blocks until its newline (or the end of
+ * the input) is in the buffer
+ * @return true if there is a line, false at the end of the input
+ */
+arrow::Result<bool> converter::SchemaStreamReader::Impl::nextLine(Line& line) {
+    while (true) {
+        auto newline = mBuffer.find('\n', mScanned);
+        if (newline != std::string::npos) {
+            line = { mBegin, newline, ++mLineCount };
+            mBegin = mScanned = newline + 1;
+            return true;
+        }
+        mScanned = mBuffer.size();
+        if (mEnd) {
+            if (mBegin == mBuffer.size()) {
+                return false;
+            }
+            // last line, without a newline
+            line = { mBegin, mBuffer.size(), ++mLineCount };
+            mBegin = mScanned = mBuffer.size();
+            return true;
+        }
+        auto status = readBlock();
+        if (!status.ok()) {
+            return status;
+        }
+    }
+}
+
+/**
+ * @brief Collect up to maxLines non-blank lines into mBatch. An input error
+ * ends the batch early and is kept in mInputStatus
+ */
+void converter::SchemaStreamReader::Impl::collectBatch(size_t maxLines) {
+    mBatch.clear();
+    while (mBatch.size() < maxLines) {
+        Line line{};
+        auto found = nextLine(line);
+        if (!found.ok()) {
+            // some streams fail with Invalid (e.g. once closed), which the
+            // caller would take for a malformed line and read on
+            mInputStatus = found.status().IsIOError()
+                               ? found.status()
+                               : arrow::Status::IOError(
+                                     found.status().ToString());
+            return;
+        }
+        if (!found.ValueOrDie()) {
+            return;
+        }
+        std::string_view text{ mBuffer.data() + line.mBegin,
+                               line.mEnd - line.mBegin };
+        if (!isBlank(text)) {
+            mBatch.push_back(line);
+        }
+    }
+}
+
+SchemaSaxHandler& converter::SchemaStreamReader::Impl::handler(size_t index) {
+    while (mHandlers.size() <= index) {
+        mHandlers.push_back(
+            std::make_unique<SchemaSaxHandler>(mOptions.interner));
+    }
+    return *mHandlers[index];
+}
+
+void converter::SchemaStreamReader::Impl::decode(SchemaSaxHandler& handler,
+                                                 const Line& line,
+                                                 Decoded& out) {
+    const char* begin = mBuffer.data() + line.mBegin;
+    const char* end = mBuffer.data() + line.mEnd;
+    handler.Reset();
+    json::sax_parse(begin, end, &handler);
+    out.mNumber = line.mNumber;
+    out.mResult = handler.Finish();
+    if (!out.mResult.ok()) {
+        const auto& status = out.mResult.status();
+        out.mResult =
+            status.WithMessage("line ", line.mNumber, ": ", status.message());
+    }
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>>
+converter::SchemaStreamReader::Impl::Next() {
+    if (mReady.empty() && mInputStatus.ok()) {
+        size_t batchSize = mOptions.useThreads
+                               ? static_cast<size_t>(mOptions.batchSize)
+                               : 1;
+        collectBatch(batchSize);
+        mReady.resize(mBatch.size());
+
+        int numLines = static_cast<int>(mBatch.size());
+        if (!mOptions.useThreads) {
+            for (int i = 0; i < numLines; i++) {
+                decode(handler(0), mBatch[i], mReady[i]);
+            }
+        } else {
+            // handlers are created up front, ranges only look theirs up
+            int numRanges = ParallelRangeCount(numLines, mOptions.executor);
+            if (numRanges > 0) {
+                handler(static_cast<size_t>(numRanges - 1));
+            }
+            auto status = ParallelForRanges(
+                numLines,
+                mOptions.executor,
+                [this](int range, int begin, int end) {
+                    auto& rangeHandler = *mHandlers[range];
+                    for (int i = begin; i < end; i++) {
+                        decode(rangeHandler, mBatch[i], mReady[i]);
+                    }
+                    return arrow::Status::OK();
+                });
+            if (!status.ok()) {
+                mReady.clear();
+                return status;
+            }
+        }
+        mBatch.clear();
+    }
+
+    if (mReady.empty()) {
+        if (!mInputStatus.ok()) {
+            return mInputStatus;
+        }
+        return nullptr;
+    }
+    auto decoded = std::move(mReady.front());
+    mReady.pop_front();
+    mLineNumber = decoded.mNumber;
+    return std::move(decoded.mResult);
+}
+
+converter::SchemaStreamReader::SchemaStreamReader(
+    std::shared_ptr<arrow::io::InputStream> input,
+    const StreamReaderOptions& options)
+    : mImpl{ std::make_unique<Impl>(std::move(input), options) } {}
+
+converter::SchemaStreamReader::~SchemaStreamReader() = default;
+
+arrow::Result<std::unique_ptr<converter::SchemaStreamReader>>
+converter::SchemaStreamReader::Open(const std::string& path,
+                                    const StreamReaderOptions& options) {
+    auto file = arrow::io::ReadableFile::Open(path);
+    if (!file.ok()) {
+        return file.status();
+    }
+    return std::make_unique<SchemaStreamReader>(std::move(file).ValueOrDie(),
+                                                options);
+}
+
+arrow::Result<std::shared_ptr<arrow::Schema>>
+converter::SchemaStreamReader::Next() {
+    return mImpl->Next();
+}
+
+int64_t converter::SchemaStreamReader::LineNumber() const {
+    return mImpl->mLineNumber;
+}
@@ -0,0 +1,130 @@
+#include "Schema_JSON_TypeInterner.h"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Number of entries a shard may hold before its expired entries are swept
+ */
+static constexpr size_t kMinSweepSize = 64;
+
+/**
+ * @brief Hash of a type, consistent with DataType::Equals: equal types have
+ * equal fingerprints. Types without a fingerprint (e.g. extension types) are
+ * hashed by their description
+ */
+static size_t hashOf(const arrow::DataType& type) {
+    const auto& fingerprint = type.fingerprint();
+    if (!fingerprint.empty()) {
+        return std::hash<std::string>{}(fingerprint);
+    }
+    return std::hash<std::string>{}(type.ToString());
+}
+
+/**
+ * Shard of the interning table
+ *
+ * mMutex: lock of the shard
+ * mEntries: interned types by hash, expired ones are dropped lazily
+ * mSweepAt: size at which expired entries are swept before inserting
+ * mHits: lookups answered by an interned type
+ * mMisses: lookups that interned their type
+ */
+struct InternShard {
+    mutable std::mutex mMutex{};
+    std::unordered_multimap<size_t, std::weak_ptr<arrow::DataType>>
+        mEntries{};
+    size_t mSweepAt{ kMinSweepSize };
+    uint64_t mHits{};
+    uint64_t mMisses{};
+
+    /**
+     * @brief Drop the entries of reclaimed types, the mutex being held
+     * @return Number of entries dropped
+     */
+    size_t sweep() {
+        size_t dropped = 0;
+        for (auto entry = mEntries.begin(); entry != mEntries.end();) {
+            if (entry->second.expired()) {
+                entry = mEntries.erase(entry);
+                dropped++;
+            } else {
+                ++entry;
+            }
+        }
+        return dropped;
+    }
+};
+
+class converter::TypeInterner::Impl {
+public:
+    explicit Impl(size_t numShards)
+        : mShards(numShards == 0 ? 1 : numShards) {};
+
+    InternShard& shardOf(size_t hash) { return mShards[hash % mShards.size()]; }
+
+    std::vector<InternShard> mShards;
+};
+
+converter::TypeInterner::TypeInterner(size_t numShards)
+    : mImpl{ std::make_unique<Impl>(numShards) } {}
+
+converter::TypeInterner::~TypeInterner() = default;
+
+std::shared_ptr<arrow::DataType> converter::TypeInterner::Intern(
+    const std::shared_ptr<arrow::DataType>& type) {
+    if (type == nullptr) {
+        return type;
+    }
+
+    // fingerprinting walks the children, do it outside the lock
+    auto hash = hashOf(*type);
+    auto& shard = mImpl->shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+
+    auto range = shard.mEntries.equal_range(hash);
+    for (auto entry = range.first; entry != range.second;) {
+        auto candidate = entry->second.lock();
+        if (candidate == nullptr) {
+            entry = shard.mEntries.erase(entry);
+            continue;
+        }
+        if (candidate == type || candidate->Equals(*type, true)) {
+            shard.mHits++;
+            return candidate;
+        }
+        ++entry;
+    }
+
+    shard.mMisses++;
+    if (shard.mEntries.size() >= shard.mSweepAt) {
+        shard.sweep();
+        shard.mSweepAt = std::max(kMinSweepSize, 2 * shard.mEntries.size());
+    }
+    shard.mEntries.emplace(hash, type);
+    return type;
+}
+
+size_t converter::TypeInterner::Purge() {
+    size_t dropped = 0;
+    for (auto& shard : mImpl->mShards) {
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        dropped += shard.sweep();
+    }
+    return dropped;
+}
+
+converter::InternerStats converter::TypeInterner::Stats() const {
+    InternerStats result{};
+    for (const auto& shard : mImpl->mShards) {
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        result.hits += shard.mHits;
+        result.misses += shard.mMisses;
+        result.size += shard.mEntries.size();
+    }
+    return result;
+}
@@ -1,25 +1,235 @@
 #include "Schema_JSON_Conversion.h"
+#include "Schema_JSON_Allocator.h"
+#include "Schema_JSON_Converter.h"
 #include <arrow/extension_type.h>
+#include <arrow/io/file.h>
 #include "DataTypes.h"
+#include "BinaryWriter.h"
+#include "JSONWriter.h"
+#include "Parallel.h"
 #include <arrow/util/key_value_metadata.h>
 
+#include <array>
+#include <optional>
+
 using json = nlohmann::json;
 
 /**
- * @brief Helper function converts an arrow::Field into json
- * @param[in] schema Input field object
+ * TypeFragment is the type object of a parameter-free arrow type, built once
+ * and shared by every field of that type
+ *
+ * mJson: DOM form, copied into the field's json
+ * mText: serialized form, appended to the JSONWriter as is
+ * mCBOR: CBOR form, appended to the CBORWriter as is
+ * mMsgPack: MessagePack form, appended to the MsgPackWriter as is
+ */
+struct TypeFragment {
+    json mJson{};
+    std::string mText{};
+    std::vector<uint8_t> mCBOR{};
+    std::vector<uint8_t> mMsgPack{};
+};
+
+/**
+ * @brief Encoded form of a fragment matching the writer's output format
+ */
+static const std::string& fragmentOf(const TypeFragment& fragment,
+                                     const JSONWriter&) {
+    return fragment.mText;
+}
+
+static const std::vector<uint8_t>& fragmentOf(const TypeFragment& fragment,
+                                              const CBORWriter&) {
+    return fragment.mCBOR;
+}
+
+static const std::vector<uint8_t>& fragmentOf(const TypeFragment& fragment,
+                                              const MsgPackWriter&) {
+    return fragment.mMsgPack;
+}
+
+/**
+ * @brief Look up the pre-built type object of a parameter-free arrow type
+ * @param[in] id Arrow type id
+ * @return Pointer to the shared fragment, nullptr if the type has parameters
+ * (or is not supported)
+ */
+static const TypeFragment* findTypeFragment(arrow::Type::type id);
+
+/**
+ * MapRole tells whether a field sits below the key or the item of a map. A
+ * failure anywhere below a map is reported as a failure of its key or value,
+ * the outermost map deciding
+ */
+enum MapRole {
+    MAP_ROLE_NONE,
+    MAP_ROLE_KEY,
+    MAP_ROLE_ITEM,
+};
+
+/**
+ * MarshalFrame is a field waiting to be converted by the iterative DOM
+ * traversal
+ *
+ * mField: field to convert
+ * mOut: json slot receiving the converted field
+ * mRole: map role inherited from the outermost map ancestor
+ */
+template <typename JSON>
+struct MarshalFrame {
+    const arrow::Field* mField{};
+    JSON* mOut{};
+    MapRole mRole{};
+};
+
+/**
+ * WriteFrame is a field whose JSON object is open in the iterative text
+ * traversal, waiting for its children to be written
+ *
+ * mField: field being written
+ * mType: storage type of the field
+ * mExtType: extension type of the field, nullptr if none
+ * mFragment: shared type object, nullptr if mTypeJSON is used
+ * mTypeJSON: type descriptor, empty if mFragment is used
+ * mHasChildren: whether a "children" array has been opened
+ * mNextChild: index of the next child to write
+ * mNumChildren: number of children to write through the work stack
+ * mRole: map role inherited from the outermost map ancestor
+ */
+struct WriteFrame {
+    const arrow::Field* mField{};
+    const arrow::DataType* mType{};
+    const arrow::ExtensionType* mExtType{};
+    const TypeFragment* mFragment{};
+    std::optional<TypeJSON> mTypeJSON{};
+    bool mHasChildren{};
+    int mNextChild{};
+    int mNumChildren{};
+    MapRole mRole{};
+};
+
+/**
+ * @brief Helper function converts an arrow::Field into json. Nested fields are
+ * walked with an explicit work stack instead of recursion, so the nesting
+ * depth does not grow the call stack
+ * @param[in] field Input field object
+ * @param[in] parallel Conversion options allowing parallel marshalling of
+ * wide structs, nullptr to stay on the calling thread
+ * @param[in] stack Work stack, reused across calls
  * @return arrow::Result contains the converted json if successful, descriptive
  * status otherwise
  */
-static arrow::Result<json> marshalJSON(
-    const std::shared_ptr<arrow::Field>& field);
+template <typename JSON>
+static arrow::Result<JSON> marshalJSON(
+    const arrow::Field& field,
+    const converter::SchemaToJSONOptions* parallel,
+    std::vector<MarshalFrame<JSON>>& stack);
 
-arrow::Result<json> converter::SchemaToJSON(
-    const std::shared_ptr<arrow::Schema>& schema) {
-    json result;
+/**
+ * @brief Helper function converts a list of fields into a json array, in
+ * parallel if the list is wide enough
+ * @param[in] fields Input fields
+ * @param[in] parallel Conversion options, nullptr to stay on the calling
+ * thread
+ * @param[in] stack Work stack of the serial conversion, reused across calls
+ * @return arrow::Result contains the json array if successful, descriptive
+ * status otherwise
+ */
+template <typename JSON>
+static arrow::Result<JSON> marshalFields(
+    const arrow::FieldVector& fields,
+    const converter::SchemaToJSONOptions* parallel,
+    std::vector<MarshalFrame<JSON>>& stack);
 
-    if (schema->HasMetadata()) {
-        auto metadata = schema->metadata();
+/**
+ * @brief Helper function writes an arrow::Field through a writer (JSONWriter
+ * or BinaryWriter), producing the same bytes as dump()/to_cbor()/to_msgpack()
+ * of marshalJSON(field). Nested fields are walked with an explicit work stack
+ * instead of recursion
+ * @param[in] field Input field object
+ * @param[in] writer Output writer
+ * @param[in] parallel Conversion options allowing parallel marshalling of
+ * wide structs, nullptr to stay on the calling thread
+ * @param[in] stack Work stack, reused across calls
+ * @return arrow::Status OK if successful, descriptive status otherwise
+ */
+template <typename Writer>
+static arrow::Status writeJSON(const arrow::Field& field,
+                               Writer& writer,
+                               const converter::SchemaToJSONOptions* parallel,
+                               std::vector<WriteFrame>& stack);
+
+/**
+ * @brief Helper function writes a list of fields as values of the currently
+ * open array, in parallel if the list is wide enough. Fields are always
+ * written in order
+ * @param[in] fields Input fields
+ * @param[in] writer Output writer
+ * @param[in] parallel Conversion options, nullptr to stay on the calling
+ * thread
+ * @param[in] stack Work stack of the serial conversion, reused across calls
+ * @return arrow::Status OK if successful, descriptive status otherwise
+ */
+template <typename Writer>
+static arrow::Status writeFields(
+    const arrow::FieldVector& fields,
+    Writer& writer,
+    const converter::SchemaToJSONOptions* parallel,
+    std::vector<WriteFrame>& stack);
+
+/**
+ * @brief Whether a list of `width` fields should be split across threads
+ */
+static bool runInParallel(const converter::SchemaToJSONOptions* parallel,
+                          size_t width) {
+    return parallel != nullptr && parallel->useThreads &&
+           width >= static_cast<size_t>(parallel->parallelThreshold);
+}
+
+/**
+ * @brief Report a failure the way the enclosing map (if any) does
+ */
+static arrow::Status mapRoleError(MapRole role, const arrow::Status& status) {
+    switch (role) {
+        case MAP_ROLE_KEY:
+            return arrow::Status::TypeError("failed to parse key");
+        case MAP_ROLE_ITEM:
+            return arrow::Status::TypeError("failed to parse value");
+        default:
+            return status;
+    }
+}
+
+/**
+ * @brief Role of a child: the ancestor's role wins over the child's own
+ */
+static MapRole childRole(MapRole parentRole, MapRole role) {
+    return parentRole != MAP_ROLE_NONE ? parentRole : role;
+}
+
+/**
+ * @brief Helper function builds the type descriptor of a (non-extension)
+ * arrow::DataType. Children of nested types are not handled here
+ * @param[in] fieldType Input data type
+ * @return arrow::Result contains the type descriptor if successful,
+ * descriptive status otherwise
+ */
+static arrow::Result<TypeJSON> makeTypeJSON(const arrow::DataType& fieldType);
+
+/**
+ * @brief Helper function builds the json of a schema around its already
+ * converted fields
+ * @param[in] schema Input schema
+ * @param[in] fields Json array of the converted fields, ignored if the schema
+ * has none
+ * @return The schema's json
+ */
+template <typename JSON>
+static JSON makeSchemaJSON(const arrow::Schema& schema, JSON fields) {
+    JSON result;
+
+    if (schema.HasMetadata()) {
+        auto metadata = schema.metadata();
         for (int i = 0; i < metadata->size(); i++) {
             result["schema"]["metadata"].push_back({
                 { "key", metadata->key(i) },
@@ -28,28 +238,363 @@ arrow::Result<json> converter::SchemaToJSON(
         }
     }
 
-    for (int i = 0; i < schema->num_fields(); i++) {
-        auto j_field = marshalJSON(schema->field(i));
-        if (!j_field.ok()) {
-            return j_field.status();
+    if (schema.num_fields() > 0) {
+        result["schema"]["fields"] = std::move(fields);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Helper function converts arrow::Schema into json of the given
+ * nlohmann::basic_json instantiation
+ */
+template <typename JSON>
+static arrow::Result<JSON> marshalSchema(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const converter::SchemaToJSONOptions& options,
+    std::vector<MarshalFrame<JSON>>& stack) {
+    JSON fields{};
+
+    if (schema->num_fields() > 0) {
+        auto j_fields = marshalFields(schema->fields(), &options, stack);
+        if (!j_fields.ok()) {
+            return j_fields.status();
+        }
+        fields = std::move(j_fields).ValueOrDie();
+    }
+
+    return makeSchemaJSON(*schema, std::move(fields));
+}
+
+arrow::Result<json> converter::SchemaToJSON(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options) {
+    std::vector<MarshalFrame<json>> stack{};
+    return marshalSchema(schema, options, stack);
+}
+
+std::vector<arrow::Result<json>> converter::SchemaToJSONBatch(
+    const std::vector<std::shared_ptr<arrow::Schema>>& schemas,
+    const BatchOptions& options) {
+    int fieldsPerTask = std::max(1, options.fieldsPerTask);
+
+    // Every schema is split into field ranges, so a huge schema is spread
+    // over all workers instead of holding up the batch
+    std::vector<json> fieldArrays(schemas.size());
+    std::vector<BatchTask> tasks{};
+    for (size_t item = 0; item < schemas.size(); item++) {
+        if (schemas[item] == nullptr) {
+            continue;
+        }
+        int numFields = schemas[item]->num_fields();
+        fieldArrays[item] = json::array();
+        fieldArrays[item].get_ref<json::array_t&>().resize(numFields);
+        for (int begin = 0; begin < numFields; begin += fieldsPerTask) {
+            tasks.push_back(
+                { item, begin, std::min(numFields, begin + fieldsPerTask) });
+        }
+    }
+
+    auto status = ParallelForDynamic(
+        static_cast<int>(tasks.size()), options.executor, [&](int index) {
+            auto& task = tasks[index];
+            const auto& fields = schemas[task.mItem]->fields();
+            auto& items = fieldArrays[task.mItem].get_ref<json::array_t&>();
+            std::vector<MarshalFrame<json>> stack{};
+            for (int i = task.mBegin; i < task.mEnd; i++) {
+                auto j_field = marshalJSON(*fields[i], nullptr, stack);
+                if (!j_field.ok()) {
+                    task.mStatus = j_field.status();
+                    return;
+                }
+                items[i] = std::move(j_field).ValueOrDie();
+            }
+        });
+
+    std::vector<arrow::Result<json>> results{};
+    results.reserve(schemas.size());
+    size_t nextTask = 0;
+    for (size_t item = 0; item < schemas.size(); item++) {
+        // the first failing range of the schema, in field order
+        arrow::Status itemStatus = status;
+        for (; nextTask < tasks.size() && tasks[nextTask].mItem == item;
+             nextTask++) {
+            if (itemStatus.ok()) {
+                itemStatus = tasks[nextTask].mStatus;
+            }
+        }
+
+        if (schemas[item] == nullptr) {
+            results.emplace_back(arrow::Status::Invalid("null schema"));
+        } else if (!itemStatus.ok()) {
+            results.emplace_back(itemStatus);
+        } else {
+            results.emplace_back(makeSchemaJSON(
+                *schemas[item], std::move(fieldArrays[item])));
+        }
+    }
+    return results;
+}
+
+arrow::Result<converter::PoolJSON> converter::SchemaToPoolJSON(
+    const std::shared_ptr<arrow::Schema>& schema,
+    arrow::MemoryPool* pool,
+    const SchemaToJSONOptions& options) {
+    MemoryPoolScope scope{ pool != nullptr ? pool
+                                           : arrow::default_memory_pool() };
+    std::vector<MarshalFrame<PoolJSON>> stack{};
+    return marshalSchema(schema, options, stack);
+}
+
+/**
+ * @brief Write the whole schema into the writer, keys in the same order as
+ * nlohmann::json stores them
+ */
+template <typename Writer>
+static arrow::Status writeSchemaJSON(
+    const std::shared_ptr<arrow::Schema>& schema,
+    Writer& writer,
+    const converter::SchemaToJSONOptions& options,
+    std::vector<WriteFrame>& stack) {
+    auto metadata = schema->metadata();
+    bool hasMetadata = metadata != nullptr && metadata->size() > 0;
+
+    // SchemaToJSON leaves the result untouched for an empty schema
+    if (schema->num_fields() == 0 && !hasMetadata) {
+        writer.Null();
+        return writer.Finish();
+    }
+
+    writer.StartObject(1);
+    writer.Key("schema");
+    writer.StartObject((schema->num_fields() > 0) + hasMetadata);
+
+    if (schema->num_fields() > 0) {
+        writer.Key("fields");
+        writer.StartArray(schema->num_fields());
+        auto status = writeFields(schema->fields(), writer, &options, stack);
+        if (!status.ok()) {
+            return status;
+        }
+        writer.EndArray();
+    }
+
+    if (hasMetadata) {
+        writer.Key("metadata");
+        writer.StartArray(metadata->size());
+        for (int i = 0; i < metadata->size(); i++) {
+            writer.StartObject(2);
+            writer.Key("key");
+            writer.String(metadata->key(i));
+            writer.Key("value");
+            writer.String(metadata->value(i));
+            writer.EndObject();
+        }
+        writer.EndArray();
+    }
+
+    writer.EndObject();
+    writer.EndObject();
+    return writer.Finish();
+}
+
+arrow::Result<std::string> converter::SchemaToJSONString(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options) {
+    std::string result{};
+    JSONWriter writer{ &result };
+
+    std::vector<WriteFrame> stack{};
+    auto status = writeSchemaJSON(schema, writer, options, stack);
+    if (!status.ok()) {
+        return status;
+    }
+    return result;
+}
+
+arrow::Status converter::SchemaToJSONStream(
+    const std::shared_ptr<arrow::Schema>& schema,
+    arrow::io::OutputStream* sink,
+    const SchemaToJSONOptions& options) {
+    std::string buffer{};
+    buffer.reserve(JSONWriter::kFlushThreshold);
+    JSONWriter writer{ &buffer, sink };
+
+    std::vector<WriteFrame> stack{};
+    return writeSchemaJSON(schema, writer, options, stack);
+}
+
+arrow::Status converter::SchemaToJSONFile(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const std::string& path,
+    const SchemaToJSONOptions& options) {
+    auto file = arrow::io::FileOutputStream::Open(path);
+    if (!file.ok()) {
+        return file.status();
+    }
+    auto sink = std::move(file).ValueOrDie();
+    auto status = SchemaToJSONStream(schema, sink.get(), options);
+    auto closed = sink->Close();
+    if (!status.ok()) {
+        return status;
+    }
+    return closed;
+}
+
+arrow::Result<std::vector<uint8_t>> converter::SchemaToCBOR(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options) {
+    std::vector<uint8_t> result{};
+    CBORWriter writer{ &result };
+
+    std::vector<WriteFrame> stack{};
+    auto status = writeSchemaJSON(schema, writer, options, stack);
+    if (!status.ok()) {
+        return status;
+    }
+    return result;
+}
+
+arrow::Result<std::vector<uint8_t>> converter::SchemaToMsgPack(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const SchemaToJSONOptions& options) {
+    std::vector<uint8_t> result{};
+    MsgPackWriter writer{ &result };
+
+    std::vector<WriteFrame> stack{};
+    auto status = writeSchemaJSON(schema, writer, options, stack);
+    if (!status.ok()) {
+        return status;
+    }
+    return result;
+}
+
+/**
+ * Scratch storage of the encoding direction of a Converter
+ *
+ * mMarshalStack: work stack of SchemaToJSON
+ * mWriteStack: work stack of the writers
+ * mText: output buffer of SchemaToJSONString and SchemaToJSONStream
+ */
+struct converter::Converter::EncodeState {
+    std::vector<MarshalFrame<json>> mMarshalStack{};
+    std::vector<WriteFrame> mWriteStack{};
+    std::string mText{};
+};
+
+void converter::Converter::EncodeStateDeleter::operator()(
+    EncodeState* state) const {
+    delete state;
+}
+
+converter::Converter::Converter(const SchemaToJSONOptions& options,
+                                const JSONToSchemaOptions& decodeOptions)
+    : mOptions{ options }
+    , mDecodeOptions{ decodeOptions } {}
+
+converter::Converter::~Converter() = default;
+
+converter::Converter::EncodeState& converter::Converter::encodeState() {
+    if (mEncode == nullptr) {
+        mEncode.reset(new EncodeState{});
+    }
+    return *mEncode;
+}
+
+arrow::Result<json> converter::Converter::SchemaToJSON(
+    const std::shared_ptr<arrow::Schema>& schema) {
+    return marshalSchema(schema, mOptions, encodeState().mMarshalStack);
+}
+
+arrow::Result<std::string_view> converter::Converter::SchemaToJSONString(
+    const std::shared_ptr<arrow::Schema>& schema) {
+    auto& state = encodeState();
+    state.mText.clear();
+    JSONWriter writer{ &state.mText };
+
+    auto status = writeSchemaJSON(schema, writer, mOptions, state.mWriteStack);
+    if (!status.ok()) {
+        return status;
+    }
+    return std::string_view{ state.mText };
+}
+
+arrow::Status converter::Converter::SchemaToJSONStream(
+    const std::shared_ptr<arrow::Schema>& schema,
+    arrow::io::OutputStream* sink) {
+    auto& state = encodeState();
+    state.mText.clear();
+    state.mText.reserve(JSONWriter::kFlushThreshold);
+    JSONWriter writer{ &state.mText, sink };
+
+    return writeSchemaJSON(schema, writer, mOptions, state.mWriteStack);
+}
+
+template <typename JSON>
+static arrow::Result<JSON> marshalFields(
+    const arrow::FieldVector& fields,
+    const converter::SchemaToJSONOptions* parallel,
+    std::vector<MarshalFrame<JSON>>& stack) {
+    JSON result = JSON::array();
+    auto& items = result.template get_ref<typename JSON::array_t&>();
+
+    if (!runInParallel(parallel, fields.size())) {
+        items.reserve(fields.size());
+        for (const auto& field : fields) {
+            auto j_field = marshalJSON(*field, parallel, stack);
+            if (!j_field.ok()) {
+                return j_field.status();
+            }
+            items.push_back(std::move(j_field).ValueOrDie());
         }
-        result["schema"]["fields"].push_back(std::move(j_field).ValueOrDie());
+        return result;
     }
 
+    // Each range fills its own slots, so the array keeps the field order.
+    // Nested fields are marshalled serially inside the tasks, allocating from
+    // the caller's memory pool
+    items.resize(fields.size());
+    auto pool = converter::CurrentMemoryPool();
+    auto status = ParallelForRanges(
+        static_cast<int>(fields.size()),
+        parallel->executor,
+        [&](int, int begin, int end) {
+            converter::MemoryPoolScope scope{ pool };
+            std::vector<MarshalFrame<JSON>> stack{};
+            for (int i = begin; i < end; i++) {
+                auto j_field = marshalJSON(*fields[i], nullptr, stack);
+                if (!j_field.ok()) {
+                    return j_field.status();
+                }
+                items[i] = std::move(j_field).ValueOrDie();
+            }
+            return arrow::Status::OK();
+        });
+    if (!status.ok()) {
+        return status;
+    }
     return result;
 }
 
-static arrow::Result<json> marshalJSON(
-    const std::shared_ptr<arrow::Field>& field) {
-    json result{};
-    std::shared_ptr<IDataType> type;
-    auto fieldType = field->type();
+/**
+ * @brief Convert the field of one work item into its json slot, pushing its
+ * children as new work items
+ */
+template <typename JSON>
+static arrow::Status marshalFrame(
+    const MarshalFrame<JSON>& frame,
+    const converter::SchemaToJSONOptions* parallel,
+    std::vector<MarshalFrame<JSON>>& stack) {
+    JSON& result = *frame.mOut;
+    const auto& field = *frame.mField;
+    const arrow::DataType* fieldType = field.type().get();
 
-    result["nullable"] = field->nullable();
+    result["nullable"] = field.nullable();
 
     // Handle field's metadata
-    if (field->HasMetadata()) {
-        auto metadata = field->metadata();
+    if (field.HasMetadata()) {
+        auto metadata = field.metadata();
         for (int i = 0; i < metadata->size(); i++) {
             result["metadata"].push_back({
                 { "key", metadata->key(i) },
@@ -60,8 +605,7 @@ static arrow::Result<json> marshalJSON(
 
     // Handle user-defined type
     if (fieldType->id() == arrow::Type::EXTENSION) {
-        auto extType =
-            static_cast<const arrow::ExtensionType*>(fieldType.get());
+        auto extType = static_cast<const arrow::ExtensionType*>(fieldType);
         result["metadata"].push_back(
             { { "key", EXTENSION_TYPE_KEY_NAME },
               { "value", extType->extension_name() } });
@@ -72,265 +616,547 @@ static arrow::Result<json> marshalJSON(
                 { { "key", EXTENSION_METADATA_KEY_NAME },
                   { "value", serializedData } });
         }
-        fieldType = extType->storage_type();
+        fieldType = extType->storage_type().get();
+    }
+
+    auto fragment = findTypeFragment(fieldType->id());
+    if (fragment != nullptr) {
+        result["name"] = field.name();
+        result["type"] = fragment->mJson;
+        return arrow::Status::OK();
+    }
+
+    auto type = makeTypeJSON(*fieldType);
+    if (!type.ok()) {
+        return type.status();
     }
 
     switch (fieldType->id()) {
-        case arrow::Type::NA:
-            type = std::make_shared<NameJSON>(datatype::kNullType);
+        case arrow::Type::LIST:
+        case arrow::Type::STRUCT: {
+            int numChildren = fieldType->num_fields();
+            if (numChildren == 0) {
+                break;
+            }
+            if (runInParallel(parallel, numChildren)) {
+                // the tasks bring their own stacks, this one is in use
+                std::vector<MarshalFrame<JSON>> unused{};
+                auto children =
+                    marshalFields(fieldType->fields(), parallel, unused);
+                if (!children.ok()) {
+                    return children.status();
+                }
+                result["children"] = std::move(children).ValueOrDie();
+                break;
+            }
+
+            // The slots are allocated up front, so pointers to them stay
+            // valid. Children are pushed in reverse to be converted in order
+            auto& children = result["children"];
+            children = JSON::array();
+            auto& items = children.template get_ref<typename JSON::array_t&>();
+            items.resize(numChildren);
+            for (int i = numChildren - 1; i >= 0; i--) {
+                stack.push_back({ fieldType->field(i).get(),
+                                  &items[i],
+                                  childRole(frame.mRole, MAP_ROLE_NONE) });
+            }
             break;
-        case arrow::Type::BOOL:
-            type = std::make_shared<NameJSON>(datatype::kBoolType);
+        }
+        case arrow::Type::MAP: {
+            auto mapType = static_cast<const arrow::MapType*>(fieldType);
+            auto& children = result["children"];
+            children = JSON::array({ JSON::object() });
+            auto& entry = children[0];
+            stack.push_back({ mapType->item_field().get(),
+                              &entry["item"],
+                              childRole(frame.mRole, MAP_ROLE_ITEM) });
+            stack.push_back({ mapType->key_field().get(),
+                              &entry["key"],
+                              childRole(frame.mRole, MAP_ROLE_KEY) });
             break;
-        case arrow::Type::UINT8:
-            type = std::make_shared<BitWidthJSON>(datatype::kIntType, false, 8);
+        }
+        default:
             break;
-        case arrow::Type::INT8:
-            type = std::make_shared<BitWidthJSON>(datatype::kIntType, true, 8);
+    }
+
+    result["name"] = field.name();
+    result["type"] = MarshalJSON<JSON>(type.ValueOrDie());
+    return arrow::Status::OK();
+}
+
+template <typename JSON>
+static arrow::Result<JSON> marshalJSON(
+    const arrow::Field& field,
+    const converter::SchemaToJSONOptions* parallel,
+    std::vector<MarshalFrame<JSON>>& stack) {
+    JSON result{};
+
+    stack.clear();
+    stack.push_back({ &field, &result, MAP_ROLE_NONE });
+    while (!stack.empty()) {
+        auto frame = stack.back();
+        stack.pop_back();
+
+        auto status = marshalFrame(frame, parallel, stack);
+        if (!status.ok()) {
+            return mapRoleError(frame.mRole, status);
+        }
+    }
+    return result;
+}
+
+template <typename Writer>
+static void writeKeyValue(Writer& writer,
+                          const std::string& key,
+                          const std::string& value) {
+    writer.StartObject(2);
+    writer.Key("key");
+    writer.String(key);
+    writer.Key("value");
+    writer.String(value);
+    writer.EndObject();
+}
+
+template <typename Writer>
+static arrow::Status writeFields(
+    const arrow::FieldVector& fields,
+    Writer& writer,
+    const converter::SchemaToJSONOptions* parallel,
+    std::vector<WriteFrame>& stack) {
+    if (!runInParallel(parallel, fields.size())) {
+        for (const auto& field : fields) {
+            auto status = writeJSON(*field, writer, parallel, stack);
+            if (!status.ok()) {
+                return status;
+            }
+        }
+        return arrow::Status::OK();
+    }
+
+    // Each range writes a run of fields into its own buffer, the runs are
+    // then appended in order
+    auto numFields = static_cast<int>(fields.size());
+    std::vector<typename Writer::Buffer> runs(
+        ParallelRangeCount(numFields, parallel->executor));
+    auto status = ParallelForRanges(
+        numFields, parallel->executor, [&](int range, int begin, int end) {
+            std::vector<WriteFrame> stack{};
+            Writer runWriter{ &runs[range] };
+            for (int i = begin; i < end; i++) {
+                auto status = writeJSON(*fields[i], runWriter, nullptr, stack);
+                if (!status.ok()) {
+                    return status;
+                }
+            }
+            return runWriter.status();
+        });
+    if (!status.ok()) {
+        return status;
+    }
+
+    for (const auto& run : runs) {
+        writer.RawValue(run);
+    }
+    return writer.status();
+}
+
+/**
+ * @brief Open the JSON object of a field: write everything that comes before
+ * its children (keys are in lexicographical order: children, metadata, name,
+ * nullable, type) and push it on the work stack
+ */
+template <typename Writer>
+static arrow::Status openField(const arrow::Field& field,
+                               MapRole role,
+                               Writer& writer,
+                               const converter::SchemaToJSONOptions* parallel,
+                               std::vector<WriteFrame>& stack) {
+    WriteFrame frame{};
+    frame.mField = &field;
+    frame.mType = field.type().get();
+    frame.mRole = role;
+
+    if (frame.mType->id() == arrow::Type::EXTENSION) {
+        frame.mExtType =
+            static_cast<const arrow::ExtensionType*>(frame.mType);
+        frame.mType = frame.mExtType->storage_type().get();
+    }
+
+    frame.mFragment = findTypeFragment(frame.mType->id());
+    if (frame.mFragment == nullptr) {
+        auto type = makeTypeJSON(*frame.mType);
+        if (!type.ok()) {
+            return type.status();
+        }
+        frame.mTypeJSON = std::move(type).ValueOrDie();
+    }
+
+    auto typeId = frame.mType->id();
+    bool hasChildren = typeId == arrow::Type::MAP ||
+                       ((typeId == arrow::Type::LIST ||
+                         typeId == arrow::Type::STRUCT) &&
+                        frame.mType->num_fields() > 0);
+    bool hasMetadata = field.HasMetadata() || frame.mExtType != nullptr;
+    writer.StartObject(3 + hasChildren + hasMetadata);
+
+    switch (typeId) {
+        case arrow::Type::LIST:
+        case arrow::Type::STRUCT: {
+            int numChildren = frame.mType->num_fields();
+            if (numChildren == 0) {
+                break;
+            }
+            writer.Key("children");
+            writer.StartArray(numChildren);
+            frame.mHasChildren = true;
+            if (runInParallel(parallel, numChildren)) {
+                // the tasks bring their own stacks, this one is in use
+                std::vector<WriteFrame> unused{};
+                auto status = writeFields(
+                    frame.mType->fields(), writer, parallel, unused);
+                if (!status.ok()) {
+                    return status;
+                }
+                break;
+            }
+            frame.mNumChildren = numChildren;
             break;
-        case arrow::Type::UINT16:
-            type =
-                std::make_shared<BitWidthJSON>(datatype::kIntType, false, 16);
+        }
+        case arrow::Type::MAP: {
+            // item comes before key in lexicographical order
+            writer.Key("children");
+            writer.StartArray(1);
+            writer.StartObject(2);
+            writer.Key("item");
+            frame.mHasChildren = true;
+            frame.mNumChildren = 2;
             break;
-        case arrow::Type::INT16:
-            type = std::make_shared<BitWidthJSON>(datatype::kIntType, true, 16);
+        }
+        default:
             break;
+    }
+
+    stack.push_back(std::move(frame));
+    return arrow::Status::OK();
+}
+
+/**
+ * @brief Close the JSON object of a field once its children are written
+ */
+template <typename Writer>
+static void closeField(const WriteFrame& frame, Writer& writer) {
+    if (frame.mType->id() == arrow::Type::MAP) {
+        writer.EndObject();
+    }
+    if (frame.mHasChildren) {
+        writer.EndArray();
+    }
+
+    const auto& field = *frame.mField;
+    auto metadata = field.metadata();
+    bool hasMetadata = metadata != nullptr && metadata->size() > 0;
+    if (hasMetadata || frame.mExtType != nullptr) {
+        std::string serializedData{};
+        size_t numItems = hasMetadata ? metadata->size() : 0;
+        if (frame.mExtType != nullptr) {
+            serializedData = frame.mExtType->Serialize();
+            numItems += serializedData.empty() ? 1 : 2;
+        }
+
+        writer.Key("metadata");
+        writer.StartArray(numItems);
+        for (int i = 0; hasMetadata && i < metadata->size(); i++) {
+            writeKeyValue(writer, metadata->key(i), metadata->value(i));
+        }
+        if (frame.mExtType != nullptr) {
+            writeKeyValue(writer,
+                          EXTENSION_TYPE_KEY_NAME,
+                          frame.mExtType->extension_name());
+            if (serializedData.size() > 0) {
+                writeKeyValue(
+                    writer, EXTENSION_METADATA_KEY_NAME, serializedData);
+            }
+        }
+        writer.EndArray();
+    }
+
+    writer.Key("name");
+    writer.String(field.name());
+    writer.Key("nullable");
+    writer.Bool(field.nullable());
+    writer.Key("type");
+    if (frame.mFragment != nullptr) {
+        writer.RawValue(fragmentOf(*frame.mFragment, writer));
+    } else {
+        WriteJSON(*frame.mTypeJSON, writer);
+    }
+    writer.EndObject();
+}
+
+template <typename Writer>
+static arrow::Status writeJSON(const arrow::Field& field,
+                               Writer& writer,
+                               const converter::SchemaToJSONOptions* parallel,
+                               std::vector<WriteFrame>& stack) {
+    stack.clear();
+    auto status = openField(field, MAP_ROLE_NONE, writer, parallel, stack);
+    if (!status.ok()) {
+        return status;
+    }
+
+    while (!stack.empty()) {
+        auto& frame = stack.back();
+        if (frame.mNextChild == frame.mNumChildren) {
+            closeField(frame, writer);
+            stack.pop_back();
+            continue;
+        }
+
+        int index = frame.mNextChild++;
+        const arrow::Field* child = nullptr;
+        MapRole role = MAP_ROLE_NONE;
+        if (frame.mType->id() == arrow::Type::MAP) {
+            auto mapType = static_cast<const arrow::MapType*>(frame.mType);
+            if (index == 0) {
+                child = mapType->item_field().get();
+                role = MAP_ROLE_ITEM;
+            } else {
+                writer.Key("key");
+                child = mapType->key_field().get();
+                role = MAP_ROLE_KEY;
+            }
+        } else {
+            child = frame.mType->field(index).get();
+        }
+        role = childRole(frame.mRole, role);
+
+        // frame may be invalidated from here on, the stack can reallocate
+        status = openField(*child, role, writer, parallel, stack);
+        if (!status.ok()) {
+            return mapRoleError(role, status);
+        }
+    }
+    return writer.status();
+}
+
+static arrow::Result<TypeJSON> makeTypeJSON(const arrow::DataType& fieldType) {
+    switch (fieldType.id()) {
+        case arrow::Type::NA:
+            return NameJSON(datatype::kNullType);
+        case arrow::Type::BOOL:
+            return NameJSON(datatype::kBoolType);
+        case arrow::Type::UINT8:
+            return BitWidthJSON(datatype::kIntType, false, 8);
+        case arrow::Type::INT8:
+            return BitWidthJSON(datatype::kIntType, true, 8);
+        case arrow::Type::UINT16:
+            return BitWidthJSON(datatype::kIntType, false, 16);
+        case arrow::Type::INT16:
+            return BitWidthJSON(datatype::kIntType, true, 16);
         case arrow::Type::UINT32:
-            type =
-                std::make_shared<BitWidthJSON>(datatype::kIntType, false, 32);
-            break;
+            return BitWidthJSON(datatype::kIntType, false, 32);
         case arrow::Type::INT32:
-            type = std::make_shared<BitWidthJSON>(datatype::kIntType, true, 32);
-            break;
+            return BitWidthJSON(datatype::kIntType, true, 32);
         case arrow::Type::UINT64:
-            type =
-                std::make_shared<BitWidthJSON>(datatype::kIntType, false, 64);
-            break;
+            return BitWidthJSON(datatype::kIntType, false, 64);
         case arrow::Type::INT64:
-            type = std::make_shared<BitWidthJSON>(datatype::kIntType, true, 64);
-            break;
+            return BitWidthJSON(datatype::kIntType, true, 64);
         case arrow::Type::HALF_FLOAT:
-            type = std::make_shared<FloatJSON>(datatype::kFloatingPointType,
-                                               datatype::kPrecisionHalf);
-            break;
+            return FloatJSON(datatype::kFloatingPointType,
+                             datatype::kPrecisionHalf);
         case arrow::Type::FLOAT:
-            type = std::make_shared<FloatJSON>(datatype::kFloatingPointType,
-                                               datatype::kPrecisionSingle);
-            break;
+            return FloatJSON(datatype::kFloatingPointType,
+                             datatype::kPrecisionSingle);
         case arrow::Type::DOUBLE:
-            type = std::make_shared<FloatJSON>(datatype::kFloatingPointType,
-                                               datatype::kPrecisionDouble);
-            break;
+            return FloatJSON(datatype::kFloatingPointType,
+                             datatype::kPrecisionDouble);
         case arrow::Type::STRING:
-            type = std::make_shared<NameJSON>(datatype::kUtf8Type);
-            break;
+            return NameJSON(datatype::kUtf8Type);
         case arrow::Type::BINARY:
-            type = std::make_shared<NameJSON>(datatype::kBinaryType);
-            break;
+            return NameJSON(datatype::kBinaryType);
         case arrow::Type::FIXED_SIZE_BINARY: {
             auto byte_width =
-                static_cast<const arrow::FixedSizeBinaryType*>(fieldType.get())
-                    ->byte_width();
-            type = std::make_shared<ByteWidthJSON>(
-                datatype::kFixedSizeBinaryType, byte_width);
-            break;
+                static_cast<const arrow::FixedSizeBinaryType&>(fieldType)
+                    .byte_width();
+            return ByteWidthJSON(datatype::kFixedSizeBinaryType, byte_width);
         }
         case arrow::Type::DATE32:
-            type = std::make_shared<UnitZoneJSON>(datatype::kDateType,
-                                                  datatype::kDayUnit);
-            break;
+            return UnitZoneJSON(datatype::kDateType, datatype::kDayUnit);
         case arrow::Type::DATE64:
-            type = std::make_shared<UnitZoneJSON>(datatype::kDateType,
-                                                  datatype::kMillisecondUnit);
-            break;
+            return UnitZoneJSON(datatype::kDateType,
+                                datatype::kMillisecondUnit);
         case arrow::Type::TIMESTAMP: {
             auto unit =
-                static_cast<const arrow::TimestampType*>(fieldType.get())
-                    ->unit();
-            auto timezone =
-                static_cast<const arrow::TimestampType*>(fieldType.get())
-                    ->timezone();
+                static_cast<const arrow::TimestampType&>(fieldType)
+                    .unit();
+            const auto& timezone =
+                static_cast<const arrow::TimestampType&>(fieldType)
+                    .timezone();
 
             switch (unit) {
                 case arrow::TimeUnit::SECOND:
-                    type =
-                        std::make_shared<UnitZoneJSON>(datatype::kTimestampType,
-                                                       datatype::kSecondUnit,
-                                                       timezone);
-                    break;
+                    return UnitZoneJSON(datatype::kTimestampType,
+                                        datatype::kSecondUnit,
+                                        timezone);
                 case arrow::TimeUnit::MILLI:
-                    type = std::make_shared<UnitZoneJSON>(
-                        datatype::kTimestampType,
-                        datatype::kMillisecondUnit,
-                        timezone);
-                    break;
+                    return UnitZoneJSON(datatype::kTimestampType,
+                                        datatype::kMillisecondUnit,
+                                        timezone);
                 case arrow::TimeUnit::MICRO:
-                    type = std::make_shared<UnitZoneJSON>(
-                        datatype::kTimestampType,
-                        datatype::kMicrosecondUnit,
-                        timezone);
-                    break;
+                    return UnitZoneJSON(datatype::kTimestampType,
+                                        datatype::kMicrosecondUnit,
+                                        timezone);
                 case arrow::TimeUnit::NANO:
-                    type = std::make_shared<UnitZoneJSON>(
-                        datatype::kTimestampType,
-                        datatype::kNanosecondUnit,
-                        timezone);
-                    break;
+                    return UnitZoneJSON(datatype::kTimestampType,
+                                        datatype::kNanosecondUnit,
+                                        timezone);
                 default:
                     return arrow::Status::Invalid("unsupported unit");
             }
-            break;
         }
         case arrow::Type::TIME32: {
             auto unit =
-                static_cast<const arrow::Time32Type*>(fieldType.get())->unit();
+                static_cast<const arrow::Time32Type&>(fieldType).unit();
             auto bitWidth =
-                static_cast<const arrow::Time32Type*>(fieldType.get())
-                    ->bit_width();
+                static_cast<const arrow::Time32Type&>(fieldType)
+                    .bit_width();
             switch (unit) {
                 case arrow::TimeUnit::SECOND:
-                    type =
-                        std::make_shared<BitWidthJSON>(datatype::kTimeType,
-                                                       false,
-                                                       bitWidth,
-                                                       datatype::kSecondUnit);
-                    break;
+                    return BitWidthJSON(datatype::kTimeType,
+                                        false,
+                                        bitWidth,
+                                        datatype::kSecondUnit);
                 case arrow::TimeUnit::MILLI:
-                    type = std::make_shared<BitWidthJSON>(
-                        datatype::kTimeType,
-                        false,
-                        bitWidth,
-                        datatype::kMillisecondUnit);
-                    break;
+                    return BitWidthJSON(datatype::kTimeType,
+                                        false,
+                                        bitWidth,
+                                        datatype::kMillisecondUnit);
                 default:
                     return arrow::Status::Invalid("unsupported unit");
             }
-            break;
         }
         case arrow::Type::TIME64: {
             auto unit =
-                static_cast<const arrow::Time32Type*>(fieldType.get())->unit();
+                static_cast<const arrow::Time32Type&>(fieldType).unit();
             auto bitWidth =
-                static_cast<const arrow::Time32Type*>(fieldType.get())
-                    ->bit_width();
+                static_cast<const arrow::Time32Type&>(fieldType)
+                    .bit_width();
             switch (unit) {
                 case arrow::TimeUnit::MICRO:
-                    type = std::make_shared<BitWidthJSON>(
-                        datatype::kTimeType,
-                        false,
-                        bitWidth,
-                        datatype::kMicrosecondUnit);
-                    break;
+                    return BitWidthJSON(datatype::kTimeType,
+                                        false,
+                                        bitWidth,
+                                        datatype::kMicrosecondUnit);
                 case arrow::TimeUnit::NANO:
-                    type = std::make_shared<BitWidthJSON>(
-                        datatype::kTimeType,
-                        false,
-                        bitWidth,
-                        datatype::kNanosecondUnit);
-                    break;
+                    return BitWidthJSON(datatype::kTimeType,
+                                        false,
+                                        bitWidth,
+                                        datatype::kNanosecondUnit);
                 default:
                     return arrow::Status::Invalid("unsupported unit");
             }
-            break;
         }
         case arrow::Type::INTERVAL_MONTHS:
-            type = std::make_shared<UnitZoneJSON>(
-                datatype::kIntervalType, datatype::kYearMonthIntervalUnit);
-            break;
+            return UnitZoneJSON(datatype::kIntervalType,
+                                datatype::kYearMonthIntervalUnit);
         case arrow::Type::INTERVAL_DAY_TIME:
-            type = std::make_shared<UnitZoneJSON>(
-                datatype::kIntervalType, datatype::kDayTimeIntervalUnit);
-            break;
+            return UnitZoneJSON(datatype::kIntervalType,
+                                datatype::kDayTimeIntervalUnit);
         case arrow::Type::DECIMAL128: // fallthrough
         case arrow::Type::DECIMAL256: {
             auto scale =
-                static_cast<const arrow::Decimal128Type*>(fieldType.get())
-                    ->scale();
+                static_cast<const arrow::Decimal128Type&>(fieldType)
+                    .scale();
             auto precision =
-                static_cast<const arrow::Decimal128Type*>(fieldType.get())
-                    ->precision();
-            type = std::make_shared<DecimalJSON>(
-                datatype::kDecimalType, scale, precision);
-            break;
-        }
-        case arrow::Type::LIST: {
-            type = std::make_shared<NameJSON>(datatype::kListType);
-            auto listType =
-                static_cast<const arrow::ListType*>(fieldType.get());
-            for (int i = 0; i < listType->num_fields(); i++) {
-                auto field = marshalJSON(listType->field(i));
-                if (!field.ok()) {
-                    return field.status();
-                }
-                result["children"].push_back(std::move(field).ValueOrDie());
-            }
-            break;
-        }
-        case arrow::Type::STRUCT: {
-            type = std::make_shared<NameJSON>(datatype::kStructType);
-            auto structType =
-                static_cast<const arrow::StructType*>(fieldType.get());
-            for (int i = 0; i < structType->num_fields(); i++) {
-                auto field = marshalJSON(structType->field(i));
-                if (!field.ok()) {
-                    return field.status();
-                }
-                result["children"].push_back(std::move(field).ValueOrDie());
-            }
-            break;
+                static_cast<const arrow::Decimal128Type&>(fieldType)
+                    .precision();
+            return DecimalJSON(datatype::kDecimalType, scale, precision);
         }
+        case arrow::Type::LIST:
+            return NameJSON(datatype::kListType);
+        case arrow::Type::STRUCT:
+            return NameJSON(datatype::kStructType);
         case arrow::Type::MAP: {
-            auto mapType = static_cast<arrow::MapType*>(fieldType.get());
-            auto keySorted = mapType->keys_sorted();
-            type = std::make_shared<MapJSON>(datatype::kMapType, keySorted);
-            auto keyJson = marshalJSON(mapType->key_field());
-            if (!keyJson.ok()) {
-                return arrow::Status::TypeError("failed to parse key");
-            }
-            auto itemJson = marshalJSON(mapType->item_field());
-            if (!itemJson.ok()) {
-                return arrow::Status::TypeError("failed to parse value");
-            }
-            result["children"].push_back({
-                { "key", std::move(keyJson).ValueOrDie() },
-                { "item", std::move(itemJson).ValueOrDie() },
-            });
-            break;
+            auto keySorted =
+                static_cast<const arrow::MapType&>(fieldType)
+                    .keys_sorted();
+            return MapJSON(datatype::kMapType, keySorted);
         }
         case arrow::Type::DURATION: {
-            auto unit = static_cast<const arrow::DurationType*>(fieldType.get())
-                            ->unit();
+            auto unit = static_cast<const arrow::DurationType&>(fieldType)
+                            .unit();
             switch (unit) {
                 case arrow::TimeUnit::SECOND:
-                    type = std::make_shared<UnitZoneJSON>(
-                        datatype::kDurationType, datatype::kSecondUnit);
-                    break;
+                    return UnitZoneJSON(datatype::kDurationType,
+                                        datatype::kSecondUnit);
                 case arrow::TimeUnit::MILLI:
-                    type = std::make_shared<UnitZoneJSON>(
-                        datatype::kDurationType, datatype::kMillisecondUnit);
-                    break;
+                    return UnitZoneJSON(datatype::kDurationType,
+                                        datatype::kMillisecondUnit);
                 case arrow::TimeUnit::MICRO:
-                    type = std::make_shared<UnitZoneJSON>(
-                        datatype::kDurationType, datatype::kMicrosecondUnit);
-                    break;
+                    return UnitZoneJSON(datatype::kDurationType,
+                                        datatype::kMicrosecondUnit);
                 case arrow::TimeUnit::NANO:
-                    type = std::make_shared<UnitZoneJSON>(
-                        datatype::kDurationType, datatype::kNanosecondUnit);
-                    break;
+                    return UnitZoneJSON(datatype::kDurationType,
+                                        datatype::kNanosecondUnit);
                 default:
                     return arrow::Status::Invalid("unsupported unit");
             }
-            break;
         }
         case arrow::Type::INTERVAL_MONTH_DAY_NANO:
-            type = std::make_shared<UnitZoneJSON>(
-                datatype::kIntervalType, datatype::kMonthDayNanoIntervalUnit);
-            break;
+            return UnitZoneJSON(datatype::kIntervalType,
+                                datatype::kMonthDayNanoIntervalUnit);
         default:
             return arrow::Status::Invalid("unsupported type");
     }
+}
 
-    result["name"] = field->name();
-    result["type"] = type->MarshalJSON();
-    return result;
+static const TypeFragment* findTypeFragment(arrow::Type::type id) {
+    static const auto table = []() {
+        std::array<std::unique_ptr<TypeFragment>, arrow::Type::MAX_ID> result{};
+        const std::shared_ptr<arrow::DataType> parameterFreeTypes[] = {
+            arrow::null(),
+            arrow::boolean(),
+            arrow::int8(),
+            arrow::int16(),
+            arrow::int32(),
+            arrow::int64(),
+            arrow::uint8(),
+            arrow::uint16(),
+            arrow::uint32(),
+            arrow::uint64(),
+            arrow::float16(),
+            arrow::float32(),
+            arrow::float64(),
+            arrow::utf8(),
+            arrow::binary(),
+            arrow::date32(),
+            arrow::date64(),
+            arrow::month_interval(),
+            arrow::day_time_interval(),
+            arrow::month_day_nano_interval(),
+        };
+
+        for (const auto& dataType : parameterFreeTypes) {
+            auto type = makeTypeJSON(*dataType);
+            if (!type.ok()) {
+                continue;
+            }
+            auto fragment = std::make_unique<TypeFragment>();
+            fragment->mJson = MarshalJSON(type.ValueOrDie());
+            JSONWriter writer{ &fragment->mText };
+            WriteJSON(type.ValueOrDie(), writer);
+            CBORWriter cborWriter{ &fragment->mCBOR };
+            WriteJSON(type.ValueOrDie(), cborWriter);
+            MsgPackWriter msgPackWriter{ &fragment->mMsgPack };
+            WriteJSON(type.ValueOrDie(), msgPackWriter);
+            result[dataType->id()] = std::move(fragment);
+        }
+        return result;
+    }();
+
+    if (id < 0 || id >= arrow::Type::MAX_ID) {
+        return nullptr;
+    }
+    return table[id].get();
 }
@@ -0,0 +1,676 @@
+#include "Schema_JSON_Conversion.h"
+
+#ifdef SCHEMA_JSON_WITH_SIMDJSON
+
+#include <simdjson.h>
+
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+#include "FieldBuilder.h"
+
+namespace ondemand = simdjson::ondemand;
+
+/**
+ * Deepest field nesting decoded with simdjson. The decoder recurses once per
+ * nested field, deeper schemas are handed over to JSONTextToSchema, which
+ * keeps its state on the heap
+ */
+static constexpr size_t kMaxFieldDepth = 64;
+
+static constexpr int kMetadataKey = 1 << 0;
+static constexpr int kMetadataValue = 1 << 1;
+
+/**
+ * @brief Status of a failed simdjson access
+ * @param[in] error simdjson error code
+ * @param[in] expected What the value should have been, for type errors
+ */
+static arrow::Status toStatus(simdjson::error_code error,
+                              const char* expected) {
+    if (error == simdjson::INCORRECT_TYPE) {
+        return arrow::Status::Invalid("expected ", expected);
+    }
+    return arrow::Status::Invalid(simdjson::error_message(error));
+}
+
+/**
+ * @brief Call func(key, value) for each member of an object, in order, until
+ * it fails. Values func leaves untouched are skipped
+ */
+template <typename Func>
+static arrow::Status forEachMember(ondemand::value& value, Func&& func) {
+    ondemand::object object;
+    auto error = value.get_object().get(object);
+    if (error) {
+        return toStatus(error, "an object");
+    }
+    for (auto member : object) {
+        ondemand::field field;
+        std::string_view key;
+        error = std::move(member).get(field);
+        if (!error) {
+            error = field.unescaped_key().get(key);
+        }
+        if (error) {
+            return toStatus(error, "an object");
+        }
+        auto status = func(key, field.value());
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    return arrow::Status::OK();
+}
+
+/**
+ * @brief Call func(element) for each element of an array, in order, until it
+ * fails
+ */
+template <typename Func>
+static arrow::Status forEachElement(ondemand::value& value, Func&& func) {
+    ondemand::array array;
+    auto error = value.get_array().get(array);
+    if (error) {
+        return toStatus(error, "an array");
+    }
+    for (auto item : array) {
+        ondemand::value element;
+        error = std::move(item).get(element);
+        if (error) {
+            return toStatus(error, "an array");
+        }
+        auto status = func(element);
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    return arrow::Status::OK();
+}
+
+static arrow::Status getString(ondemand::value& value, std::string_view& out) {
+    auto error = value.get_string().get(out);
+    return error ? toStatus(error, "a string") : arrow::Status::OK();
+}
+
+static arrow::Status getBool(ondemand::value& value, bool& out) {
+    auto error = value.get_bool().get(out);
+    return error ? toStatus(error, "a boolean") : arrow::Status::OK();
+}
+
+/**
+ * @brief Read an integer type parameter the way the other decoders do:
+ * floating point values, and integers which do not fit in an int, fail.
+ * Integers wider than 64 bits are floating point values to nlohmann
+ * @param[in] key Json member name, for error messages
+ */
+static arrow::Status getInt(ondemand::value& value, const char* key, int& out) {
+    ondemand::number number;
+    auto error = value.get_number().get(number);
+    if (error == simdjson::BIGINT_ERROR) {
+        return arrow::Status::Invalid("/", key, ": expected an integer");
+    }
+    if (error) {
+        return toStatus(error, "a number");
+    }
+    switch (number.get_number_type()) {
+        case ondemand::number_type::signed_integer:
+            if (!FitsTypeParam(number.get_int64())) {
+                break;
+            }
+            out = static_cast<int>(number.get_int64());
+            return arrow::Status::OK();
+        case ondemand::number_type::unsigned_integer:
+            if (!FitsTypeParam(number.get_uint64())) {
+                break;
+            }
+            out = static_cast<int>(number.get_uint64());
+            return arrow::Status::OK();
+        default:
+            return arrow::Status::Invalid("/", key, ": expected an integer");
+    }
+    return arrow::Status::Invalid("/", key, ": integer out of range");
+}
+
+/**
+ * FieldState is a field whose object is being decoded. Strings are views into
+ * the parser's string buffer, valid until the next document
+ *
+ * mSpec: members of the field and its type
+ * mTypeName: "name" of the type
+ * mParams: type members seen so far (TypeParam flags)
+ * mHasName: whether "name" was seen
+ * mHasTypeName: whether the type's "name" was seen
+ * mHasChildren: whether "children" was seen
+ * mHasMetadata: whether "metadata" was seen
+ * mChildren: converted children fields, in order
+ * mFirstIsEntry: whether the first element of "children" is a map entry
+ * mAnyEntry: whether any element of "children" is a map entry
+ * mMapKey, mMapItem: fields of the first map entry
+ * mChildStatus: first error of an element of "children" met while the type
+ * was not known, OK if none
+ * mChildIndex: position of that element in "children"
+ * mKeys, mValues: metadata
+ */
+struct FieldState {
+    FieldSpec mSpec{};
+    std::string_view mTypeName{};
+    int mParams{};
+    bool mHasName{};
+    bool mHasTypeName{};
+    bool mHasChildren{};
+    bool mHasMetadata{};
+    std::vector<std::shared_ptr<arrow::Field>> mChildren{};
+    bool mFirstIsEntry{};
+    bool mAnyEntry{};
+    std::shared_ptr<arrow::Field> mMapKey{};
+    std::shared_ptr<arrow::Field> mMapItem{};
+    arrow::Status mChildStatus{};
+    size_t mChildIndex{};
+    std::vector<std::string> mKeys{};
+    std::vector<std::string> mValues{};
+};
+
+/**
+ * SimdSchemaDecoder walks a simdjson On-Demand document in a single forward
+ * pass, with the same rules as SchemaSaxHandler: members may come in any
+ * order, unknown members are skipped, map entries are told apart from fields
+ * by their first member, the elements of "children" JSONToSchema does not
+ * read are skipped.
+ *
+ * mInterner: interning table of the built types, nullptr if not interning
+ * mFields: fields being decoded, indexed by nesting depth. Sized once, so
+ * references to them survive the recursion
+ * mSchemaFields: top-level fields converted so far
+ * mSchemaKeys: schema metadata keys
+ * mSchemaValues: schema metadata values
+ * mHasSchema: whether the "schema" member was seen
+ * mHasFields: whether the "fields" member of the schema was seen
+ * mHasMetadata: whether the "metadata" member of the schema was seen
+ * mTooDeep: whether the schema is nested deeper than kMaxFieldDepth
+ */
+class SimdSchemaDecoder {
+public:
+    SimdSchemaDecoder() : mFields(kMaxFieldDepth) {}
+
+    /**
+     * @brief Decode a document
+     * @return arrow::Result contains the converted arrow::Schema if the
+     * document is valid, descriptive status otherwise
+     */
+    arrow::Result<std::shared_ptr<arrow::Schema>> Decode(
+        ondemand::document& document,
+        converter::TypeInterner* interner);
+
+    /**
+     * @brief Whether the last document failed for being nested too deep
+     */
+    bool TooDeep() const { return mTooDeep; }
+
+private:
+    arrow::Status decodeSchema(ondemand::value& value);
+    arrow::Status decodeMetadata(ondemand::value& value,
+                                 std::vector<std::string>& keys,
+                                 std::vector<std::string>& values);
+    arrow::Result<std::shared_ptr<arrow::Field>> decodeField(
+        ondemand::value& value,
+        size_t depth);
+    arrow::Status openField(size_t depth);
+    arrow::Status fieldMember(size_t depth,
+                              std::string_view key,
+                              ondemand::value& value);
+    arrow::Status decodeType(FieldState& field, ondemand::value& value);
+    arrow::Status decodeChildren(size_t depth, ondemand::value& value);
+    arrow::Status decodeChild(size_t depth,
+                              size_t index,
+                              ondemand::value& element);
+    arrow::Result<std::shared_ptr<arrow::Field>> closeField(size_t depth);
+
+    converter::TypeInterner* mInterner{};
+    std::vector<FieldState> mFields;
+    std::vector<std::shared_ptr<arrow::Field>> mSchemaFields{};
+    std::vector<std::string> mSchemaKeys{};
+    std::vector<std::string> mSchemaValues{};
+    bool mHasSchema{};
+    bool mHasFields{};
+    bool mHasMetadata{};
+    bool mTooDeep{};
+};
+
+arrow::Result<std::shared_ptr<arrow::Schema>> SimdSchemaDecoder::Decode(
+    ondemand::document& document,
+    converter::TypeInterner* interner) {
+    mInterner = interner;
+    mSchemaFields.clear();
+    mSchemaKeys.clear();
+    mSchemaValues.clear();
+    mHasSchema = false;
+    mHasFields = false;
+    mHasMetadata = false;
+    mTooDeep = false;
+
+    ondemand::value root;
+    auto error = document.get_value().get(root);
+    if (error) {
+        return toStatus(error, "an object");
+    }
+    auto status = forEachMember(
+        root, [this](std::string_view key, ondemand::value& value) {
+            if (key != "schema") {
+                return arrow::Status::OK();
+            }
+            mHasSchema = true;
+            return decodeSchema(value);
+        });
+    if (!status.ok()) {
+        return status;
+    }
+    if (!document.at_end()) {
+        return arrow::Status::Invalid("trailing content after the document");
+    }
+
+    if (!mHasSchema) {
+        return arrow::Status::Invalid("no schema found");
+    }
+    if (!mHasFields) {
+        return arrow::Status::Invalid("no fields found");
+    }
+    return BuildSchema(std::move(mSchemaFields),
+                       mHasMetadata,
+                       mSchemaKeys,
+                       mSchemaValues);
+}
+
+arrow::Status SimdSchemaDecoder::decodeSchema(ondemand::value& value) {
+    return forEachMember(
+        value, [this](std::string_view key, ondemand::value& member) {
+            if (key == "fields") {
+                mHasFields = true;
+                mSchemaFields.clear();
+                return forEachElement(member, [this](ondemand::value& item) {
+                    auto result = decodeField(item, 0);
+                    if (!result.ok()) {
+                        return result.status();
+                    }
+                    mSchemaFields.push_back(std::move(result).ValueOrDie());
+                    return arrow::Status::OK();
+                });
+            }
+            if (key == "metadata") {
+                mHasMetadata = true;
+                return decodeMetadata(member, mSchemaKeys, mSchemaValues);
+            }
+            return arrow::Status::OK();
+        });
+}
+
+arrow::Status SimdSchemaDecoder::decodeMetadata(
+    ondemand::value& value,
+    std::vector<std::string>& keys,
+    std::vector<std::string>& values) {
+    keys.clear();
+    values.clear();
+    return forEachElement(value, [&](ondemand::value& item) {
+        keys.emplace_back();
+        values.emplace_back();
+        int seen = 0;
+        auto status = forEachMember(
+            item, [&](std::string_view key, ondemand::value& member) {
+                std::string_view text;
+                if (key == "key" || key == "value") {
+                    auto status = getString(member, text);
+                    if (!status.ok()) {
+                        return status;
+                    }
+                }
+                if (key == "key") {
+                    keys.back() = text;
+                    seen |= kMetadataKey;
+                } else if (key == "value") {
+                    values.back() = text;
+                    seen |= kMetadataValue;
+                }
+                return arrow::Status::OK();
+            });
+        if (!status.ok()) {
+            return status;
+        }
+        if (!(seen & kMetadataKey)) {
+            return arrow::Status::Invalid("metadata entry has no key");
+        }
+        if (!(seen & kMetadataValue)) {
+            return arrow::Status::Invalid("metadata entry has no value");
+        }
+        return arrow::Status::OK();
+    });
+}
+
+arrow::Result<std::shared_ptr<arrow::Field>> SimdSchemaDecoder::decodeField(
+    ondemand::value& value,
+    size_t depth) {
+    auto status = openField(depth);
+    if (!status.ok()) {
+        return status;
+    }
+    status = forEachMember(
+        value, [this, depth](std::string_view key, ondemand::value& member) {
+            return fieldMember(depth, key, member);
+        });
+    if (!status.ok()) {
+        return status;
+    }
+    return closeField(depth);
+}
+
+arrow::Status SimdSchemaDecoder::openField(size_t depth) {
+    if (depth >= kMaxFieldDepth) {
+        mTooDeep = true;
+        return arrow::Status::Invalid("schema nested too deep");
+    }
+    auto& field = mFields[depth];
+    field.mSpec = FieldSpec{};
+    field.mTypeName = {};
+    field.mParams = 0;
+    field.mHasName = false;
+    field.mHasTypeName = false;
+    field.mHasChildren = false;
+    field.mHasMetadata = false;
+    field.mChildren.clear();
+    field.mFirstIsEntry = false;
+    field.mAnyEntry = false;
+    field.mMapKey = nullptr;
+    field.mMapItem = nullptr;
+    field.mChildStatus = arrow::Status::OK();
+    field.mChildIndex = 0;
+    field.mKeys.clear();
+    field.mValues.clear();
+    return arrow::Status::OK();
+}
+
+arrow::Status SimdSchemaDecoder::fieldMember(size_t depth,
+                                             std::string_view key,
+                                             ondemand::value& value) {
+    auto& field = mFields[depth];
+    if (key == "name") {
+        field.mHasName = true;
+        return getString(value, field.mSpec.mName);
+    }
+    if (key == "type") {
+        return decodeType(field, value);
+    }
+    if (key == "children") {
+        field.mHasChildren = true;
+        field.mChildren.clear();
+        field.mFirstIsEntry = false;
+        field.mAnyEntry = false;
+        return decodeChildren(depth, value);
+    }
+    if (key == "metadata") {
+        field.mHasMetadata = true;
+        return decodeMetadata(value, field.mKeys, field.mValues);
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status SimdSchemaDecoder::decodeType(FieldState& field,
+                                            ondemand::value& value) {
+    field.mParams = 0;
+    field.mHasTypeName = false;
+    auto& spec = field.mSpec;
+    return forEachMember(
+        value, [&](std::string_view key, ondemand::value& member) {
+            if (key == "name") {
+                field.mHasTypeName = true;
+                return getString(member, field.mTypeName);
+            }
+            if (key == "isSigned") {
+                field.mParams |= TYPE_PARAM_IS_SIGNED;
+                return getBool(member, spec.mIsSigned);
+            }
+            if (key == "bitWidth") {
+                field.mParams |= TYPE_PARAM_BIT_WIDTH;
+                return getInt(member, "bitWidth", spec.mBitWidth);
+            }
+            if (key == "precision") {
+                // the name of a floatingpoint, the digits of a decimal
+                ondemand::json_type type;
+                auto error = member.type().get(type);
+                if (error) {
+                    return toStatus(error, "a string or a number");
+                }
+                if (type == ondemand::json_type::string) {
+                    field.mParams |= TYPE_PARAM_PRECISION_NAME;
+                    return getString(member, spec.mPrecisionName);
+                }
+                field.mParams |= TYPE_PARAM_PRECISION;
+                return getInt(member, "precision", spec.mPrecision);
+            }
+            if (key == "scale") {
+                field.mParams |= TYPE_PARAM_SCALE;
+                return getInt(member, "scale", spec.mScale);
+            }
+            if (key == "unit") {
+                field.mParams |= TYPE_PARAM_UNIT;
+                return getString(member, spec.mUnit);
+            }
+            if (key == "timezone") {
+                field.mParams |= TYPE_PARAM_TIMEZONE;
+                return getString(member, spec.mTimezone);
+            }
+            if (key == "byteWidth") {
+                field.mParams |= TYPE_PARAM_BYTE_WIDTH;
+                return getInt(member, "byteWidth", spec.mByteWidth);
+            }
+            if (key == "keySorted") {
+                field.mParams |= TYPE_PARAM_KEY_SORTED;
+                return getBool(member, spec.mKeySorted);
+            }
+            return arrow::Status::OK();
+        });
+}
+
+/**
+ * Role is what an element of "children" turned out to be, once its first
+ * member is read
+ */
+enum Role {
+    ROLE_UNKNOWN,
+    ROLE_FIELD,
+    ROLE_ENTRY,
+    ROLE_SKIPPED, // map entry after the first one
+};
+
+arrow::Status SimdSchemaDecoder::decodeChildren(size_t depth,
+                                                ondemand::value& value) {
+    size_t index = 0;
+    return forEachElement(value, [&](ondemand::value& element) {
+        auto& parent = mFields[depth];
+        auto position = index++;
+        if (parent.mHasTypeName &&
+            !ReadsChild(datatype::GetTypeFromString(parent.mTypeName),
+                        position)) {
+            // an element JSONToSchema does not read, like the second
+            // element of a list: left untouched, it is skipped
+            return arrow::Status::OK();
+        }
+        auto status = decodeChild(depth, position, element);
+        if (!status.ok() && !parent.mHasTypeName) {
+            // held until the field closes and its type is known, the rest of
+            // the element is skipped
+            if (parent.mChildStatus.ok()) {
+                parent.mChildStatus = std::move(status);
+                parent.mChildIndex = position;
+            }
+            return arrow::Status::OK();
+        }
+        return status;
+    });
+}
+
+arrow::Status SimdSchemaDecoder::decodeChild(size_t depth,
+                                             size_t index,
+                                             ondemand::value& element) {
+    auto role = ROLE_UNKNOWN;
+    auto status = forEachMember(
+        element, [&](std::string_view key, ondemand::value& member) {
+            auto& parent = mFields[depth];
+            if (role == ROLE_UNKNOWN) {
+                // the first member tells a map entry from a field
+                if (key != "key" && key != "item") {
+                    role = ROLE_FIELD;
+                    auto status = openField(depth + 1);
+                    if (!status.ok()) {
+                        return status;
+                    }
+                } else {
+                    parent.mAnyEntry = true;
+                    // only the first entry of a map counts
+                    role = index == 0 ? ROLE_ENTRY : ROLE_SKIPPED;
+                    parent.mFirstIsEntry |= index == 0;
+                }
+            }
+            switch (role) {
+                case ROLE_FIELD:
+                    return fieldMember(depth + 1, key, member);
+                case ROLE_ENTRY: {
+                    if (key != "key" && key != "item") {
+                        return arrow::Status::OK();
+                    }
+                    auto result = decodeField(member, depth + 1);
+                    if (!result.ok()) {
+                        return result.status();
+                    }
+                    auto& target =
+                        key == "key" ? parent.mMapKey : parent.mMapItem;
+                    target = std::move(result).ValueOrDie();
+                    return arrow::Status::OK();
+                }
+                default:
+                    return arrow::Status::OK();
+            }
+        });
+    if (!status.ok()) {
+        return status;
+    }
+    if (role == ROLE_UNKNOWN) {
+        return arrow::Status::Invalid("empty child object");
+    }
+    if (role == ROLE_FIELD) {
+        auto result = closeField(depth + 1);
+        if (!result.ok()) {
+            return result.status();
+        }
+        mFields[depth].mChildren.push_back(std::move(result).ValueOrDie());
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Result<std::shared_ptr<arrow::Field>> SimdSchemaDecoder::closeField(
+    size_t depth) {
+    auto& field = mFields[depth];
+    if (!field.mHasName) {
+        return arrow::Status::Invalid("field has no name");
+    }
+    if (!field.mHasTypeName) {
+        return arrow::Status::Invalid("field has no type name");
+    }
+
+    auto& spec = field.mSpec;
+    spec.mTypeName = datatype::GetTypeFromString(field.mTypeName);
+    if (!field.mChildStatus.ok() &&
+        ReadsChild(spec.mTypeName, field.mChildIndex)) {
+        return field.mChildStatus;
+    }
+    if (HasChildren(spec.mTypeName) && !field.mHasChildren) {
+        return arrow::Status::Invalid("no children found");
+    }
+    int required = RequiredTypeParams(spec.mTypeName);
+    int missing = required & ~field.mParams;
+    if (missing != 0) {
+        return arrow::Status::Invalid("type has no ",
+                                      TypeParamKey(missing & -missing));
+    }
+
+    switch (spec.mTypeName) {
+        case datatype::TYPE_NAME_LIST:
+            if (field.mChildren.empty() || field.mFirstIsEntry) {
+                return arrow::Status::Invalid("list has no element field");
+            }
+            break;
+        case datatype::TYPE_NAME_MAP:
+            if (!field.mFirstIsEntry || field.mMapKey == nullptr ||
+                field.mMapItem == nullptr) {
+                return arrow::Status::Invalid(
+                    "map has no key and item fields");
+            }
+            field.mChildren.clear();
+            field.mChildren.push_back(std::move(field.mMapKey));
+            field.mChildren.push_back(std::move(field.mMapItem));
+            break;
+        case datatype::TYPE_NAME_STRUCT:
+            if (field.mAnyEntry) {
+                return arrow::Status::Invalid("struct child is not a field");
+            }
+            break;
+        default:
+            break;
+    }
+
+    return BuildField(spec,
+                      field.mChildren,
+                      field.mHasMetadata,
+                      field.mKeys,
+                      field.mValues,
+                      mInterner);
+}
+
+/**
+ * Per-thread decoding state, reused across documents so that a decoding only
+ * allocates the arrow objects of its result once warmed up
+ *
+ * mParser: simdjson parser, its buffers grow to the largest document seen
+ * mPadded: copy of the text followed by the padding simdjson reads past the
+ * end of its input
+ * mDecoder: field scratch storage
+ */
+struct SimdState {
+    ondemand::parser mParser{};
+    std::string mPadded{};
+    SimdSchemaDecoder mDecoder{};
+};
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::SimdJSONTextToSchema(
+    std::string_view text,
+    const JSONToSchemaOptions& options) {
+    static thread_local SimdState tState{};
+
+    tState.mPadded.assign(text);
+    tState.mPadded.append(simdjson::SIMDJSON_PADDING, ' ');
+    ondemand::document document;
+    auto error = tState.mParser
+                     .iterate(tState.mPadded.data(),
+                              text.size(),
+                              tState.mPadded.size())
+                     .get(document);
+    if (error) {
+        return arrow::Status::Invalid(simdjson::error_message(error));
+    }
+
+    auto result = tState.mDecoder.Decode(document, options.interner);
+    if (!result.ok() && tState.mDecoder.TooDeep()) {
+        return converter::JSONTextToSchema(text, options);
+    }
+    return result;
+}
+
+#else
+
+arrow::Result<std::shared_ptr<arrow::Schema>> converter::SimdJSONTextToSchema(
+    std::string_view,
+    const JSONToSchemaOptions&) {
+    return arrow::Status::NotImplemented(
+        "built without simdjson (SCHEMA_JSON_WITH_SIMDJSON=OFF)");
+}
+
+#endif // SCHEMA_JSON_WITH_SIMDJSON
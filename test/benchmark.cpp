@@ -0,0 +1,666 @@
+#include <arrow/io/memory.h>
+#include <arrow/type.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "Schema_JSON_Cache.h"
+#include "DataTypes.h"
+#include "Schema_JSON_Conversion.h"
+#include "Schema_JSON_Index.h"
+#include "Schema_JSON_PushDecoder.h"
+#include "Schema_JSON_StreamReader.h"
+#include "helper.h"
+
+using json = nlohmann::json;
+
+/**
+ * Heap usage, tracked to report the peak memory of a conversion. Each block
+ * starts with a header recording its size
+ */
+static std::atomic<size_t> gHeapBytes{ 0 };
+static std::atomic<size_t> gHeapPeak{ 0 };
+static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+void* operator new(size_t size) {
+    auto data = static_cast<char*>(std::malloc(size + kHeaderSize));
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(data) = size;
+    auto bytes = gHeapBytes.fetch_add(size) + size;
+    auto peak = gHeapPeak.load();
+    while (bytes > peak && !gHeapPeak.compare_exchange_weak(peak, bytes)) {
+    }
+    return data + kHeaderSize;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    auto data = static_cast<char*>(ptr) - kHeaderSize;
+    gHeapBytes.fetch_sub(*reinterpret_cast<size_t*>(data));
+    std::free(data);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+/**
+ * Every conversion runs on a thread with this stack size. Deep schemas only
+ * fit because the traversal keeps its work stack on the heap
+ */
+static constexpr size_t kStackSize = 128 * 1024;
+
+/**
+ * @brief Average time of one call to func, in nanoseconds
+ */
+template <typename Func>
+static double measure(int iterations, Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        func();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() /
+           iterations;
+}
+
+/**
+ * @brief Convert a schema nested `depth` levels deep in both directions and
+ * print the cost per nesting level
+ */
+static void benchmarkDepth(int depth) {
+    auto schema = helper::MakeNestedSchema(depth);
+    int iterations = std::max(1, 200000 / depth);
+    double toJSON = 0;
+    double toString = 0;
+    double fromJSON = 0;
+    bool ok = true;
+    // arrow releases nested types recursively, decoded schemas are kept alive
+    // and released on the main thread
+    std::vector<std::shared_ptr<arrow::Schema>> decodedSchemas{};
+    decodedSchemas.reserve(iterations);
+
+    auto ran = helper::RunWithStackSize(kStackSize, [&]() {
+        toJSON = measure(iterations, [&]() {
+            ok &= converter::SchemaToJSON(schema).ok();
+        });
+        toString = measure(iterations, [&]() {
+            ok &= converter::SchemaToJSONString(schema).ok();
+        });
+
+        auto jsonObj = converter::SchemaToJSON(schema).ValueOrDie();
+        fromJSON = measure(iterations, [&]() {
+            auto decoded = converter::JSONToSchema(jsonObj);
+            ok &= decoded.ok();
+            decodedSchemas.push_back(decoded.ValueOr(nullptr));
+        });
+    });
+
+    if (!ran || !ok) {
+        std::printf("%8d  failed\n", depth);
+        return;
+    }
+    std::printf("%8d %16.1f %16.1f %16.1f\n",
+                depth,
+                toJSON / depth,
+                toString / depth,
+                fromJSON / depth);
+}
+
+/**
+ * @brief Decode the text of a wide schema through a json DOM and straight
+ * from the text, printing the time and the peak heap growth of each
+ */
+static void benchmarkTextDecode(int numFields) {
+    auto schema = helper::MakeWideSchema(numFields);
+    auto text = converter::SchemaToJSONString(schema).ValueOrDie();
+
+    auto run = [&](const char* label, auto&& decode) {
+        auto base = gHeapBytes.load();
+        gHeapPeak = base;
+        auto start = std::chrono::steady_clock::now();
+        auto decoded = decode();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%24s %12.2f ms %12.2f MiB %s\n",
+                    label,
+                    std::chrono::duration<double, std::milli>(elapsed).count(),
+                    (gHeapPeak.load() - base) / (1024.0 * 1024.0),
+                    decoded.ok() ? "" : "failed");
+    };
+
+    std::printf("\n%d fields, %.2f MiB of text\n",
+                numFields,
+                text.size() / (1024.0 * 1024.0));
+    std::printf("%24s %15s %16s\n", "", "time", "peak heap");
+    run("parse + JSONToSchema", [&]() {
+        return converter::JSONToSchema(json::parse(text));
+    });
+    run("JSONTextToSchema",
+        [&]() { return converter::JSONTextToSchema(text); });
+}
+
+/**
+ * @brief Decoding throughput of each text decoder, in GB/s of json text, on
+ * the test schemas and on a wide synthetic one
+ */
+static void benchmarkSimdDecode(int numFields) {
+    auto schema = helper::MakeWideSchema(numFields);
+    std::vector<std::string> testTexts{};
+    for (const auto& data : helper::GetTestData()) {
+        testTexts.push_back(
+            converter::SchemaToJSONString(data.second).ValueOrDie());
+    }
+    std::vector<std::string> wideTexts{
+        converter::SchemaToJSONString(schema).ValueOrDie()
+    };
+
+    std::printf("\ntext decoding throughput\n");
+    std::printf("%24s %16s %16s\n", "", "test schemas", "synthetic");
+    auto run = [&](const char* label, auto&& decode) {
+        double rates[2]{};
+        bool ok = true;
+        bool available = true;
+        for (int set = 0; set < 2; set++) {
+            const auto& texts = set == 0 ? testTexts : wideTexts;
+            size_t bytes = 0;
+            for (const auto& text : texts) {
+                bytes += text.size();
+            }
+            int iterations = set == 0 ? 2000 : 5;
+            auto elapsed = measure(iterations, [&]() {
+                for (const auto& text : texts) {
+                    auto status = decode(text).status();
+                    available &= !status.IsNotImplemented();
+                    ok &= status.ok();
+                }
+            });
+            rates[set] = bytes / elapsed;
+        }
+        if (!available) {
+            std::printf("%24s %16s %16s\n", label, "n/a", "n/a");
+            return;
+        }
+        std::printf("%24s %11.3f GB/s %11.3f GB/s %s\n",
+                    label,
+                    rates[0],
+                    rates[1],
+                    ok ? "" : "failed");
+    };
+
+    run("parse + JSONToSchema", [](const std::string& text) {
+        return converter::JSONToSchema(json::parse(text));
+    });
+    run("JSONTextToSchema", [](const std::string& text) {
+        return converter::JSONTextToSchema(text);
+    });
+    run("SimdJSONTextToSchema", [](const std::string& text) {
+        return converter::SimdJSONTextToSchema(text);
+    });
+}
+
+/**
+ * @brief Load many schema files, as a catalog does on cold start: read into a
+ * string, parse and convert the DOM, or map and decode in place
+ */
+static void benchmarkFileDecode(int numFiles) {
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("schema_json_bench_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> paths{};
+    auto testData = helper::GetTestData();
+    auto item = testData.begin();
+    for (int i = 0; i < numFiles; i++, item++) {
+        if (item == testData.end()) {
+            item = testData.begin();
+        }
+        paths.push_back((directory / (std::to_string(i) + ".json")).string());
+        if (!converter::SchemaToJSONFile(item->second, paths.back()).ok()) {
+            std::printf("\ncannot write %s\n", paths.back().c_str());
+            return;
+        }
+    }
+
+    bool ok = true;
+    auto copied = measure(5, [&]() {
+        for (const auto& path : paths) {
+            std::ifstream file{ path, std::ios::binary };
+            std::string text{ std::istreambuf_iterator<char>{ file }, {} };
+            ok &= converter::JSONToSchema(json::parse(text)).ok();
+        }
+    });
+    auto mapped = measure(5, [&]() {
+        for (const auto& path : paths) {
+            ok &= converter::JSONFileToSchema(path).ok();
+        }
+    });
+    std::filesystem::remove_all(directory);
+
+    std::printf("\n%d schema files loaded%s\n",
+                numFiles,
+                ok ? "" : " (failed)");
+    std::printf("%24s %12.2f us/file\n",
+                "read + parse + convert",
+                copied / numFiles / 1000);
+    std::printf("%24s %12.2f us/file\n",
+                "JSONFileToSchema",
+                mapped / numFiles / 1000);
+}
+
+/**
+ * @brief Decode a newline-delimited stream of schemas: split the lines and
+ * parse each one, or read them through a SchemaStreamReader
+ */
+static void benchmarkStreamReader(int numLines) {
+    std::vector<std::string> texts{};
+    for (const auto& data : helper::GetTestData()) {
+        texts.push_back(
+            converter::SchemaToJSONString(data.second).ValueOrDie());
+    }
+    std::string stream{};
+    for (int i = 0; i < numLines; i++) {
+        stream += texts[i % texts.size()];
+        stream += '\n';
+    }
+    auto buffer = arrow::Buffer::FromString(stream);
+
+    int count = 0;
+    auto split = measure(1, [&]() {
+        size_t begin = 0;
+        while (begin < stream.size()) {
+            auto end = stream.find('\n', begin);
+            auto line = stream.substr(begin, end - begin);
+            count += converter::JSONToSchema(json::parse(line)).ok();
+            begin = end + 1;
+        }
+    });
+    auto read = [&](bool useThreads) {
+        converter::StreamReaderOptions options{};
+        options.useThreads = useThreads;
+        return measure(1, [&]() {
+            converter::SchemaStreamReader reader{
+                std::make_shared<arrow::io::BufferReader>(buffer), options
+            };
+            for (auto next = reader.Next(); !next.ok() || *next != nullptr;
+                 next = reader.Next()) {
+                count += next.ok();
+            }
+        });
+    };
+    auto serial = read(false);
+    auto parallel = read(true);
+
+    std::printf("\n%d schemas in a %.2f MiB stream%s\n",
+                numLines,
+                stream.size() / (1024.0 * 1024.0),
+                count == 3 * numLines ? "" : " (failed)");
+    std::printf("%24s %12.2f us/line\n",
+                "split + parse + convert",
+                split / numLines / 1000);
+    std::printf("%24s %12.2f us/line\n",
+                "SchemaStreamReader",
+                serial / numLines / 1000);
+    std::printf("%24s %12.2f us/line\n",
+                "useThreads",
+                parallel / numLines / 1000);
+}
+
+/**
+ * @brief Decode a wide schema received in chunks: buffer the whole text then
+ * decode it, or push each chunk to a SchemaPushDecoder as it arrives
+ */
+static void benchmarkPushDecode(int numFields, size_t chunkSize) {
+    auto schema = helper::MakeWideSchema(numFields);
+    auto text = converter::SchemaToJSONString(schema).ValueOrDie();
+    std::vector<std::string> chunks{};
+    for (size_t i = 0; i < text.size(); i += chunkSize) {
+        chunks.push_back(text.substr(i, chunkSize));
+    }
+
+    auto run = [&](const char* label, auto&& decode) {
+        auto base = gHeapBytes.load();
+        gHeapPeak = base;
+        auto start = std::chrono::steady_clock::now();
+        auto decoded = decode();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%24s %12.2f ms %12.2f MiB %s\n",
+                    label,
+                    std::chrono::duration<double, std::milli>(elapsed).count(),
+                    (gHeapPeak.load() - base) / (1024.0 * 1024.0),
+                    decoded.ok() ? "" : "failed");
+    };
+
+    std::printf("\n%d fields, %.2f MiB of text in %zu KiB chunks\n",
+                numFields,
+                text.size() / (1024.0 * 1024.0),
+                chunkSize / 1024);
+    std::printf("%24s %15s %16s\n", "", "time", "peak heap");
+    run("buffer + decode", [&]() {
+        std::string buffer{};
+        for (const auto& chunk : chunks) {
+            buffer += chunk;
+        }
+        return converter::JSONTextToSchema(buffer);
+    });
+    run("SchemaPushDecoder", [&]() {
+        converter::SchemaPushDecoder decoder{};
+        for (const auto& chunk : chunks) {
+            if (!decoder.Feed(chunk).ok()) {
+                break;
+            }
+        }
+        return decoder.Finish();
+    });
+}
+
+/**
+ * @brief Decoding throughput on a corpus where every other document is
+ * malformed (a field without type, a bit width given as a string, a list
+ * without element), serially and as a batch on arrow's CPU thread pool
+ */
+static void benchmarkMalformedDecode(int numDocuments) {
+    std::vector<json> documents{};
+    for (const auto& data : helper::GetTestData()) {
+        documents.push_back(converter::SchemaToJSON(data.second).ValueOrDie());
+    }
+    std::vector<json> corpus{};
+    for (int i = 0; i < numDocuments; i++) {
+        auto document = documents[i % documents.size()];
+        auto& fields = document["schema"]["fields"];
+        if (i % 2 && !fields.empty()) {
+            auto& field = fields.back();
+            switch (i / 2 % 3) {
+                case 0:
+                    field.erase("type");
+                    break;
+                case 1:
+                    field["type"] = { { "name", "int" },
+                                      { "bitWidth", "32" },
+                                      { "isSigned", true } };
+                    break;
+                default:
+                    field["type"] = { { "name", "list" } };
+                    field["children"] = json::array();
+                    break;
+            }
+        }
+        corpus.push_back(std::move(document));
+    }
+    std::vector<const json*> jsonObjs{};
+    for (const auto& document : corpus) {
+        jsonObjs.push_back(&document);
+    }
+
+    int numFailed = 0;
+    auto serial = measure(1, [&]() {
+        for (const auto& document : corpus) {
+            numFailed += !converter::JSONToSchema(document).ok();
+        }
+    });
+    auto batch = measure(1, [&]() {
+        for (const auto& result : converter::JSONToSchemaBatch(jsonObjs)) {
+            numFailed += !result.ok();
+        }
+    });
+
+    std::printf("\n%d documents, %d%% malformed\n",
+                numDocuments,
+                numFailed * 100 / (2 * numDocuments));
+    std::printf("%24s %12.0f docs/s\n",
+                "JSONToSchema",
+                numDocuments / serial * 1e9);
+    std::printf("%24s %12.0f docs/s\n",
+                "JSONToSchemaBatch",
+                numDocuments / batch * 1e9);
+}
+
+/**
+ * @brief Check a wide schema document without decoding it, next to decoding
+ * it, on the json DOM and on the text
+ */
+static void benchmarkValidate(int numFields) {
+    auto schema = helper::MakeWideSchema(numFields);
+    auto jsonObj = converter::SchemaToJSON(schema).ValueOrDie();
+    auto text = jsonObj.dump();
+    bool ok = true;
+
+    auto decode = measure(
+        5, [&]() { ok &= converter::JSONToSchema(jsonObj).ok(); });
+    auto validate = measure(
+        5, [&]() { ok &= converter::ValidateSchemaJSON(jsonObj).ok(); });
+    auto decodeText = measure(
+        5, [&]() { ok &= converter::JSONTextToSchema(text).ok(); });
+    auto validateText = measure(
+        5, [&]() { ok &= converter::ValidateSchemaJSONText(text).ok(); });
+
+    std::printf("\n%d fields validated%s\n", numFields, ok ? "" : " (failed)");
+    std::printf("%24s %12.2f ms\n", "JSONToSchema", decode / 1e6);
+    std::printf("%24s %12.2f ms\n", "ValidateSchemaJSON", validate / 1e6);
+    std::printf("%24s %12.2f ms\n", "JSONTextToSchema", decodeText / 1e6);
+    std::printf(
+        "%24s %12.2f ms\n", "ValidateSchemaJSONText", validateText / 1e6);
+}
+
+/**
+ * @brief Decode a few columns of a wide schema text by a SchemaIndex, against
+ * decoding the whole text
+ */
+static void benchmarkIndexedDecode(int numFields) {
+    auto schema = helper::MakeWideSchema(numFields);
+    auto text = converter::SchemaToJSONString(schema).ValueOrDie();
+    converter::ProjectionSpec projection{
+        { "column_0", "column_" + std::to_string(numFields / 2 + 1),
+          "column_" + std::to_string(numFields - 1) }
+    };
+    bool ok = true;
+
+    converter::SchemaIndex index{};
+    auto build = measure(5, [&]() {
+        auto built = converter::BuildSchemaIndex(text);
+        ok &= built.ok();
+        if (built.ok()) {
+            index = std::move(built).ValueOrDie();
+        }
+    });
+    auto serialized = index.Serialize();
+    auto load = measure(5, [&]() {
+        ok &= converter::SchemaIndex::Deserialize(serialized).ok();
+    });
+    auto full = measure(5, [&]() {
+        ok &= converter::JSONTextToSchema(text).ok();
+    });
+    auto indexed = measure(1000, [&]() {
+        ok &= converter::JSONTextToSchema(text, index, projection).ok();
+    });
+
+    std::printf("\n%d fields, %zu MiB of text, %zu KiB of index%s\n",
+                numFields,
+                text.size() >> 20,
+                serialized.size() >> 10,
+                ok ? "" : " (failed)");
+    std::printf("%24s %12.2f ms\n", "BuildSchemaIndex", build / 1e6);
+    std::printf("%24s %12.2f ms\n", "Deserialize", load / 1e6);
+    std::printf("%24s %12.2f ms\n", "JSONTextToSchema", full / 1e6);
+    std::printf("%24s %12.2f ms\n", "3 columns by index", indexed / 1e6);
+}
+
+/**
+ * @brief Decode a wide json document serially and on arrow's CPU thread pool
+ */
+static void benchmarkParallelDecode(int numFields) {
+    auto schema = helper::MakeWideSchema(numFields);
+    auto jsonObj = converter::SchemaToJSON(schema).ValueOrDie();
+    converter::JSONToSchemaOptions options{};
+    options.useThreads = true;
+    bool ok = true;
+
+    auto serial = measure(
+        5, [&]() { ok &= converter::JSONToSchema(jsonObj).ok(); });
+    auto parallel = measure(
+        5, [&]() { ok &= converter::JSONToSchema(jsonObj, options).ok(); });
+
+    std::printf("\n%d fields decoded from json%s\n",
+                numFields,
+                ok ? "" : " (failed)");
+    std::printf("%24s %12.2f ms\n", "serial", serial / 1e6);
+    std::printf("%24s %12.2f ms\n", "useThreads", parallel / 1e6);
+}
+
+/**
+ * @brief Decode the same schema text over and over, as an ingest tier sees it
+ * with every message batch, with and without a decode cache
+ */
+static void benchmarkDecodeCache(int numFields) {
+    auto schema = helper::MakeWideSchema(numFields);
+    auto text = converter::SchemaToJSONString(schema).ValueOrDie();
+    int iterations = 1000;
+    bool ok = true;
+
+    auto uncached = measure(iterations, [&]() {
+        ok &= converter::JSONTextToSchema(text).ok();
+    });
+    converter::SchemaDecodeCache cache{};
+    auto cached = measure(iterations, [&]() {
+        ok &= cache.JSONTextToSchema(text).ok();
+    });
+
+    std::printf("\n%d fields decoded %d times%s\n",
+                numFields,
+                iterations,
+                ok ? "" : " (failed)");
+    std::printf("%24s %12.2f us\n", "JSONTextToSchema", uncached / 1000);
+    std::printf("%24s %12.2f us (hit rate %.3f)\n",
+                "SchemaDecodeCache",
+                cached / 1000,
+                cache.Stats().HitRate());
+}
+
+/**
+ * @brief The type name lookup as it was before the constexpr tables: a
+ * function-local std::unordered_map keyed by std::string
+ */
+static datatype::TypeName mapTypeFromString(const std::string& type) {
+    static const std::unordered_map<std::string, datatype::TypeName> hashMap{
+        { "null", datatype::TYPE_NAME_NULL },
+        { "bool", datatype::TYPE_NAME_BOOL },
+        { "int", datatype::TYPE_NAME_INT },
+        { "floatingpoint", datatype::TYPE_NAME_FLOATING_POINT },
+        { "utf8", datatype::TYPE_NAME_UTF8 },
+        { "binary", datatype::TYPE_NAME_BINARY },
+        { "fixedsizebinary", datatype::TYPE_NAME_FIXED_SIZE_BINARY },
+        { "date", datatype::TYPE_NAME_DATE },
+        { "timestamp", datatype::TYPE_NAME_TIMESTAMP },
+        { "time", datatype::TYPE_NAME_TIME },
+        { "interval", datatype::TYPE_NAME_INTERVAL },
+        { "decimal", datatype::TYPE_NAME_DECIMAL },
+        { "list", datatype::TYPE_NAME_LIST },
+        { "struct", datatype::TYPE_NAME_STRUCT },
+        { "map", datatype::TYPE_NAME_MAP },
+        { "duration", datatype::TYPE_NAME_DURATION },
+    };
+    auto item = hashMap.find(type);
+    if (item != hashMap.end()) {
+        return item->second;
+    }
+    return datatype::TYPE_NAME_NOT_SET;
+}
+
+/**
+ * @brief The unit lookup as it was before the constexpr tables
+ */
+static datatype::DateTimeUnit mapUnitFromString(const std::string& unit) {
+    static const std::unordered_map<std::string, datatype::DateTimeUnit>
+        hashMap{
+            { "DAY", datatype::DATE_TIME_UNIT_DAY },
+            { "SECOND", datatype::DATE_TIME_UNIT_SECOND },
+            { "MILLISECOND", datatype::DATE_TIME_UNIT_MILLISECOND },
+            { "MICROSECOND", datatype::DATE_TIME_UNIT_MICROSECOND },
+            { "NANOSECOND", datatype::DATE_TIME_UNIT_NANOSECOND },
+        };
+    auto item = hashMap.find(unit);
+    if (item != hashMap.end()) {
+        return item->second;
+    }
+    return datatype::DATE_TIME_UNIT_NOT_SET;
+}
+
+/**
+ * @brief Look up type and unit names (plus a few misses) with the former
+ * hash maps and with the constexpr matchers, printing the cost per lookup
+ */
+static void benchmarkNameLookup() {
+    std::vector<std::string> typeNames{};
+    for (const auto& name : datatype::kTypeNames) {
+        typeNames.emplace_back(name);
+    }
+    typeNames.emplace_back("lists");
+    std::vector<std::string> unitNames{};
+    for (const auto& name : datatype::kUnitNames) {
+        unitNames.emplace_back(name);
+    }
+    unitNames.emplace_back("MINUTE");
+
+    int iterations = 1000000;
+    size_t sink = 0;
+    auto lookupAll = [&](const auto& names, auto&& lookup) {
+        return measure(iterations,
+                       [&]() {
+                           for (const auto& name : names) {
+                               sink += lookup(name);
+                           }
+                       }) /
+               names.size();
+    };
+
+    auto typeMap = lookupAll(typeNames, mapTypeFromString);
+    auto typeSwitch = lookupAll(typeNames, [](const std::string& name) {
+        return datatype::GetTypeFromString(name);
+    });
+    auto unitMap = lookupAll(unitNames, mapUnitFromString);
+    auto unitSwitch = lookupAll(unitNames, [](const std::string& name) {
+        return datatype::GetUnitFromString(name);
+    });
+
+    std::printf("\nname lookups (checksum %zu)\n", sink);
+    std::printf("%24s %16s %16s\n", "", "unordered_map", "constexpr");
+    std::printf("%24s %13.2f ns %13.2f ns\n", "type name", typeMap, typeSwitch);
+    std::printf("%24s %13.2f ns %13.2f ns\n", "unit", unitMap, unitSwitch);
+}
+
+int main() {
+    std::printf("nested schemas converted on a %zu KiB stack\n",
+                kStackSize / 1024);
+    std::printf("%8s %16s %16s %16s\n",
+                "depth",
+                "SchemaToJSON",
+                "ToJSONString",
+                "JSONToSchema");
+    std::printf("%8s %16s %16s %16s\n", "", "ns/level", "ns/level", "ns/level");
+    for (int depth : { 10, 100, 10000 }) {
+        benchmarkDepth(depth);
+    }
+    benchmarkTextDecode(100000);
+    benchmarkSimdDecode(100000);
+    benchmarkFileDecode(10000);
+    benchmarkStreamReader(100000);
+    benchmarkPushDecode(100000, 64 * 1024);
+    benchmarkMalformedDecode(100000);
+    benchmarkValidate(100000);
+    benchmarkIndexedDecode(100000);
+    benchmarkParallelDecode(100000);
+    benchmarkDecodeCache(200);
+    benchmarkNameLookup();
+    return 0;
+}
@@ -5,6 +5,9 @@
 #include <arrow/type.h>
 #include <arrow/util/key_value_metadata.h>
 #include <arrow/util/logging.h>
+#include <pthread.h>
+
+#include <functional>
 
 /**
  * Implementation for arrow::UuidType - a kind of user-defined type (extension
@@ -147,6 +150,67 @@ static std::shared_ptr<arrow::Schema> makeExtensionSchema() {
     return arrow::schema({ arrow::field("uuid", arrow::uuid()) });
 }
 
+/**
+ * @brief Build a schema with `numFields` top-level fields named column_0,
+ * column_1, ..., cycling through flat, parameterized and nested types
+ */
+inline std::shared_ptr<arrow::Schema> MakeWideSchema(int numFields) {
+    std::vector<std::shared_ptr<arrow::Field>> fields{};
+    fields.reserve(numFields);
+    for (int i = 0; i < numFields; i++) {
+        std::shared_ptr<arrow::DataType> type{};
+        switch (i % 7) {
+            case 0:
+                type = arrow::int64();
+                break;
+            case 1:
+                type = arrow::utf8();
+                break;
+            case 2:
+                type = arrow::timestamp(arrow::TimeUnit::MICRO, "UTC");
+                break;
+            case 3:
+                type = arrow::decimal(12, 3);
+                break;
+            case 4:
+                type = arrow::list(arrow::utf8());
+                break;
+            case 5:
+                type = arrow::struct_({ arrow::field("a", arrow::int32()),
+                                        arrow::field("b", arrow::utf8()) });
+                break;
+            default:
+                type = arrow::map(arrow::utf8(), arrow::float64());
+                break;
+        }
+        fields.push_back(arrow::field("column_" + std::to_string(i), type));
+    }
+    return arrow::schema(fields);
+}
+
+/**
+ * @brief Build a schema with a single field nested `depth` levels deep, cycling
+ * through list, struct and map values
+ */
+inline std::shared_ptr<arrow::Schema> MakeNestedSchema(int depth) {
+    std::shared_ptr<arrow::DataType> type = arrow::int32();
+    for (int i = 0; i < depth; i++) {
+        switch (i % 3) {
+            case 0:
+                type = arrow::list(arrow::field("item", type));
+                break;
+            case 1:
+                type = arrow::struct_({ arrow::field("id", arrow::int8()),
+                                        arrow::field("inner", type) });
+                break;
+            default:
+                type = arrow::map(arrow::utf8(), arrow::field("value", type));
+                break;
+        }
+    }
+    return arrow::schema({ arrow::field("nested", type) });
+}
+
 /**
  * @brief Get data for all testcases
  * @return Hashmap (string -> arrow::Schema) contains all basic types that arrow
@@ -169,6 +233,68 @@ GetTestData() {
     return hashMap;
 }
 
+/**
+ * @brief Get data for the encoder testcases: all testcases of GetTestData()
+ * plus empty schemas, strings needing escapes or long length prefixes and a
+ * wide schema
+ */
+inline std::unordered_map<std::string, std::shared_ptr<arrow::Schema>>
+GetEdgeCaseTestData() {
+    auto testData = GetTestData();
+    testData["empty"] = arrow::schema({});
+    testData["metadata_only"] = arrow::schema({})->WithMetadata(
+        arrow::KeyValueMetadata::Make({ "k" }, { "v" }));
+    testData["escapes"] = arrow::schema(
+        { arrow::field("quote\"back\\slash\ttab\x01\x7f", arrow::int32()),
+          arrow::field("unicode \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80",
+                       arrow::utf8()),
+          arrow::field("empty_struct", arrow::struct_({})),
+          arrow::field("timestamp_tz",
+                       arrow::timestamp(arrow::TimeUnit::MICRO,
+                                        "America/Argentina/ComodRivadavia")),
+          arrow::field("meta", arrow::utf8(), false)
+              ->WithMetadata(
+                  arrow::KeyValueMetadata::Make({ "a\nb" }, { "c\rd" })) });
+    testData["long_strings"] = arrow::schema(
+        { arrow::field(std::string(300, 'n'), arrow::int16()),
+          arrow::field("long_metadata", arrow::binary())
+              ->WithMetadata(arrow::KeyValueMetadata::Make(
+                  { std::string(40, 'k') }, { std::string(70000, 'v') })) });
+
+    // wide enough to be flushed into the sink several times
+    testData["wide"] = MakeWideSchema(5000);
+    return testData;
+}
+
+/**
+ * @brief Run a function on a new thread with the given stack size and wait for
+ * it to finish
+ * @return false if the thread could not be started
+ */
+inline bool RunWithStackSize(size_t stackSize, std::function<void()> func) {
+    pthread_attr_t attr{};
+    if (pthread_attr_init(&attr) != 0) {
+        return false;
+    }
+    pthread_attr_setstacksize(&attr, stackSize);
+
+    pthread_t thread{};
+    auto started = pthread_create(
+        &thread,
+        &attr,
+        [](void* arg) -> void* {
+            (*static_cast<std::function<void()>*>(arg))();
+            return nullptr;
+        },
+        &func);
+    pthread_attr_destroy(&attr);
+    if (started != 0) {
+        return false;
+    }
+    pthread_join(thread, nullptr);
+    return true;
+}
+
 } // namespace helper
 
 #endif // _TEST_HELPER_H_
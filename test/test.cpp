@@ -1,14 +1,54 @@
+#include <arrow/io/memory.h>
+#include <arrow/memory_pool.h>
 #include <arrow/type.h>
+#include <arrow/util/thread_pool.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iomanip>
+#include <new>
+#include <thread>
+#include <unistd.h>
 #include <nlohmann/json.hpp>
 
+#include "Schema_JSON_Cache.h"
 #include "Schema_JSON_Conversion.h"
+#include "Schema_JSON_Converter.h"
+#include "Schema_JSON_Index.h"
+#include "Schema_JSON_LazySchema.h"
+#include "Schema_JSON_PushDecoder.h"
+#include "Schema_JSON_StreamReader.h"
+#include "Schema_JSON_TypeInterner.h"
 #include "helper.h"
 
 using json = nlohmann::json;
 
+/**
+ * Global allocation counter, used by the allocation-count tests below
+ */
+static std::atomic<size_t> gAllocationCount{ 0 };
+
+void* operator new(size_t size) {
+    gAllocationCount++;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
 /**
  * Test all basic data types. See helper::GetTestData() for more details
  */
@@ -37,3 +77,1903 @@ TEST(SchemaJSON, AllTestCases) {
         ASSERT_TRUE(schemaJson.ValueOrDie() == newJson.ValueOrDie());
     }
 };
+
+/**
+ * SchemaToJSONString must produce exactly the bytes of SchemaToJSON().dump()
+ */
+TEST(SchemaJSON, StringMatchesDump) {
+    auto testData = helper::GetEdgeCaseTestData();
+
+    for (const auto& data : testData) {
+        std::cout << "Test item: " << data.first << std::endl;
+        auto schemaJson = converter::SchemaToJSON(data.second);
+        ASSERT_TRUE(schemaJson.ok());
+
+        auto schemaText = converter::SchemaToJSONString(data.second);
+        ASSERT_TRUE(schemaText.ok());
+        ASSERT_EQ(schemaText.ValueOrDie(), schemaJson.ValueOrDie().dump());
+
+        auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+        auto status = converter::SchemaToJSONStream(data.second, sink.get());
+        ASSERT_TRUE(status.ok());
+        auto buffer = sink->Finish().ValueOrDie();
+        ASSERT_EQ(buffer->ToString(), schemaText.ValueOrDie());
+    }
+}
+
+/**
+ * Invalid UTF-8 makes nlohmann::json::dump() throw, the writer reports it
+ */
+TEST(SchemaJSON, StringRejectsInvalidUTF8) {
+    auto schema = arrow::schema({ arrow::field("bad\xff", arrow::int32()) });
+    auto schemaJson = converter::SchemaToJSON(schema);
+    ASSERT_TRUE(schemaJson.ok());
+    ASSERT_THROW(schemaJson.ValueOrDie().dump(), nlohmann::json::type_error);
+    ASSERT_FALSE(converter::SchemaToJSONString(schema).ok());
+}
+
+/**
+ * Type descriptors are value types: converting a wide schema to text must not
+ * allocate per field (only the output buffer grows), and converting it to a
+ * DOM allocates only the nodes of the result
+ */
+TEST(SchemaJSON, NoPerFieldTypeAllocation) {
+    auto schema = helper::MakeWideSchema(10000);
+    // wide schemas are marshalled in parallel: start the thread pool first
+    ASSERT_TRUE(converter::SchemaToJSONString(schema).ok());
+
+    auto before = gAllocationCount.load();
+    auto schemaText = converter::SchemaToJSONString(schema);
+    auto allocations = gAllocationCount.load() - before;
+
+    ASSERT_TRUE(schemaText.ok());
+    std::cout << "Allocations for " << schema->num_fields()
+              << " fields: " << allocations << std::endl;
+    ASSERT_LT(allocations, 64u);
+
+    // The DOM path allocates the json nodes it returns, nothing more: no
+    // descriptor objects and no copies of the type objects. A deep copy of
+    // the result allocates each node exactly once, so it is the bound.
+    before = gAllocationCount.load();
+    auto schemaJson = converter::SchemaToJSON(schema);
+    auto domAllocations = gAllocationCount.load() - before;
+    ASSERT_TRUE(schemaJson.ok());
+
+    before = gAllocationCount.load();
+    json copy = schemaJson.ValueOrDie();
+    auto copyAllocations = gAllocationCount.load() - before;
+
+    std::cout << "DOM allocations for " << schema->num_fields()
+              << " fields: " << domAllocations << " (a copy of the result: "
+              << copyAllocations << ")" << std::endl;
+    ASSERT_LE(domAllocations, copyAllocations + 64u);
+}
+
+/**
+ * Conversion cache: hits share the result, metadata is part of the key, and
+ * the cache stays within capacity
+ */
+TEST(SchemaJSON, ConversionCache) {
+    converter::SchemaJSONCache cache{ 4, 2 };
+    auto testData = helper::GetTestData();
+    auto schema = testData["primitives"];
+
+    auto first = cache.SchemaToJSON(schema);
+    auto second = cache.SchemaToJSON(schema);
+    ASSERT_TRUE(first.ok() && second.ok());
+    ASSERT_EQ(first.ValueOrDie(), second.ValueOrDie());
+    ASSERT_TRUE(*first.ValueOrDie() ==
+                converter::SchemaToJSON(schema).ValueOrDie());
+
+    auto text = cache.SchemaToJSONString(schema);
+    ASSERT_TRUE(text.ok());
+    ASSERT_EQ(*text.ValueOrDie(), first.ValueOrDie()->dump());
+
+    // same fields, different metadata
+    auto otherMetadata = schema->WithMetadata(
+        arrow::KeyValueMetadata::Make({ "k1" }, { "other" }));
+    auto other = cache.SchemaToJSON(otherMetadata);
+    ASSERT_TRUE(other.ok());
+    ASSERT_FALSE(*other.ValueOrDie() == *first.ValueOrDie());
+
+    auto stats = cache.Stats();
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.misses, 3u);
+    ASSERT_EQ(stats.size, 3u);
+
+    cache.Invalidate(schema);
+    ASSERT_EQ(cache.Stats().size, 1u);
+
+    for (const auto& data : testData) {
+        ASSERT_TRUE(cache.SchemaToJSONString(data.second).ok());
+    }
+    stats = cache.Stats();
+    ASSERT_LE(stats.size, 4u);
+    ASSERT_GT(stats.evictions, 0u);
+
+    cache.Clear();
+    ASSERT_EQ(cache.Stats().size, 0u);
+}
+
+/**
+ * Concurrent lookups of the same schemas return the same results
+ */
+TEST(SchemaJSON, ConversionCacheConcurrent) {
+    converter::SchemaJSONCache cache{};
+    auto testData = helper::GetTestData();
+
+    std::vector<std::thread> threads{};
+    std::atomic<int> failures{ 0 };
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&]() {
+            for (int round = 0; round < 100; round++) {
+                for (const auto& data : testData) {
+                    auto result = cache.SchemaToJSONString(data.second);
+                    if (!result.ok() ||
+                        *result.ValueOrDie() !=
+                            converter::SchemaToJSONString(data.second)
+                                .ValueOrDie()) {
+                        failures++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_GT(cache.Stats().hits, 0u);
+}
+
+/**
+ * Parallel marshalling gives the same output as the serial path, for wide
+ * top-level field lists and wide structs, on the default and a custom executor
+ */
+TEST(SchemaJSON, ParallelMatchesSerial) {
+    auto wideSchema = helper::MakeWideSchema(8000);
+    auto wideStruct = arrow::schema(
+        { arrow::field("id", arrow::int32()),
+          arrow::field("nested", arrow::struct_(wideSchema->fields())) });
+
+    auto pool = arrow::internal::ThreadPool::Make(3).ValueOrDie();
+    converter::SchemaToJSONOptions options{};
+    options.useThreads = true;
+    options.parallelThreshold = 1000;
+
+    std::vector<arrow::internal::Executor*> executors{ nullptr, pool.get() };
+    for (auto executor : executors) {
+        options.executor = executor;
+        for (const auto& schema : { wideSchema, wideStruct }) {
+            auto serialJson = converter::SchemaToJSON(schema);
+            auto parallelJson = converter::SchemaToJSON(schema, options);
+            ASSERT_TRUE(serialJson.ok() && parallelJson.ok());
+            ASSERT_TRUE(serialJson.ValueOrDie() == parallelJson.ValueOrDie());
+
+            auto parallelText = converter::SchemaToJSONString(schema, options);
+            ASSERT_TRUE(parallelText.ok());
+            ASSERT_EQ(parallelText.ValueOrDie(),
+                      serialJson.ValueOrDie().dump());
+        }
+    }
+
+    // the first unsupported field is reported, as in the serial path
+    auto fields = wideSchema->fields();
+    fields[4321] = arrow::field("bad", arrow::large_utf8());
+    fields[7000] = arrow::field("bad", arrow::large_binary());
+    auto badSchema = arrow::schema(fields);
+    auto serialStatus = converter::SchemaToJSON(badSchema).status();
+    auto parallelStatus = converter::SchemaToJSON(badSchema, options).status();
+    ASSERT_FALSE(parallelStatus.ok());
+    ASSERT_EQ(parallelStatus.ToString(), serialStatus.ToString());
+    ASSERT_FALSE(converter::SchemaToJSONString(badSchema, options).ok());
+}
+
+/**
+ * Deeply nested schemas convert in both directions on a thread with a small
+ * stack, the traversal does not recurse per nesting level
+ */
+TEST(SchemaJSON, DeepNestingSmallStack) {
+    auto schema = helper::MakeNestedSchema(10000);
+    std::string text{};
+    std::vector<std::string> roundTripTexts{};
+    // arrow releases nested types recursively, they are released on this
+    // thread rather than on the small stack
+    std::vector<std::shared_ptr<arrow::Schema>> decodedSchemas{};
+
+    auto ran = helper::RunWithStackSize(256 * 1024, [&]() {
+        auto result = converter::SchemaToJSONString(schema);
+        auto jsonObj = converter::SchemaToJSON(schema);
+        if (!result.ok() || !jsonObj.ok()) {
+            return;
+        }
+        text = std::move(result).ValueOrDie();
+
+        // json::dump() and operator== recurse, compare through decoding
+        auto parsed = json::parse(text);
+        for (const auto* input : { &parsed, &jsonObj.ValueOrDie() }) {
+            auto decoded = converter::JSONToSchema(*input);
+            if (!decoded.ok()) {
+                return;
+            }
+            decodedSchemas.push_back(std::move(decoded).ValueOrDie());
+            auto decodedText =
+                converter::SchemaToJSONString(decodedSchemas.back());
+            if (!decodedText.ok()) {
+                return;
+            }
+            roundTripTexts.push_back(std::move(decodedText).ValueOrDie());
+        }
+
+        auto decoded = converter::JSONTextToSchema(text);
+        if (!decoded.ok()) {
+            return;
+        }
+        decodedSchemas.push_back(std::move(decoded).ValueOrDie());
+        auto decodedText = converter::SchemaToJSONString(decodedSchemas.back());
+        if (decodedText.ok()) {
+            roundTripTexts.push_back(std::move(decodedText).ValueOrDie());
+        }
+    });
+    ASSERT_TRUE(ran);
+    ASSERT_FALSE(text.empty());
+    ASSERT_EQ(roundTripTexts.size(), 3u);
+    ASSERT_EQ(roundTripTexts[0], text);
+    ASSERT_EQ(roundTripTexts[1], text);
+    ASSERT_EQ(roundTripTexts[2], text);
+}
+
+/**
+ * SchemaToPoolJSON takes every json node from the given memory pool and gives
+ * it back when the result is released
+ */
+TEST(SchemaJSON, PoolAllocatedJSON) {
+    arrow::ProxyMemoryPool pool{ arrow::default_memory_pool() };
+    for (const auto& data : helper::GetTestData()) {
+        auto schema = data.second;
+        {
+            auto poolJson = converter::SchemaToPoolJSON(schema, &pool);
+            ASSERT_TRUE(poolJson.ok());
+            ASSERT_GT(pool.bytes_allocated(), 0);
+
+            auto schemaJson = converter::SchemaToJSON(schema);
+            ASSERT_TRUE(schemaJson.ok());
+            ASSERT_TRUE(json(poolJson.ValueOrDie()) == schemaJson.ValueOrDie());
+
+            auto newSchema = converter::JSONToSchema(poolJson.ValueOrDie());
+            ASSERT_TRUE(newSchema.ok());
+            auto newJson = converter::SchemaToJSON(newSchema.ValueOrDie());
+            ASSERT_TRUE(newJson.ok());
+            ASSERT_TRUE(newJson.ValueOrDie() == schemaJson.ValueOrDie());
+        }
+        ASSERT_EQ(pool.bytes_allocated(), 0);
+    }
+}
+
+/**
+ * With an arena, a wide conversion does not touch the global heap per field
+ * (also when marshalled in parallel), and is released with one Reset()
+ */
+TEST(SchemaJSON, ArenaAllocatedJSON) {
+    auto schema = helper::MakeWideSchema(8000);
+    auto serialJson = converter::SchemaToJSON(schema).ValueOrDie();
+
+    arrow::ProxyMemoryPool parent{ arrow::default_memory_pool() };
+    converter::ArenaMemoryPool arena{ &parent };
+    {
+        auto before = gAllocationCount.load();
+        auto poolJson = converter::SchemaToPoolJSON(schema, &arena);
+        auto allocations = gAllocationCount.load() - before;
+
+        ASSERT_TRUE(poolJson.ok());
+        std::cout << "Global allocations for " << schema->num_fields()
+                  << " fields: " << allocations << std::endl;
+        ASSERT_LT(allocations, 64u);
+        ASSERT_GT(arena.bytes_allocated(), 0);
+        ASSERT_TRUE(json(poolJson.ValueOrDie()) == serialJson);
+    }
+    ASSERT_EQ(arena.bytes_allocated(), 0);
+    ASSERT_GT(parent.bytes_allocated(), 0);
+    arena.Reset();
+    ASSERT_EQ(parent.bytes_allocated(), 0);
+
+    converter::SchemaToJSONOptions options{};
+    options.useThreads = true;
+    options.parallelThreshold = 1000;
+    {
+        auto allocationsBefore = arena.num_allocations();
+        auto poolJson = converter::SchemaToPoolJSON(schema, &arena, options);
+        ASSERT_TRUE(poolJson.ok());
+        ASSERT_GT(arena.num_allocations() - allocationsBefore,
+                  static_cast<int64_t>(schema->num_fields()));
+        ASSERT_TRUE(json(poolJson.ValueOrDie()) == serialJson);
+    }
+    arena.Reset();
+    ASSERT_EQ(parent.bytes_allocated(), 0);
+}
+
+/**
+ * SchemaToCBOR/SchemaToMsgPack must produce exactly the bytes of
+ * to_cbor()/to_msgpack() of SchemaToJSON(), and decode back to the same schema
+ */
+TEST(SchemaJSON, BinaryMatchesNlohmann) {
+    converter::SchemaToJSONOptions parallel{};
+    parallel.useThreads = true;
+    parallel.parallelThreshold = 1000;
+
+    for (const auto& data : helper::GetEdgeCaseTestData()) {
+        std::cout << "Test item: " << data.first << std::endl;
+        auto schemaJson = converter::SchemaToJSON(data.second).ValueOrDie();
+
+        auto cbor = converter::SchemaToCBOR(data.second);
+        ASSERT_TRUE(cbor.ok());
+        ASSERT_EQ(cbor.ValueOrDie(), json::to_cbor(schemaJson));
+        auto msgPack = converter::SchemaToMsgPack(data.second);
+        ASSERT_TRUE(msgPack.ok());
+        ASSERT_EQ(msgPack.ValueOrDie(), json::to_msgpack(schemaJson));
+
+        auto parallelCBOR = converter::SchemaToCBOR(data.second, parallel);
+        ASSERT_TRUE(parallelCBOR.ok());
+        ASSERT_EQ(parallelCBOR.ValueOrDie(), cbor.ValueOrDie());
+
+        if (data.second->num_fields() == 0) {
+            continue;
+        }
+        // decoding gives the same result (or error) as JSONToSchema, whose
+        // messages also name the path of the malformed value
+        auto expected = converter::JSONToSchema(schemaJson);
+        auto fromCBOR = converter::CBORToSchema(cbor.ValueOrDie());
+        auto fromMsgPack = converter::MsgPackToSchema(msgPack.ValueOrDie());
+        ASSERT_EQ(fromCBOR.status().code(), expected.status().code());
+        ASSERT_EQ(fromMsgPack.status().code(), expected.status().code());
+        if (expected.ok()) {
+            ASSERT_TRUE(fromCBOR.ValueOrDie()->Equals(*expected.ValueOrDie()));
+            ASSERT_TRUE(
+                fromMsgPack.ValueOrDie()->Equals(*expected.ValueOrDie()));
+        }
+    }
+
+    std::vector<uint8_t> truncated = converter::SchemaToCBOR(
+                                         helper::GetTestData()["primitives"])
+                                         .ValueOrDie();
+    truncated.resize(truncated.size() / 2);
+    ASSERT_FALSE(converter::CBORToSchema(truncated).ok());
+    ASSERT_FALSE(converter::MsgPackToSchema(truncated).ok());
+}
+
+/**
+ * Size and speed of the binary encodings compared to JSON text
+ */
+TEST(SchemaJSON, BinaryVersusTextSizeAndSpeed) {
+    auto schema = helper::MakeWideSchema(2000);
+    const int iterations = 5;
+
+    auto measure = [&](const char* name, auto encode, auto decode) {
+        auto start = std::chrono::steady_clock::now();
+        size_t size = 0;
+        for (int i = 0; i < iterations; i++) {
+            size = encode().size();
+        }
+        auto encoded = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            EXPECT_TRUE(decode().ok()) << name;
+        }
+        auto decoded = std::chrono::steady_clock::now();
+
+        using us = std::chrono::microseconds;
+        std::cout << std::setw(8) << name << ": " << std::setw(8) << size
+                  << " bytes, encode "
+                  << std::chrono::duration_cast<us>(encoded - start).count() /
+                         iterations
+                  << " us, decode "
+                  << std::chrono::duration_cast<us>(decoded - encoded).count() /
+                         iterations
+                  << " us" << std::endl;
+        return size;
+    };
+
+    auto text = converter::SchemaToJSONString(schema).ValueOrDie();
+    auto cbor = converter::SchemaToCBOR(schema).ValueOrDie();
+    auto msgPack = converter::SchemaToMsgPack(schema).ValueOrDie();
+
+    auto textSize = measure(
+        "text",
+        [&]() { return converter::SchemaToJSONString(schema).ValueOrDie(); },
+        [&]() { return converter::JSONToSchema(json::parse(text)); });
+    auto cborSize = measure(
+        "cbor",
+        [&]() { return converter::SchemaToCBOR(schema).ValueOrDie(); },
+        [&]() { return converter::CBORToSchema(cbor); });
+    auto msgPackSize = measure(
+        "msgpack",
+        [&]() { return converter::SchemaToMsgPack(schema).ValueOrDie(); },
+        [&]() { return converter::MsgPackToSchema(msgPack); });
+
+    ASSERT_LT(cborSize, textSize);
+    ASSERT_LT(msgPackSize, textSize);
+}
+
+/**
+ * Batch conversions give, in input order, the same result as converting each
+ * item on its own, whether schemas are split into many tasks or not
+ */
+TEST(SchemaJSON, BatchMatchesSingle) {
+    std::vector<std::shared_ptr<arrow::Schema>> schemas{};
+    for (const auto& data : helper::GetEdgeCaseTestData()) {
+        schemas.push_back(data.second);
+    }
+    schemas.push_back(helper::MakeWideSchema(20000));
+    auto fields = schemas.back()->fields();
+    fields[15000] = arrow::field("bad", arrow::large_utf8());
+    fields[17000] = arrow::field("bad", arrow::large_binary());
+    schemas.push_back(arrow::schema(fields));
+    schemas.push_back(nullptr);
+
+    auto pool = arrow::internal::ThreadPool::Make(3).ValueOrDie();
+    std::vector<converter::BatchOptions> batchOptions(3);
+    batchOptions[1].fieldsPerTask = 100;
+    batchOptions[2].fieldsPerTask = 1;
+    batchOptions[2].executor = pool.get();
+
+    for (const auto& options : batchOptions) {
+        auto results = converter::SchemaToJSONBatch(schemas, options);
+        ASSERT_EQ(results.size(), schemas.size());
+
+        std::vector<json> documents{};
+        for (size_t i = 0; i < schemas.size(); i++) {
+            if (schemas[i] == nullptr) {
+                ASSERT_FALSE(results[i].ok());
+                continue;
+            }
+            auto expected = converter::SchemaToJSON(schemas[i]);
+            ASSERT_EQ(results[i].status().ToString(),
+                      expected.status().ToString());
+            if (expected.ok()) {
+                ASSERT_TRUE(results[i].ValueOrDie() == expected.ValueOrDie());
+                documents.push_back(std::move(expected).ValueOrDie());
+            }
+        }
+
+        json malformed = { { "schema", { { "fields", 1 } } } };
+        json missingType = {
+            { "schema", { { "fields", { { { "name", "x" } } } } } }
+        };
+        std::vector<const json*> jsonObjs{};
+        for (const auto& document : documents) {
+            jsonObjs.push_back(&document);
+        }
+        jsonObjs.insert(jsonObjs.begin() + 1, &malformed);
+        jsonObjs.push_back(&missingType);
+        jsonObjs.push_back(nullptr);
+
+        auto decoded = converter::JSONToSchemaBatch(jsonObjs, options);
+        ASSERT_EQ(decoded.size(), jsonObjs.size());
+        ASSERT_FALSE(decoded[1].ok());
+        ASSERT_FALSE(decoded[decoded.size() - 2].ok());
+        ASSERT_FALSE(decoded.back().ok());
+        for (size_t i = 0; i + 1 < jsonObjs.size(); i++) {
+            // some documents (null, empty struct) are rejected by JSONToSchema
+            // as well, with the same status
+            auto expected = converter::JSONToSchema(*jsonObjs[i]);
+            ASSERT_EQ(decoded[i].status().ToString(),
+                      expected.status().ToString());
+            if (expected.ok()) {
+                ASSERT_TRUE(
+                    decoded[i].ValueOrDie()->Equals(*expected.ValueOrDie()));
+            }
+        }
+    }
+}
+
+/**
+ * A Converter session gives the same results as the free functions, and once
+ * warmed up, writing a recurring schema as text allocates nothing while
+ * decoding allocates less than a fresh JSONToSchema
+ */
+TEST(SchemaJSON, ConverterReusesScratch) {
+    auto fields = helper::MakeWideSchema(2000)->fields();
+    for (size_t i = 3; i < fields.size(); i += 4) {
+        fields[i] = fields[i]->WithMetadata(arrow::key_value_metadata(
+            { "unit_of_measure" }, { "centimetres" }));
+    }
+    auto schema = arrow::schema(
+        fields,
+        arrow::key_value_metadata({ "origin_of_data" },
+                                  { "a sensor somewhere far away" }));
+
+    converter::Converter session{};
+    for (const auto& data : helper::GetEdgeCaseTestData()) {
+        auto expected = converter::SchemaToJSONString(data.second);
+        auto text = session.SchemaToJSONString(data.second);
+        ASSERT_EQ(text.status().ToString(), expected.status().ToString());
+        if (expected.ok()) {
+            ASSERT_EQ(text.ValueOrDie(), expected.ValueOrDie());
+        }
+    }
+
+    auto expectedText = converter::SchemaToJSONString(schema).ValueOrDie();
+    ASSERT_TRUE(session.SchemaToJSONString(schema).ok());
+    auto before = gAllocationCount.load();
+    auto text = session.SchemaToJSONString(schema);
+    auto allocations = gAllocationCount.load() - before;
+    ASSERT_TRUE(text.ok());
+    ASSERT_EQ(text.ValueOrDie(), expectedText);
+    ASSERT_EQ(allocations, 0u);
+
+    auto expectedJson = converter::SchemaToJSON(schema).ValueOrDie();
+    ASSERT_TRUE(session.SchemaToJSON(schema).ValueOrDie() == expectedJson);
+
+    before = gAllocationCount.load();
+    auto expected = converter::JSONToSchema(expectedJson);
+    auto freeAllocations = gAllocationCount.load() - before;
+    ASSERT_TRUE(session.JSONToSchema(expectedJson).ok());
+    before = gAllocationCount.load();
+    auto decoded = session.JSONToSchema(expectedJson);
+    auto sessionAllocations = gAllocationCount.load() - before;
+
+    ASSERT_TRUE(decoded.ok());
+    ASSERT_TRUE(decoded.ValueOrDie()->Equals(*expected.ValueOrDie(), true));
+    std::cout << "Decode allocations: " << freeAllocations << " (free), "
+              << sessionAllocations << " (session)" << std::endl;
+    ASSERT_LT(sessionAllocations, freeAllocations);
+}
+
+/**
+ * Decoding text through SAX events gives the same schemas as parsing it and
+ * decoding the DOM, whatever the member order, and fails on malformed text
+ * instead of throwing
+ */
+TEST(SchemaJSON, TextDecodeMatchesDOM) {
+    auto decodeDOM = [](const std::string& text)
+        -> arrow::Result<std::shared_ptr<arrow::Schema>> {
+        auto jsonObj = json::parse(text, nullptr, false);
+        if (jsonObj.is_discarded()) {
+            return arrow::Status::Invalid("malformed json");
+        }
+        return converter::JSONToSchema(jsonObj);
+    };
+
+    std::vector<std::string> texts{};
+    for (auto testData :
+         { helper::GetTestData(), helper::GetEdgeCaseTestData() }) {
+        for (const auto& data : testData) {
+            auto text = converter::SchemaToJSONString(data.second);
+            if (text.ok()) {
+                texts.push_back(std::move(text).ValueOrDie());
+            }
+        }
+    }
+
+    // members in reverse order, unknown members, a map entry item first
+    texts.push_back(R"({"extra": [1, {"a": null}], "schema": {
+        "metadata": [{"value": "v", "key": "k"}],
+        "fields": [
+            {"type": {"keySorted": true, "name": "map"}, "nullable": true,
+             "name": "m", "children": [{"item": {
+                "type": {"unit": "MICROSECOND", "timezone": "UTC",
+                         "name": "timestamp"},
+                "name": "value", "comment": {"x": [true, 2.5]}},
+              "key": {"type": {"name": "utf8"}, "name": "key"}}]},
+            {"type": {"name": "struct"}, "name": "s", "children": [
+                {"name": "a", "type": {"scale": 2, "precision": 10,
+                                       "name": "decimal"}},
+                {"type": {"name": "list"}, "name": "b", "children": [
+                    {"type": {"bitWidth": 16, "isSigned": false,
+                              "name": "int"}, "name": "item"}]}],
+             "metadata": [{"key": "a", "value": "b"}]}
+        ]}})");
+    ASSERT_TRUE(converter::JSONTextToSchema(texts.back()).ok());
+
+    // children JSONToSchema does not read, before and after the type
+    const std::string unread[] = {
+        R"({"schema": {"fields": [{"name": "l", "type": {"name": "list"},
+            "children": [{"name": "item", "type": {"name": "utf8"}},
+                         {"name": "x", "type": {"name": "bogus"}}]}]}})",
+        R"({"schema": {"fields": [{"name": "l", "children": [
+            {"name": "item", "type": {"name": "utf8"}},
+            {"type": {"name": "utf8"}}, 7, [null], {},
+            {"name": "s", "type": {"name": "struct"}, "children": [
+                {"name": "x", "type": {"name": "bogus"}}]}],
+            "type": {"name": "list"}}]}})",
+        R"({"schema": {"fields": [{"name": "m", "children": [
+            {"key": {"name": "k", "type": {"name": "utf8"}},
+             "item": {"name": "v", "type": {"name": "utf8"}}},
+            {"name": "x", "type": {"name": "int", "bitWidth": 3}}],
+            "type": {"name": "map", "keySorted": false}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "children": [
+            {"name": "x", "type": {"name": "bogus"}}],
+            "type": {"name": "utf8"}}]}})",
+    };
+    for (const auto& text : unread) {
+        ASSERT_TRUE(converter::JSONTextToSchema(text).ok()) << text;
+        texts.push_back(text);
+    }
+
+    for (const auto& text : texts) {
+        auto expected = decodeDOM(text);
+        auto decoded = converter::JSONTextToSchema(text);
+        ASSERT_EQ(decoded.ok(), expected.ok()) << text.substr(0, 200);
+        if (expected.ok()) {
+            ASSERT_EQ(decoded.ValueOrDie()->ToString(true),
+                      expected.ValueOrDie()->ToString(true));
+        }
+    }
+
+    const std::string malformed[] = {
+        "",
+        "null",
+        R"({"schema": {"fields": [)",
+        R"({"schema": {"metadata": []}})",
+        R"({"schema": {"fields": [{"type": {"name": "utf8"}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "type": {"name": "x"}}]}})",
+        R"({"schema": {"fields": [{"name": "a",
+            "type": {"name": "int", "bitWidth": "8", "isSigned": true}}]}})",
+        R"({"schema": {"fields": [{"name": "a",
+            "type": {"name": "int", "bitWidth": 8}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "type": {"name": "list"}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "children": [{"key": {
+            "name": "k", "type": {"name": "utf8"}}}],
+            "type": {"name": "map", "keySorted": false}}]}})",
+        R"({"schema": {"fields": [], "metadata": [{"key": "k"}]}})",
+        R"({"schema": {"fields": [{"name": "l", "children": [
+            {"name": "s", "type": {"name": "struct"}, "children": [
+                {"name": "x", "type": {"name": "bogus"}}]}],
+            "type": {"name": "list"}}]}})",
+        R"({"schema": {"fields": [{"name": "s", "children": [
+            {"name": "a", "type": {"name": "utf8"}}, 7],
+            "type": {"name": "struct"}}]}})",
+    };
+    for (const auto& text : malformed) {
+        ASSERT_FALSE(decodeDOM(text).ok()) << text;
+        ASSERT_FALSE(converter::JSONTextToSchema(text).ok()) << text;
+    }
+
+    // a session reuses its handler, an error does not leak into the next call
+    converter::Converter session{};
+    ASSERT_FALSE(session.JSONTextToSchema(malformed[2]).ok());
+    for (const auto& text : texts) {
+        auto expected = converter::JSONTextToSchema(text);
+        auto decoded = session.JSONTextToSchema(text);
+        ASSERT_EQ(decoded.ok(), expected.ok());
+        if (expected.ok()) {
+            ASSERT_TRUE(decoded.ValueOrDie()->Equals(*expected.ValueOrDie()));
+        }
+    }
+}
+
+/**
+ * JSONToSchema borrows the json nodes instead of copying them: decoding a
+ * wide schema allocates little more than the arrow objects of the result
+ */
+TEST(SchemaJSON, DecodeAllocations) {
+    auto fields = helper::MakeWideSchema(20000)->fields();
+    auto schema = arrow::schema(
+        fields, arrow::key_value_metadata({ "k" }, { "v" }));
+    auto jsonObj = converter::SchemaToJSON(schema).ValueOrDie();
+
+    // what the result itself costs: building the same schema straight from
+    // arrow, children, types, fields and all
+    std::function<std::shared_ptr<arrow::DataType>(
+        const std::shared_ptr<arrow::DataType>&)>
+        rebuildType = [&](const std::shared_ptr<arrow::DataType>& type)
+        -> std::shared_ptr<arrow::DataType> {
+        switch (type->id()) {
+            case arrow::Type::LIST: {
+                auto item = type->field(0);
+                return arrow::list(
+                    arrow::field(item->name(), rebuildType(item->type())));
+            }
+            case arrow::Type::MAP: {
+                const auto& mapType =
+                    static_cast<const arrow::MapType&>(*type);
+                auto item = mapType.item_field();
+                return arrow::map(
+                    rebuildType(mapType.key_type()),
+                    arrow::field(item->name(), rebuildType(item->type())));
+            }
+            case arrow::Type::STRUCT: {
+                std::vector<std::shared_ptr<arrow::Field>> children{};
+                for (const auto& child : type->fields()) {
+                    children.push_back(arrow::field(
+                        child->name(), rebuildType(child->type())));
+                }
+                return arrow::struct_(children);
+            }
+            case arrow::Type::TIMESTAMP: {
+                const auto& timestampType =
+                    static_cast<const arrow::TimestampType&>(*type);
+                return arrow::timestamp(timestampType.unit(),
+                                        timestampType.timezone());
+            }
+            case arrow::Type::DECIMAL128: {
+                const auto& decimalType =
+                    static_cast<const arrow::DecimalType&>(*type);
+                return arrow::decimal(decimalType.precision(),
+                                      decimalType.scale());
+            }
+            default:
+                return type;
+        }
+    };
+    auto before = gAllocationCount.load();
+    std::vector<std::shared_ptr<arrow::Field>> rebuiltFields{};
+    rebuiltFields.reserve(fields.size());
+    for (const auto& field : fields) {
+        rebuiltFields.push_back(
+            arrow::field(field->name(), rebuildType(field->type())));
+    }
+    auto rebuilt = arrow::schema(std::move(rebuiltFields),
+                                 arrow::key_value_metadata({ "k" }, { "v" }));
+    auto baseline = gAllocationCount.load() - before;
+
+    before = gAllocationCount.load();
+    auto decoded = converter::JSONToSchema(jsonObj);
+    auto allocations = gAllocationCount.load() - before;
+
+    ASSERT_TRUE(decoded.ok());
+    ASSERT_TRUE(decoded.ValueOrDie()->Equals(*schema, true));
+    std::cout << "Decode allocations for " << fields.size()
+              << " fields: " << allocations << " (result alone: " << baseline
+              << ")" << std::endl;
+    ASSERT_LT(allocations, baseline + baseline / 4);
+}
+
+/**
+ * With an interner, equal types decoded from different documents (DOM or
+ * text, on any thread) share one instance, and are reclaimed once unused
+ */
+TEST(SchemaJSON, TypeInterning) {
+    auto nested = arrow::struct_(
+        { arrow::field("ts", arrow::timestamp(arrow::TimeUnit::MILLI, "UTC")),
+          arrow::field("tags", arrow::list(arrow::utf8())),
+          arrow::field("price", arrow::decimal(12, 4)) });
+    auto first = arrow::schema({ arrow::field("a", nested),
+                                 arrow::field("b", arrow::int32()) });
+    auto second = arrow::schema(
+        { arrow::field("c", arrow::map(arrow::utf8(), nested)),
+          arrow::field("d", nested) });
+    auto firstJson = converter::SchemaToJSON(first).ValueOrDie();
+    auto secondText = converter::SchemaToJSONString(second).ValueOrDie();
+
+    // without an interner every decoding builds its own types
+    auto plainFirst = converter::JSONToSchema(firstJson).ValueOrDie();
+    auto plainSecond = converter::JSONTextToSchema(secondText).ValueOrDie();
+    ASSERT_TRUE(plainFirst->field(0)->type()->Equals(
+        plainSecond->field(1)->type()));
+    ASSERT_NE(plainFirst->field(0)->type(), plainSecond->field(1)->type());
+
+    converter::TypeInterner interner{};
+    converter::JSONToSchemaOptions options{};
+    options.interner = &interner;
+    {
+        auto internedFirst =
+            converter::JSONToSchema(firstJson, options).ValueOrDie();
+        auto internedSecond =
+            converter::JSONTextToSchema(secondText, options).ValueOrDie();
+        ASSERT_TRUE(internedFirst->Equals(*first, true));
+        ASSERT_TRUE(internedSecond->Equals(*second, true));
+
+        const auto& canonical = internedFirst->field(0)->type();
+        ASSERT_EQ(internedSecond->field(1)->type(), canonical);
+        ASSERT_EQ(internedSecond->field(0)->type()->field(0)->type()->field(1)
+                      ->type(),
+                  canonical);
+
+        // children names and metadata are part of the identity
+        auto renamed = arrow::schema({ arrow::field(
+            "a",
+            arrow::struct_({ arrow::field(
+                "ts", arrow::timestamp(arrow::TimeUnit::MILLI, "UTC")) })) });
+        auto withMetadata = arrow::schema({ arrow::field(
+            "a",
+            arrow::struct_({ arrow::field(
+                "ts",
+                arrow::timestamp(arrow::TimeUnit::MILLI, "UTC"),
+                true,
+                arrow::key_value_metadata({ "k" }, { "v" })) })) });
+        auto renamedSchema = converter::JSONToSchema(
+            converter::SchemaToJSON(renamed).ValueOrDie(), options);
+        auto metadataSchema = converter::JSONToSchema(
+            converter::SchemaToJSON(withMetadata).ValueOrDie(), options);
+        ASSERT_TRUE(metadataSchema.ValueOrDie()->Equals(*withMetadata, true));
+        ASSERT_NE(renamedSchema.ValueOrDie()->field(0)->type(),
+                  metadataSchema.ValueOrDie()->field(0)->type());
+
+        // concurrent decodings agree on the canonical instance
+        converter::Converter session{ {}, options };
+        std::vector<std::thread> threads{};
+        std::atomic<int> failures{ 0 };
+        for (int t = 0; t < 8; t++) {
+            threads.emplace_back([&]() {
+                for (int round = 0; round < 50; round++) {
+                    auto schema = converter::JSONToSchema(firstJson, options);
+                    if (!schema.ok() ||
+                        schema.ValueOrDie()->field(0)->type() != canonical) {
+                        failures++;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(failures.load(), 0);
+        auto sessionSchema = session.JSONToSchema(firstJson).ValueOrDie();
+        ASSERT_EQ(sessionSchema->field(0)->type(), canonical);
+
+        auto stats = interner.Stats();
+        ASSERT_GT(stats.hits, stats.misses);
+    }
+
+    // nothing holds the interned types anymore
+    ASSERT_GT(interner.Purge(), 0u);
+    ASSERT_EQ(interner.Stats().size, 0u);
+}
+
+/**
+ * Decode cache: the same text is decoded once, any other byte sequence is a
+ * different entry, errors are not cached and the cache stays within capacity
+ */
+TEST(SchemaJSON, DecodeCache) {
+    converter::SchemaDecodeCache cache{ 4, 2 };
+    auto testData = helper::GetTestData();
+    auto schema = testData["primitives"];
+    auto text = converter::SchemaToJSONString(schema).ValueOrDie();
+
+    auto first = cache.JSONTextToSchema(text);
+    auto second = cache.JSONTextToSchema(std::string{ text });
+    ASSERT_TRUE(first.ok() && second.ok());
+    ASSERT_TRUE(first.ValueOrDie()->Equals(*schema, true));
+    ASSERT_EQ(first.ValueOrDie(), second.ValueOrDie());
+
+    // same schema, different bytes
+    auto pretty = converter::SchemaToJSON(schema).ValueOrDie().dump(2);
+    auto third = cache.JSONTextToSchema(pretty);
+    ASSERT_TRUE(third.ok());
+    ASSERT_NE(third.ValueOrDie(), first.ValueOrDie());
+    ASSERT_TRUE(third.ValueOrDie()->Equals(*schema, true));
+
+    auto malformed = text.substr(0, text.size() / 2);
+    ASSERT_FALSE(cache.JSONTextToSchema(malformed).ok());
+    ASSERT_FALSE(cache.JSONTextToSchema(malformed).ok());
+
+    auto stats = cache.Stats();
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.misses, 4u);
+    ASSERT_EQ(stats.size, 2u);
+    ASSERT_DOUBLE_EQ(stats.HitRate(), 0.2);
+
+    for (const auto& data : testData) {
+        auto dataText = converter::SchemaToJSONString(data.second);
+        ASSERT_TRUE(cache.JSONTextToSchema(dataText.ValueOrDie()).ok());
+    }
+    stats = cache.Stats();
+    ASSERT_LE(stats.size, 4u);
+    ASSERT_GT(stats.evictions, 0u);
+
+    // concurrent lookups of the same texts
+    std::vector<std::string> texts{};
+    for (const auto& data : testData) {
+        auto dataText = converter::SchemaToJSONString(data.second);
+        texts.push_back(dataText.ValueOrDie());
+    }
+    converter::SchemaDecodeCache shared{};
+    std::vector<std::thread> threads{};
+    std::atomic<int> failures{ 0 };
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&]() {
+            for (int round = 0; round < 100; round++) {
+                for (const auto& data : texts) {
+                    if (!shared.JSONTextToSchema(data).ok()) {
+                        failures++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_GT(shared.Stats().HitRate(), 0.9);
+
+    cache.Clear();
+    ASSERT_EQ(cache.Stats().size, 0u);
+}
+
+/**
+ * LazySchema converts only the fields accessed, each once even when first
+ * touched from several threads, and builds the same schema as JSONToSchema
+ */
+TEST(SchemaJSON, LazySchema) {
+    auto fields = helper::MakeWideSchema(5000)->fields();
+    fields.push_back(arrow::field("column_7", arrow::int8()));
+    auto schema = arrow::schema(
+        fields, arrow::key_value_metadata({ "k" }, { "v" }));
+    auto jsonObj = std::make_shared<const json>(
+        converter::SchemaToJSON(schema).ValueOrDie());
+
+    auto result = converter::JSONToLazySchema(jsonObj);
+    ASSERT_TRUE(result.ok());
+    auto lazySchema = result.ValueOrDie();
+    ASSERT_EQ(lazySchema->NumFields(), schema->num_fields());
+    ASSERT_EQ(lazySchema->FieldName(42), "column_42");
+    ASSERT_EQ(lazySchema->GetFieldIndex("column_4999"), 4999);
+    ASSERT_EQ(lazySchema->GetFieldIndex("column_7"), -1); // ambiguous
+    ASSERT_EQ(lazySchema->GetFieldIndex("missing"), -1);
+    ASSERT_EQ(lazySchema->NumMaterialized(), 0);
+
+    auto first = lazySchema->GetFieldByName("column_3");
+    auto second = lazySchema->GetFieldByName("column_4");
+    auto third = lazySchema->Field(4999);
+    ASSERT_TRUE(first.ok() && second.ok() && third.ok());
+    ASSERT_TRUE(first.ValueOrDie()->Equals(schema->field(3), true));
+    ASSERT_TRUE(second.ValueOrDie()->Equals(schema->field(4), true));
+    ASSERT_TRUE(third.ValueOrDie()->Equals(schema->field(4999), true));
+    ASSERT_EQ(lazySchema->Field(3).ValueOrDie(), first.ValueOrDie());
+    ASSERT_EQ(lazySchema->NumMaterialized(), 3);
+    ASSERT_FALSE(lazySchema->GetFieldByName("column_7").ok());
+    ASSERT_FALSE(lazySchema->Field(-1).ok());
+    ASSERT_FALSE(lazySchema->Field(lazySchema->NumFields()).ok());
+
+    // concurrent first touch
+    std::vector<std::shared_ptr<arrow::Field>> seen(fields.size());
+    std::vector<std::thread> threads{};
+    std::atomic<int> failures{ 0 };
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < lazySchema->NumFields(); i++) {
+                auto field = lazySchema->Field(i);
+                if (!field.ok()) {
+                    failures++;
+                } else if (t == 0) {
+                    seen[i] = field.ValueOrDie();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(lazySchema->NumMaterialized(), lazySchema->NumFields());
+    for (int i = 0; i < lazySchema->NumFields(); i++) {
+        ASSERT_EQ(lazySchema->Field(i).ValueOrDie(), seen[i]);
+    }
+
+    auto full = lazySchema->ToSchema();
+    ASSERT_TRUE(full.ok());
+    ASSERT_TRUE(full.ValueOrDie()->Equals(*schema, true));
+    ASSERT_EQ(lazySchema->ToSchema().ValueOrDie(), full.ValueOrDie());
+
+    // a broken field only fails itself
+    auto broken = converter::SchemaToJSON(schema).ValueOrDie();
+    broken["schema"]["fields"][1]["type"]["name"] = "bogus";
+    broken["schema"]["fields"][2].erase("type");
+    auto brokenSchema =
+        converter::JSONToLazySchema(std::make_shared<const json>(broken))
+            .ValueOrDie();
+    ASSERT_FALSE(brokenSchema->Field(1).ok());
+    ASSERT_FALSE(brokenSchema->Field(2).ok());
+    ASSERT_TRUE(brokenSchema->Field(3).ok());
+    ASSERT_FALSE(brokenSchema->ToSchema().ok());
+
+    ASSERT_FALSE(converter::JSONToLazySchema(
+                     std::make_shared<const json>(json::parse("{}")))
+                     .ok());
+}
+
+/**
+ * Projected decoding keeps the selected fields and their ancestors, and does
+ * not look into the subtrees left out
+ */
+TEST(SchemaJSON, ProjectedDecode) {
+    auto geo = arrow::struct_({ arrow::field("lat", arrow::float64()),
+                                arrow::field("lon", arrow::float64()) });
+    auto address = arrow::struct_({ arrow::field("city", arrow::utf8()),
+                                    arrow::field("zip", arrow::utf8()),
+                                    arrow::field("geo", geo) });
+    auto event = arrow::struct_(
+        { arrow::field("ts", arrow::timestamp(arrow::TimeUnit::MICRO)),
+          arrow::field("kind", arrow::utf8()) });
+    auto attribute =
+        arrow::struct_({ arrow::field("score", arrow::utf8()),
+                         arrow::field("weight", arrow::float64()) });
+    auto schema = arrow::schema(
+        { arrow::field("id", arrow::int64()),
+          arrow::field("address", address),
+          arrow::field("tags", arrow::list(arrow::utf8())),
+          arrow::field("events", arrow::list(event)),
+          arrow::field("attributes", arrow::map(arrow::utf8(), attribute)),
+          arrow::field("other", arrow::int32()) },
+        arrow::key_value_metadata({ "k" }, { "v" }));
+    auto jsonObj = converter::SchemaToJSON(schema).ValueOrDie();
+
+    auto pruned = converter::JSONToSchema(
+        jsonObj,
+        converter::ProjectionSpec{ { "id",
+                                     "address.city",
+                                     "address.geo.lat",
+                                     "tags",
+                                     "events.item.kind",
+                                     "attributes.item.score" } });
+    ASSERT_TRUE(pruned.ok());
+    auto expected = arrow::schema(
+        { arrow::field("id", arrow::int64()),
+          arrow::field(
+              "address",
+              arrow::struct_(
+                  { arrow::field("city", arrow::utf8()),
+                    arrow::field("geo",
+                                 arrow::struct_({ arrow::field(
+                                     "lat", arrow::float64()) })) })),
+          arrow::field("tags", arrow::list(arrow::utf8())),
+          arrow::field("events",
+                       arrow::list(arrow::struct_(
+                           { arrow::field("kind", arrow::utf8()) }))),
+          arrow::field("attributes",
+                       arrow::map(arrow::utf8(),
+                                  arrow::struct_({ arrow::field(
+                                      "score", arrow::utf8()) }))) },
+        schema->metadata());
+    ASSERT_TRUE(pruned.ValueOrDie()->Equals(*expected, true))
+        << pruned.ValueOrDie()->ToString();
+
+    // a whole field wins over paths into it
+    auto whole = converter::JSONToSchema(
+        jsonObj, converter::ProjectionSpec{ { "address.zip", "address" } });
+    ASSERT_TRUE(whole.ok());
+    ASSERT_EQ(whole.ValueOrDie()->num_fields(), 1);
+    ASSERT_TRUE(whole.ValueOrDie()->field(0)->Equals(schema->field(1), true));
+
+    // paths matching nothing select nothing
+    auto empty = converter::JSONToSchema(
+        jsonObj,
+        converter::ProjectionSpec{
+            { "missing", "id.x", "address.nothing", "tags.element" } });
+    ASSERT_TRUE(empty.ok());
+    ASSERT_EQ(empty.ValueOrDie()->num_fields(), 0);
+    ASSERT_TRUE(empty.ValueOrDie()->metadata()->Equals(*schema->metadata()));
+
+    ASSERT_FALSE(converter::JSONToSchema(
+                     jsonObj, converter::ProjectionSpec{ { "address..city" } })
+                     .ok());
+
+    // subtrees left out are not converted at all
+    jsonObj["schema"]["fields"][5]["type"]["name"] = "bogus";
+    ASSERT_FALSE(converter::JSONToSchema(jsonObj).ok());
+    auto skipped = converter::JSONToSchema(
+        jsonObj, converter::ProjectionSpec{ { "id" } });
+    ASSERT_TRUE(skipped.ok());
+    ASSERT_EQ(skipped.ValueOrDie()->num_fields(), 1);
+}
+
+/**
+ * Parallel decoding of wide field lists gives the same schema as the serial
+ * path, and reports the first failing field with its path
+ */
+TEST(SchemaJSON, ParallelDecodeMatchesSerial) {
+    auto schema = helper::MakeWideSchema(8000)->WithMetadata(
+        arrow::key_value_metadata({ "k" }, { "v" }));
+    auto jsonObj = converter::SchemaToJSON(schema).ValueOrDie();
+
+    auto pool = arrow::internal::ThreadPool::Make(3).ValueOrDie();
+    converter::JSONToSchemaOptions options{};
+    options.useThreads = true;
+    options.parallelThreshold = 1000;
+
+    std::vector<arrow::internal::Executor*> executors{ nullptr, pool.get() };
+    for (auto executor : executors) {
+        options.executor = executor;
+        auto decoded = converter::JSONToSchema(jsonObj, options);
+        ASSERT_TRUE(decoded.ok());
+        ASSERT_TRUE(decoded.ValueOrDie()->Equals(*schema, true));
+
+        converter::Converter session{ {}, options };
+        auto sessionDecoded = session.JSONToSchema(jsonObj);
+        ASSERT_TRUE(sessionDecoded.ok());
+        ASSERT_TRUE(sessionDecoded.ValueOrDie()->Equals(*schema, true));
+    }
+
+    // malformed fields fail with the path of the first one
+    jsonObj["schema"]["fields"][7000]["type"]["name"] = "bogus";
+    jsonObj["schema"]["fields"][4321].erase("type");
+    auto status = converter::JSONToSchema(jsonObj, options).status();
+    ASSERT_TRUE(status.IsInvalid());
+    ASSERT_EQ(status.message(), "/schema/fields/4321/type: missing");
+}
+
+/**
+ * The simdjson decoder gives the same schemas as the SAX decoder, whatever
+ * the member order, hands deep schemas over to it and fails on malformed
+ * text. Skipped if the library is built without simdjson
+ */
+TEST(SchemaJSON, SimdDecodeMatchesText) {
+    if (converter::SimdJSONTextToSchema("{}").status().IsNotImplemented()) {
+        GTEST_SKIP() << "built without SCHEMA_JSON_WITH_SIMDJSON";
+    }
+
+    std::vector<std::string> texts{};
+    for (auto testData :
+         { helper::GetTestData(), helper::GetEdgeCaseTestData() }) {
+        for (const auto& data : testData) {
+            auto text = converter::SchemaToJSONString(data.second);
+            if (text.ok()) {
+                texts.push_back(std::move(text).ValueOrDie());
+            }
+        }
+    }
+    texts.push_back(
+        converter::SchemaToJSONString(helper::MakeNestedSchema(200))
+            .ValueOrDie());
+    // children JSONToSchema does not read, before and after the type
+    texts.push_back(R"({"schema": {"fields": [{"name": "l",
+        "type": {"name": "list"}, "children": [
+            {"name": "item", "type": {"name": "utf8"}},
+            {"name": "x", "type": {"name": "bogus"}}]}]}})");
+    texts.push_back(R"({"schema": {"fields": [{"name": "l", "children": [
+        {"name": "item", "type": {"name": "utf8"}},
+        {"type": {"name": "utf8"}}, 7, [null], {},
+        {"name": "x", "type": {"name": "int", "bitWidth": 3.5},
+         "metadata": [{"key": "a", "value": "b"}]},
+        {"name": "s", "type": {"name": "struct"}, "children": [
+            {"name": "x", "type": {"name": "bogus"}}]}],
+        "type": {"name": "list"}}]}})");
+    texts.push_back(R"({"schema": {"fields": [{"name": "a", "children": [
+        {"name": "x", "type": {"name": "bogus"}}],
+        "type": {"name": "utf8"}}]}})");
+    for (auto it = texts.end() - 3; it != texts.end(); ++it) {
+        ASSERT_TRUE(converter::SimdJSONTextToSchema(*it).ok()) << *it;
+    }
+    // members in reverse order, unknown members, escapes, a map entry item
+    // first and a second map entry
+    texts.push_back(R"({"extra": [1, {"a": null}], "schema": {
+        "metadata": [{"value": "v\n", "key": "ké"}],
+        "fields": [
+            {"type": {"keySorted": true, "name": "map"}, "nullable": true,
+             "name": "m", "children": [{"item": {
+                "type": {"unit": "MICROSECOND", "timezone": "UTC",
+                         "name": "timestamp"},
+                "name": "value", "comment": {"x": [true, 2.5]}},
+              "key": {"type": {"name": "utf8"}, "name": "key"}},
+              {"key": {"name": "ignored"}}]},
+            {"type": {"name": "struct"}, "name": "s\"", "children": [
+                {"name": "a", "type": {"scale": 2, "precision": 10,
+                                       "name": "decimal"}},
+                {"type": {"name": "list"}, "name": "b", "children": [
+                    {"type": {"bitWidth": 16, "isSigned": false,
+                              "name": "int"}, "name": "item"}]}],
+             "metadata": [{"key": "a", "value": "b"}]}
+        ]}})");
+
+    for (const auto& text : texts) {
+        auto expected = converter::JSONTextToSchema(text);
+        auto decoded = converter::SimdJSONTextToSchema(text);
+        ASSERT_EQ(decoded.ok(), expected.ok()) << text.substr(0, 200);
+        if (expected.ok()) {
+            ASSERT_TRUE(
+                decoded.ValueOrDie()->Equals(*expected.ValueOrDie(), true));
+        }
+    }
+
+    // interned types are shared with the other decoders
+    converter::TypeInterner interner{};
+    converter::JSONToSchemaOptions options{};
+    options.interner = &interner;
+    auto expected =
+        converter::JSONTextToSchema(texts.back(), options).ValueOrDie();
+    auto decoded =
+        converter::SimdJSONTextToSchema(texts.back(), options).ValueOrDie();
+    ASSERT_EQ(decoded->field(0)->type(), expected->field(0)->type());
+
+    const std::string malformed[] = {
+        "",
+        "null",
+        R"({"schema": {"fields": [)",
+        R"({"schema": {"fields": []}} {})",
+        R"({"schema": {"metadata": []}})",
+        R"({"schema": {"fields": [{"type": {"name": "utf8"}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "type": {"name": "x"}}]}})",
+        R"({"schema": {"fields": [{"name": "a",
+            "type": {"name": "int", "bitWidth": "8", "isSigned": true}}]}})",
+        R"({"schema": {"fields": [{"name": "a",
+            "type": {"name": "int", "bitWidth": 8}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "type": {"name": "list"}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "children": [{"key": {
+            "name": "k", "type": {"name": "utf8"}}}],
+            "type": {"name": "map", "keySorted": false}}]}})",
+        R"({"schema": {"fields": [{"name": "a", "children": [{}],
+            "type": {"name": "struct"}}]}})",
+        R"({"schema": {"fields": [], "metadata": [{"key": "k"}]}})",
+        R"({"schema": {"fields": [{"name": "l", "children": [
+            {"name": "s", "type": {"name": "struct"}, "children": [
+                {"name": "x", "type": {"name": "bogus"}}]}],
+            "type": {"name": "list"}}]}})",
+        R"({"schema": {"fields": [{"name": "s", "children": [
+            {"name": "a", "type": {"name": "utf8"}}, 7],
+            "type": {"name": "struct"}}]}})",
+    };
+    for (const auto& text : malformed) {
+        ASSERT_FALSE(converter::JSONTextToSchema(text).ok()) << text;
+        ASSERT_FALSE(converter::SimdJSONTextToSchema(text).ok()) << text;
+    }
+
+    // integer parameters fail as they do with JSONTextToSchema, not truncated
+    const std::string inexact[] = {
+        R"({"name": "int", "bitWidth": 16.0, "isSigned": false})",
+        R"({"name": "decimal", "precision": 1e300, "scale": 2})",
+        R"({"name": "decimal", "precision": 100000000000000000000,)"
+        R"( "scale": 2})",
+        R"({"name": "int", "bitWidth": 4294967328, "isSigned": true})",
+        R"({"name": "int", "bitWidth": -4294967264, "isSigned": true})",
+        R"({"name": "fixedsizebinary", "byteWidth": 18446744073709551615})",
+    };
+    for (const auto& type : inexact) {
+        auto text =
+            R"({"schema": {"fields": [{"name": "a", "type": )" + type + "}]}}";
+        auto expected = converter::JSONTextToSchema(text).status();
+        ASSERT_TRUE(expected.IsInvalid()) << text;
+        ASSERT_EQ(converter::SimdJSONTextToSchema(text).status(), expected)
+            << text;
+    }
+}
+
+/**
+ * SchemaToJSONFile writes the same text as SchemaToJSONString, and
+ * JSONFileToSchema decodes it like JSONTextToSchema. Missing and empty
+ * files are reported, not thrown
+ */
+TEST(SchemaJSON, FileRoundTrip) {
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("schema_json_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    auto path = (directory / "schema.json").string();
+
+    for (const auto& data : helper::GetTestData()) {
+        auto schema = data.second;
+        ASSERT_TRUE(converter::SchemaToJSONFile(schema, path).ok());
+
+        std::ifstream file{ path, std::ios::binary };
+        std::string written{ std::istreambuf_iterator<char>{ file }, {} };
+        ASSERT_EQ(written, converter::SchemaToJSONString(schema).ValueOrDie());
+
+        auto expected = converter::JSONTextToSchema(written);
+        auto decoded = converter::JSONFileToSchema(path);
+        ASSERT_TRUE(decoded.ok()) << decoded.status().ToString();
+        ASSERT_TRUE(
+            decoded.ValueOrDie()->Equals(*expected.ValueOrDie(), true));
+    }
+
+    // wide enough to be mapped instead of read
+    auto wide = helper::MakeWideSchema(5000);
+    ASSERT_TRUE(converter::SchemaToJSONFile(wide, path).ok());
+    ASSERT_GT(std::filesystem::file_size(path), 64u * 1024);
+    ASSERT_TRUE(converter::JSONFileToSchema(path).ValueOrDie()->Equals(*wide));
+
+    // truncated when rewritten
+    auto narrow = arrow::schema({ arrow::field("a", arrow::int8()) });
+    ASSERT_TRUE(converter::SchemaToJSONFile(narrow, path).ok());
+    ASSERT_TRUE(
+        converter::JSONFileToSchema(path).ValueOrDie()->Equals(*narrow));
+
+    std::ofstream{ path, std::ios::trunc };
+    ASSERT_TRUE(converter::JSONFileToSchema(path).status().IsInvalid());
+
+    auto missing = (directory / "missing.json").string();
+    ASSERT_TRUE(converter::JSONFileToSchema(missing).status().IsIOError());
+    auto unwritable = (directory / "missing" / "schema.json").string();
+    ASSERT_TRUE(
+        converter::SchemaToJSONFile(narrow, unwritable).IsIOError());
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * SchemaStreamReader returns the schemas of a newline-delimited stream in
+ * order, serially or decoded in parallel, whatever the block size. Blank
+ * lines are skipped and a malformed line is reported without ending the
+ * stream
+ */
+TEST(SchemaJSON, StreamReader) {
+    std::vector<std::string> lines{};
+    for (auto testData :
+         { helper::GetTestData(), helper::GetEdgeCaseTestData() }) {
+        for (const auto& data : testData) {
+            auto text = converter::SchemaToJSONString(data.second);
+            if (text.ok() && converter::JSONTextToSchema(*text).ok()) {
+                lines.push_back(std::move(text).ValueOrDie());
+            }
+        }
+    }
+    lines.push_back(R"({"schema": {"fields": [{"name": "a"}]}})");
+    lines.push_back("");
+    lines.push_back("  \r");
+    lines.push_back(lines.front() + "\r");
+    std::string stream{};
+    for (const auto& line : lines) {
+        stream += line + "\n";
+    }
+    // the last line has no newline
+    stream += lines.front();
+    lines.push_back(lines.front());
+
+    auto check = [&](const converter::StreamReaderOptions& options) {
+        converter::SchemaStreamReader reader{
+            std::make_shared<arrow::io::BufferReader>(
+                arrow::Buffer::FromString(stream)),
+            options
+        };
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (lines[i].find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            auto expected = converter::JSONTextToSchema(lines[i]);
+            auto decoded = reader.Next();
+            ASSERT_EQ(reader.LineNumber(), static_cast<int64_t>(i + 1));
+            ASSERT_EQ(decoded.ok(), expected.ok()) << i;
+            if (expected.ok()) {
+                ASSERT_TRUE(decoded.ValueOrDie()->Equals(
+                    *expected.ValueOrDie(), true));
+            } else {
+                ASSERT_TRUE(decoded.status().IsInvalid());
+                ASSERT_EQ(decoded.status().message().rfind(
+                              "line " + std::to_string(i + 1) + ": ", 0),
+                          0u);
+            }
+        }
+        for (int i = 0; i < 2; i++) {
+            auto end = reader.Next();
+            ASSERT_TRUE(end.ok());
+            ASSERT_EQ(end.ValueOrDie(), nullptr);
+        }
+    };
+
+    converter::StreamReaderOptions options{};
+    check(options);
+    options.blockSize = 7;
+    check(options);
+    options.useThreads = true;
+    options.batchSize = 3;
+    check(options);
+    options.blockSize = 1 << 20;
+    options.batchSize = 1024;
+    check(options);
+
+    auto path = (std::filesystem::temp_directory_path() /
+                 ("schema_json_" + std::to_string(::getpid()) + ".ndjson"))
+                    .string();
+    std::ofstream{ path } << stream;
+    auto fileReader = converter::SchemaStreamReader::Open(path);
+    ASSERT_TRUE(fileReader.ok());
+    auto first = fileReader.ValueOrDie()->Next();
+    ASSERT_TRUE(first.ok());
+    ASSERT_TRUE(first.ValueOrDie()->Equals(
+        *converter::JSONTextToSchema(lines.front()).ValueOrDie()));
+    std::filesystem::remove(path);
+
+    auto missing = converter::SchemaStreamReader::Open("/nonexistent/x.json");
+    ASSERT_TRUE(missing.status().IsIOError());
+
+    // a closed stream fails its reads with Invalid, the reader reports it as
+    // IOError: Invalid only ever stands for a malformed line
+    auto closed = std::make_shared<arrow::io::BufferReader>(
+        arrow::Buffer::FromString(lines.front()));
+    ASSERT_TRUE(closed->Close().ok());
+    converter::SchemaStreamReader closedReader{ closed };
+    ASSERT_TRUE(closedReader.Next().status().IsIOError());
+    ASSERT_TRUE(closedReader.Next().status().IsIOError());
+}
+
+/**
+ * SchemaPushDecoder decodes a document fed in chunks of any size like
+ * JSONTextToSchema decodes it whole, converting fields before the end of the
+ * text, and is reusable once finished
+ */
+TEST(SchemaJSON, PushDecoder) {
+    auto pushDecode = [](converter::SchemaPushDecoder& decoder,
+                         std::string_view text,
+                         size_t chunkSize) {
+        arrow::Status status{};
+        for (size_t i = 0; i < text.size() && status.ok(); i += chunkSize) {
+            status = decoder.Feed(text.substr(i, chunkSize));
+        }
+        auto result = decoder.Finish();
+        if (!status.ok()) {
+            // a failed chunk is reported by Finish too
+            EXPECT_EQ(result.status().ToString(), status.ToString());
+        }
+        return result;
+    };
+
+    std::vector<std::string> texts{};
+    for (auto testData :
+         { helper::GetTestData(), helper::GetEdgeCaseTestData() }) {
+        for (const auto& data : testData) {
+            auto text = converter::SchemaToJSONString(data.second);
+            if (text.ok()) {
+                texts.push_back(std::move(text).ValueOrDie());
+            }
+        }
+    }
+    texts.insert(
+        texts.end(),
+        {
+            R"({"schema": {"fields": [{"name": "café",)"
+            R"( "type": {"name": "int", "bitWidth": 32, "isSigned": true},)"
+            R"( "nullable": true, "children": []}]}})",
+            R"({"schema": {"fields": [{"name": "😀 é\"\\\/",)"
+            R"( "type": {"name": "bool"}, "nullable": false,)"
+            R"( "children": []}]}})",
+            "{\"schema\": {\"fields\": [{\"name\": "
+            "\"\xc3\xa9\xf0\x9f\x98\x80\","
+            " \"type\": {\"name\": \"utf8\"}, \"nullable\": true,"
+            " \"children\": []}]}}",
+            R"({"schema": {"fields": [{"name": "a", "type": {"name": "int",)"
+            R"( "bitWidth": 32, "isSigned": true}, "nullable": true,)"
+            R"( "children": []}]}}  )",
+            "",
+            "   ",
+            "{",
+            R"({"schema": {"fields": []}})",
+            R"({"schema": {"fields": [],}})",
+            R"({"schema": {"fields": []}} {})",
+            R"({"schema": {"fields": [{"name": "a", "type": {"name": "int",)"
+            R"( "bitWidth": 3.2e1, "isSigned": true}, "nullable": true,)"
+            R"( "children": []}]}})",
+            R"({"schema": {"fields": [{"name": "a", "type": {"name": "int",)"
+            R"( "bitWidth": 032, "isSigned": true}, "nullable": true,)"
+            R"( "children": []}]}})",
+            R"({"schema": {"fields": [{"name": "a", "type": {"name": "int",)"
+            R"( "bitWidth": 99999999999999999999, "isSigned": tru}}]}})",
+            R"({"schema": {"fields": [{"name": "\ud83d"}]}})",
+            R"({"schema": {"fields": [{"name": "\x41"}]}})",
+            "{\"schema\": {\"fields\": [{\"name\": \"\xc3\x28\"}]}}",
+            "{\"schema\": {\"fields\": [{\"name\": \"\xed\xa0\x80\"}]}}",
+            "{\"schema\": {\"fields\": [{\"name\": \"a\tb\"}]}}",
+            R"({"schema": {"fields": [{"name": "a"} {"name": "b"}]}})",
+            R"({"schema" {"fields": []}})",
+            R"({"schema": {"fields": [}})",
+            "[1, -2, 3.5, true, false, null, \"x\"]",
+            // a leading byte order mark is skipped, nowhere else
+            "\xef\xbb\xbf{\"schema\": {\"fields\": []}}",
+            "\xef\xbb\xbf",
+            "\xef\xbb{\"schema\": {\"fields\": []}}",
+            " \xef\xbb\xbf{\"schema\": {\"fields\": []}}",
+            "\xef\xbb\xbf\xef\xbb\xbf{\"schema\": {\"fields\": []}}",
+        });
+
+    converter::SchemaPushDecoder decoder{};
+    for (const auto& text : texts) {
+        auto expected = converter::JSONTextToSchema(text);
+        for (size_t chunkSize : { size_t{ 1 }, size_t{ 7 }, text.size() + 1 }) {
+            auto decoded = pushDecode(decoder, text, chunkSize);
+            ASSERT_EQ(decoded.ok(), expected.ok()) << text << " " << chunkSize;
+            if (expected.ok()) {
+                ASSERT_TRUE(
+                    decoded.ValueOrDie()->Equals(*expected.ValueOrDie(), true));
+            } else {
+                ASSERT_TRUE(decoded.status().IsInvalid());
+            }
+        }
+    }
+
+    // fields are converted while the document is still incomplete
+    auto text = converter::SchemaToJSONString(
+                    helper::GetTestData().begin()->second)
+                    .ValueOrDie();
+    auto fieldsEnd = text.rfind(']');
+    ASSERT_TRUE(decoder.Feed(std::string_view{ text }.substr(0, fieldsEnd))
+                    .ok());
+    ASSERT_EQ(decoder.NumFields(),
+              helper::GetTestData().begin()->second->num_fields());
+    decoder.Reset();
+    ASSERT_EQ(decoder.NumFields(), 0);
+
+    // errors stick until the decoder is finished
+    ASSERT_TRUE(decoder.Feed("{]").IsInvalid());
+    ASSERT_TRUE(decoder.Feed("}").IsInvalid());
+    ASSERT_TRUE(decoder.Finish().status().IsInvalid());
+    auto again = pushDecode(decoder, text, 5);
+    ASSERT_TRUE(again.ok());
+}
+
+/**
+ * Malformed documents are reported as Invalid naming the JSON pointer of the
+ * offending value, the same way by every DOM decoding entry point, without
+ * throwing
+ */
+TEST(SchemaJSON, DecodeErrorsNamePath) {
+    auto document = [](const std::string& fields) {
+        return json::parse(R"({"schema": {"fields": [)" + fields + "]}}");
+    };
+    const std::string intType =
+        R"({"name": "int", "bitWidth": 32, "isSigned": true})";
+    const std::string child =
+        R"({"name": "c", "type": )" + intType + R"(, "nullable": true,)"
+        R"( "children": []})";
+
+    std::vector<std::pair<json, std::string>> cases{
+        { json(1), "expected an object" },
+        { json::object(), "/schema: missing" },
+        { json::parse(R"({"schema": {"fields": {}}})"),
+          "/schema/fields: expected an array" },
+        { json::parse(R"({"schema": {"fields": [], "metadata": "x"}})"),
+          "/schema/metadata: expected an array" },
+        { document("1"), "/schema/fields/0: expected an object" },
+        { document(R"({"name": "a"})"), "/schema/fields/0/type: missing" },
+        { document(R"({"name": "a", "type": {"name": "int",)"
+                   R"( "bitWidth": "32", "isSigned": true}})"),
+          "/schema/fields/0/type/bitWidth: expected an integer" },
+        { document(R"({"name": "a", "type": {"name": "int",)"
+                   R"( "bitWidth": 7, "isSigned": true}})"),
+          "/schema/fields/0: unsupported bit width" },
+        { document(R"({"name": 1, "type": )" + intType + "}"),
+          "/schema/fields/0/name: expected a string" },
+        { document(child + R"(, {"name": "s", "type": {"name": "struct"},)"
+                           R"( "children": [)" +
+                   child + R"(, {"name": "d", "type": {"name": 5}}]})"),
+          "/schema/fields/1/children/1/type/name: expected a string" },
+        { document(R"({"name": "l", "type": {"name": "list"},)"
+                   R"( "children": []})"),
+          "/schema/fields/0/children: list has no element field" },
+        { document(R"({"name": "m", "type": {"name": "map",)"
+                   R"( "keySorted": false}, "children": [{"key": )" +
+                   child + "}]}"),
+          "/schema/fields/0/children/0/item: missing" },
+        { document(R"({"name": "m", "type": {"name": "map",)"
+                   R"( "keySorted": false}, "children": [{"key": {)"
+                   R"("name": "k", "type": {"name": "utf8"},)"
+                   R"( "metadata": [{"key": "a"}]}, "item": )" +
+                   child + "}]}"),
+          "/schema/fields/0/children/0/key/metadata/0/value: missing" },
+    };
+
+    converter::JSONToSchemaOptions parallel{};
+    parallel.useThreads = true;
+    parallel.parallelThreshold = 1;
+    for (const auto& [jsonObj, message] : cases) {
+        auto decoded = converter::JSONToSchema(jsonObj);
+        ASSERT_TRUE(decoded.status().IsInvalid()) << message;
+        ASSERT_EQ(decoded.status().message(), message);
+        ASSERT_EQ(converter::JSONToSchema(jsonObj, parallel).status(),
+                  decoded.status());
+        ASSERT_EQ(converter::JSONToSchemaBatch({ &jsonObj })[0].status(),
+                  decoded.status());
+    }
+}
+
+/**
+ * Integer type parameters are read exactly: floats and integers which do not
+ * fit are rejected by the DOM and the text decoders alike, as are parameters
+ * arrow cannot build a type from
+ */
+TEST(SchemaJSON, DecodeRejectsInexactParams) {
+    auto document = [](const std::string& type) {
+        return R"({"schema": {"fields": [{"name": "a", "type": )" + type +
+               "}]}}";
+    };
+    const std::vector<std::pair<std::string, std::string>> cases{
+        { R"({"name": "int", "bitWidth": 32.5, "isSigned": true})",
+          "/schema/fields/0/type/bitWidth: expected an integer" },
+        { R"({"name": "int", "bitWidth": 32.0, "isSigned": true})",
+          "/schema/fields/0/type/bitWidth: expected an integer" },
+        { R"({"name": "decimal", "precision": 1e300, "scale": 2})",
+          "/schema/fields/0/type/precision: expected an integer" },
+        { R"({"name": "int", "bitWidth": 4294967328, "isSigned": true})",
+          "/schema/fields/0/type/bitWidth: integer out of range" },
+        { R"({"name": "int", "bitWidth": -4294967264, "isSigned": true})",
+          "/schema/fields/0/type/bitWidth: integer out of range" },
+        { R"({"name": "fixedsizebinary",)"
+          R"( "byteWidth": 18446744073709551615})",
+          "/schema/fields/0/type/byteWidth: integer out of range" },
+        // arrow aborts on these rather than failing
+        { R"({"name": "decimal", "precision": 0, "scale": 0})",
+          "/schema/fields/0: unsupported precision" },
+        { R"({"name": "decimal", "precision": 77, "scale": 2})",
+          "/schema/fields/0: unsupported precision" },
+        { R"({"name": "fixedsizebinary", "byteWidth": -1})",
+          "/schema/fields/0: unsupported byte width" },
+    };
+    for (const auto& [type, message] : cases) {
+        auto text = document(type);
+        auto decoded = converter::JSONToSchema(json::parse(text));
+        ASSERT_TRUE(decoded.status().IsInvalid()) << text;
+        ASSERT_EQ(decoded.status().message(), message);
+
+        // the text decoder names no path, only the offending member
+        auto textDecoded = converter::JSONTextToSchema(text);
+        ASSERT_TRUE(textDecoded.status().IsInvalid()) << text;
+        const auto& textMessage = textDecoded.status().message();
+        ASSERT_FALSE(textMessage.empty());
+        ASSERT_EQ(message.substr(message.size() -
+                                 std::min(message.size(), textMessage.size())),
+                  textMessage);
+    }
+
+    // numbers of unknown members are ignored, whatever they are
+    auto text = document(R"({"name": "utf8", "extra": [1.5, 1e300, -1]})");
+    ASSERT_TRUE(converter::JSONToSchema(json::parse(text)).ok());
+    ASSERT_TRUE(converter::JSONTextToSchema(text).ok());
+}
+
+/**
+ * ValidateSchemaJSON accepts exactly the documents JSONToSchema accepts and
+ * fails with the same first error, or reports every error when asked to
+ */
+TEST(SchemaJSON, ValidateMatchesDecode) {
+    std::vector<json> documents{};
+    for (auto testData :
+         { helper::GetTestData(), helper::GetEdgeCaseTestData() }) {
+        for (const auto& data : testData) {
+            auto jsonObj = converter::SchemaToJSON(data.second);
+            if (jsonObj.ok()) {
+                documents.push_back(std::move(jsonObj).ValueOrDie());
+            }
+        }
+    }
+    // break the last field of every document in a few ways
+    size_t numDocuments = documents.size();
+    for (size_t i = 0; i < numDocuments; i++) {
+        auto& fields = documents[i]["schema"]["fields"];
+        if (!fields.is_array() || fields.empty()) {
+            continue;
+        }
+        std::vector<json> broken(8, documents[i]);
+        broken[0]["schema"]["fields"].back().erase("name");
+        broken[1]["schema"]["fields"].back()["type"]["name"] = "bogus";
+        broken[2]["schema"]["fields"].back()["metadata"] = { { "key", 1 } };
+        broken[3]["schema"]["fields"].back()["type"] = {
+            { "name", "decimal" }, { "precision", 100 }, { "scale", 2 }
+        };
+        broken[4]["schema"]["fields"].back()["type"] = {
+            { "name", "time" }, { "bitWidth", 32 }, { "unit", "NANOSECOND" }
+        };
+        broken[5]["schema"]["fields"].back()["type"] = {
+            { "name", "int" }, { "bitWidth", 32.5 }, { "isSigned", true }
+        };
+        broken[6]["schema"]["fields"].back()["type"] = {
+            { "name", "int" }, { "bitWidth", 4294967328 }, { "isSigned", true }
+        };
+        // a list element JSONToSchema does not read
+        broken[7]["schema"]["fields"].back() = json::parse(R"({
+            "name": "l", "type": {"name": "list"}, "children": [
+                {"name": "item", "type": {"name": "utf8"}},
+                {"name": "x", "type": {"name": "bogus"}}]})");
+        documents.insert(documents.end(), broken.begin(), broken.end());
+    }
+
+    for (const auto& document : documents) {
+        auto expected = converter::JSONToSchema(document).status();
+        ASSERT_EQ(converter::ValidateSchemaJSON(document), expected)
+            << document.dump();
+        ASSERT_EQ(converter::ValidateSchemaJSONText(document.dump()),
+                  expected);
+        std::vector<arrow::Status> errors{};
+        ASSERT_EQ(converter::ValidateSchemaJSON(document, &errors), expected);
+        ASSERT_EQ(errors.empty(), expected.ok());
+        if (!errors.empty()) {
+            ASSERT_EQ(errors.front(), expected);
+        }
+    }
+
+    // the text check follows JSONToSchema on list elements it does not read
+    const std::string unread = R"({"schema": {"fields": [{"name": "l",
+        "type": {"name": "list"}, "children": [
+            {"name": "item", "type": {"name": "utf8"}},
+            {"name": "x", "type": {"name": "bogus"}}]}]}})";
+    ASSERT_TRUE(converter::JSONToSchema(json::parse(unread)).ok());
+    ASSERT_TRUE(converter::ValidateSchemaJSONText(unread).ok());
+
+    // every error, in decoding order
+    auto jsonObj = converter::SchemaToJSON(
+                       arrow::schema({ arrow::field("a", arrow::int32()),
+                                       arrow::field("b", arrow::utf8()),
+                                       arrow::field("c", arrow::list(
+                                                             arrow::int8())) }))
+                       .ValueOrDie();
+    jsonObj["schema"]["fields"][0]["type"]["bitWidth"] = 12;
+    jsonObj["schema"]["fields"][2]["children"][0]["type"].erase("isSigned");
+    jsonObj["schema"]["fields"][2]["name"] = 3;
+    jsonObj["schema"]["metadata"] = { { { "value", "v" } } };
+    std::vector<arrow::Status> errors{};
+    auto status = converter::ValidateSchemaJSON(jsonObj, &errors);
+    std::vector<std::string> messages{};
+    for (const auto& error : errors) {
+        ASSERT_TRUE(error.IsInvalid());
+        messages.push_back(error.message());
+    }
+    ASSERT_EQ(messages,
+              (std::vector<std::string>{
+                  "/schema/fields/0: unsupported bit width",
+                  "/schema/fields/2/children/0/type/isSigned: missing",
+                  "/schema/fields/2/name: expected a string",
+                  "/schema/metadata/0/key: missing" }));
+    ASSERT_EQ(status, errors.front());
+    ASSERT_EQ(converter::JSONToSchema(jsonObj).status(), status);
+
+    errors.clear();
+    status = converter::ValidateSchemaJSONText("{\"schema\": [", &errors);
+    ASSERT_TRUE(status.IsInvalid());
+    ASSERT_NE(status.message().find("parse error"), std::string::npos);
+    ASSERT_EQ(errors.size(), 1u);
+}
+
+/**
+ * Fields decoded through a SchemaIndex match the full decoding, whether the
+ * index is fresh or read back from its serialized form, and projections give
+ * the schema JSONToSchema gives
+ */
+TEST(SchemaJSON, SchemaIndex) {
+    converter::SchemaIndexOptions all{};
+    all.nestedDepth = -1;
+    for (const auto& data : helper::GetTestData()) {
+        auto jsonObj = converter::SchemaToJSON(data.second).ValueOrDie();
+        for (const auto& text : { jsonObj.dump(), jsonObj.dump(4) }) {
+            auto schema = converter::JSONTextToSchema(text).ValueOrDie();
+            auto built = converter::BuildSchemaIndex(text, all);
+            ASSERT_TRUE(built.ok()) << built.status().ToString();
+            auto index = converter::SchemaIndex::Deserialize(
+                             built.ValueOrDie().Serialize())
+                             .ValueOrDie();
+            ASSERT_EQ(index.TextSize(), text.size());
+
+            // the arrow::Field an entry stands for, walking down from the
+            // top-level field
+            const auto& entries = index.Entries();
+            std::function<std::shared_ptr<arrow::Field>(int64_t)> fieldOf =
+                [&](int64_t i) {
+                    const auto& entry = entries[i];
+                    if (entry.parent < 0) {
+                        return schema->field(static_cast<int>(entry.position));
+                    }
+                    auto parent = fieldOf(entry.parent);
+                    if (parent->type()->id() == arrow::Type::MAP) {
+                        auto map = std::static_pointer_cast<arrow::MapType>(
+                            parent->type());
+                        auto name = entry.path.substr(entry.path.rfind('.'));
+                        return name == ".key" ? map->key_field()
+                                              : map->item_field();
+                    }
+                    return parent->type()->field(
+                        static_cast<int>(entry.position));
+                };
+            int numTopLevel = 0;
+            for (size_t i = 0; i < entries.size(); i++) {
+                numTopLevel += entries[i].parent < 0;
+                ASSERT_LT(entries[i].parent, static_cast<int64_t>(i));
+                if (entries[i].parent < 0) {
+                    ASSERT_EQ(entries[i].path, fieldOf(i)->name());
+                } else {
+                    const auto& parent = entries[entries[i].parent].path;
+                    ASSERT_EQ(entries[i].path.substr(0, parent.size() + 1),
+                              parent + ".");
+                }
+                auto field = converter::JSONTextToField(
+                    text, index, entries[i].path);
+                ASSERT_TRUE(field.ok()) << field.status().ToString();
+                if (index.Find(entries[i].path) != static_cast<int>(i)) {
+                    continue;
+                }
+                // arrow makes the key of a map non-nullable whatever its
+                // json says
+                const auto& decoded = field.ValueOrDie();
+                ASSERT_EQ(decoded->name(), fieldOf(i)->name());
+                ASSERT_TRUE(decoded->type()->Equals(fieldOf(i)->type(), true))
+                    << entries[i].path;
+                if (entries[i].parent < 0) {
+                    ASSERT_TRUE(decoded->Equals(fieldOf(i), true));
+                }
+            }
+            ASSERT_EQ(numTopLevel, schema->num_fields());
+        }
+    }
+
+    auto geo = arrow::struct_({ arrow::field("lat", arrow::float64()),
+                                arrow::field("lon", arrow::float64()) });
+    auto address = arrow::struct_({ arrow::field("city", arrow::utf8()),
+                                    arrow::field("geo", geo) });
+    auto attribute =
+        arrow::struct_({ arrow::field("score", arrow::utf8()),
+                         arrow::field("weight", arrow::float64()) });
+    auto schema = arrow::schema(
+        { arrow::field("id", arrow::int64()),
+          arrow::field("address", address),
+          arrow::field("attributes", arrow::map(arrow::utf8(), attribute)),
+          arrow::field("say \"hi\"", arrow::utf8()),
+          arrow::field("other", arrow::int32()) },
+        arrow::key_value_metadata({ "k" }, { "v" }));
+    auto jsonObj = converter::SchemaToJSON(schema).ValueOrDie();
+    auto text = jsonObj.dump(2);
+
+    // top-level fields only by default
+    auto index = converter::BuildSchemaIndex(text).ValueOrDie();
+    ASSERT_EQ(index.Entries().size(), 5u);
+    ASSERT_EQ(index.Find("say \"hi\""), 3);
+    ASSERT_EQ(index.Find("address.city"), -1);
+    ASSERT_TRUE(converter::JSONTextToField(text, index, "address.city")
+                    .status()
+                    .IsKeyError());
+
+    converter::SchemaIndexOptions one{};
+    one.nestedDepth = 1;
+    index = converter::BuildSchemaIndex(text, one).ValueOrDie();
+    ASSERT_NE(index.Find("address.geo"), -1);
+    ASSERT_EQ(index.Find("address.geo.lat"), -1);
+    ASSERT_TRUE(converter::JSONTextToField(text, index, "attributes.item")
+                    .ValueOrDie()
+                    ->type()
+                    ->Equals(attribute));
+
+    for (const auto& paths : std::vector<std::vector<std::string>>{
+             { "id" },
+             { "other", "address.geo.lat", "attributes.item.score" },
+             { "missing" },
+             {} }) {
+        converter::ProjectionSpec projection{ paths };
+        auto expected = converter::JSONToSchema(jsonObj, projection);
+        auto decoded = converter::JSONTextToSchema(text, index, projection);
+        ASSERT_TRUE(decoded.ok()) << decoded.status().ToString();
+        ASSERT_TRUE(
+            decoded.ValueOrDie()->Equals(*expected.ValueOrDie(), true));
+    }
+
+    // fields sharing a name are all selected, in schema order
+    auto twice = converter::SchemaToJSON(
+                     arrow::schema({ arrow::field("x", arrow::int8()),
+                                     arrow::field("y", arrow::int8()),
+                                     arrow::field("x", arrow::utf8()) }))
+                     .ValueOrDie();
+    auto twiceText = twice.dump();
+    auto twiceIndex = converter::BuildSchemaIndex(twiceText).ValueOrDie();
+    ASSERT_EQ(twiceIndex.FindAll("x"), (std::vector<int>{ 0, 2 }));
+    auto both = converter::JSONTextToSchema(
+        twiceText, twiceIndex, converter::ProjectionSpec{ { "x" } });
+    ASSERT_TRUE(both.ok());
+    ASSERT_TRUE(both.ValueOrDie()->Equals(
+        *converter::JSONToSchema(twice, converter::ProjectionSpec{ { "x" } })
+             .ValueOrDie()));
+
+    // persisted next to the text
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("schema_json_index_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    auto path = (directory / "schema.json.idx").string();
+    ASSERT_TRUE(converter::WriteSchemaIndex(index, path).ok());
+    auto read = converter::ReadSchemaIndex(path);
+    ASSERT_TRUE(read.ok()) << read.status().ToString();
+    ASSERT_EQ(read.ValueOrDie().Serialize(), index.Serialize());
+    ASSERT_TRUE(
+        converter::ReadSchemaIndex((directory / "missing.idx").string())
+            .status()
+            .IsIOError());
+    std::filesystem::remove_all(directory);
+
+    // stale or damaged indexes are rejected
+    ASSERT_TRUE(converter::JSONTextToField(text + " ", index, "id")
+                    .status()
+                    .IsInvalid());
+    auto serialized = index.Serialize();
+    ASSERT_TRUE(converter::SchemaIndex::Deserialize(
+                    serialized.substr(0, serialized.size() - 1))
+                    .status()
+                    .IsInvalid());
+    ASSERT_TRUE(converter::SchemaIndex::Deserialize("{}").status().IsInvalid());
+
+    // fields are checked when decoded, with the path of the full decoding
+    jsonObj["schema"]["fields"][4]["type"]["name"] = "bogus";
+    text = jsonObj.dump();
+    index = converter::BuildSchemaIndex(text).ValueOrDie();
+    ASSERT_TRUE(converter::JSONTextToField(text, index, "id").ok());
+    ASSERT_EQ(converter::JSONTextToField(text, index, "other").status(),
+              converter::JSONToSchema(jsonObj).status());
+
+    for (const auto& malformed : { std::string{ "" },
+                                   std::string{ "{\"schema\": {}}" },
+                                   std::string{ "{\"schema\": {\"fields\": [" },
+                                   std::string{ "{\"a\": \"b}" },
+                                   std::string{ "[]]" } }) {
+        ASSERT_TRUE(
+            converter::BuildSchemaIndex(malformed).status().IsInvalid())
+            << malformed;
+    }
+}